@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Constants.h"
+#include "Order.h"
+#include "Side.h"
+#include "Usings.h"
+
+/**
+ * @brief What the book does when an order would trade with another order of the same account.
+ *
+ * - CancelResting: cancel the resting order and keep matching the aggressor.
+ * - CancelAggressor: cancel what is left of the incoming order.
+ * - DecrementBoth: take the smaller remaining quantity off both orders without
+ *   trading it; whichever reaches zero is cancelled.
+ */
+enum class SelfTradePrevention : std::uint8_t {
+    CancelResting,
+    CancelAggressor,
+    DecrementBoth,
+};
+
+/**
+ * @brief Pre-trade limits of one account and how its self-trades are resolved.
+ */
+struct AccountLimits
+{
+    /** Largest absolute net position the account may reach if all its working orders on one side fill. */
+    std::int64_t maxPosition_{ std::numeric_limits<std::int64_t>::max() };
+    /** Largest price * quantity the account may have working across both sides. */
+    std::int64_t maxNotional_{ std::numeric_limits<std::int64_t>::max() };
+    SelfTradePrevention selfTradePrevention_{ SelfTradePrevention::CancelResting };
+};
+
+/**
+ * @brief Running totals of one account, kept as its orders rest, fill and leave the book.
+ */
+struct AccountExposure
+{
+    std::int64_t position_{ };     // Net filled quantity since the account was tracked, buys positive
+    std::int64_t openBuy_{ };      // Open quantity of resting buy orders, iceberg reserves included
+    std::int64_t openSell_{ };     // Open quantity of resting sell orders, iceberg reserves included
+    std::int64_t openNotional_{ }; // Sum of |price| * open quantity of resting orders
+
+    friend bool operator== (const AccountExposure&, const AccountExposure&) = default;
+};
+
+/**
+ * @brief Dense per-account limits and exposure of one book.
+ *
+ * AccountId is a small integer, so accounts index a flat array directly: the
+ * pre-trade check and every update are a bounds compare and a few adds on a
+ * 64-byte entry, with no hashing. Accounts at or beyond the table's size are
+ * neither limited nor tracked, so a book with no limits set pays one compare
+ * per event. Constants::NoAccount never has limits.
+ *
+ * Not thread-safe; the owning book calls it under its lock.
+ */
+class AccountRisk {
+    public:
+        /** @return True if no account is tracked yet. */
+        bool Empty () const { return accounts_.empty(); }
+
+        /** @return Number of account ids the table covers (ids below it are tracked). */
+        std::size_t Size () const { return accounts_.size(); }
+
+        /**
+         * @brief Covers ids up to account, with default (unlimited) limits for the new ones.
+         * @return The first id the table did not cover before; the caller seeds their exposure.
+         */
+        std::size_t Cover (AccountId account) {
+            const std::size_t previous = accounts_.size();
+            if (account >= previous)
+                accounts_.resize(std::size_t{ account } + 1);
+            return previous;
+        }
+
+        /** @brief Replaces the limits of a covered account. */
+        void SetLimits (AccountId account, const AccountLimits& limits) { accounts_[account].limits_ = limits; }
+
+        /** @return Limits of account (defaults if it is not covered). */
+        AccountLimits Limits (AccountId account) const {
+            return account < accounts_.size() ? accounts_[account].limits_ : AccountLimits{ };
+        }
+
+        /** @return Exposure of account (zero if it is not covered). */
+        AccountExposure Exposure (AccountId account) const {
+            return account < accounts_.size() ? accounts_[account].exposure_ : AccountExposure{ };
+        }
+
+        /** @brief Sets the position of a covered account, e.g. from a snapshot. */
+        void RestorePosition (AccountId account, std::int64_t position) { accounts_[account].exposure_.position_ = position; }
+
+        /** @brief Invokes function(account, limits, exposure) for every covered account, lowest id first. */
+        template <typename Function>
+        void ForEach (Function&& function) const {
+            for (std::size_t account = 0; account < accounts_.size(); ++account)
+                function(static_cast<AccountId>(account), accounts_[account].limits_, accounts_[account].exposure_);
+        }
+
+        /** @return How self-trades of account are resolved. */
+        SelfTradePrevention SelfTradePreventionOf (AccountId account) const { return Limits(account).selfTradePrevention_; }
+
+        /**
+         * @brief Pre-trade check: would resting order, on top of the account's
+         *        working orders, stay within its position and notional limits.
+         */
+        template <Side S>
+        bool Allows (const Order& order) const {
+            if (order.GetAccount() >= accounts_.size())
+                return true;
+
+            const auto& account = accounts_[order.GetAccount()];
+            return Within<S>(account.limits_, account.exposure_, order);
+        }
+
+        /**
+         * @brief Pre-trade check of an order that replaces one of the same
+         *        account, as if replaced had already left the book.
+         */
+        template <Side S>
+        bool Allows (const Order& order, const Order& replaced) const {
+            if (order.GetAccount() >= accounts_.size())
+                return true;
+
+            const auto& account = accounts_[order.GetAccount()];
+            AccountExposure exposure = account.exposure_;
+            Open(exposure, replaced, -std::int64_t{ replaced.GetOpenQuantity() });
+            return Within<S>(account.limits_, exposure, order);
+        }
+
+        /** @brief An order came to rest (an iceberg counts with its hidden reserve). */
+        void OnAdded (const Order& order) {
+            if (order.GetAccount() < accounts_.size())
+                Open(accounts_[order.GetAccount()].exposure_, order, order.GetOpenQuantity());
+        }
+
+        /** @brief quantity of a resting order left the book without trading (cancel, amend down). */
+        void OnRemoved (const Order& order, Quantity quantity) {
+            if (order.GetAccount() < accounts_.size())
+                Open(accounts_[order.GetAccount()].exposure_, order, -std::int64_t{ quantity });
+        }
+
+        /** @brief quantity of an order traded. */
+        void OnFilled (const Order& order, Quantity quantity) {
+            if (order.GetAccount() >= accounts_.size())
+                return;
+
+            auto& exposure = accounts_[order.GetAccount()].exposure_;
+            Open(exposure, order, -std::int64_t{ quantity });
+            exposure.position_ += order.GetSide() == Side::Buy ? std::int64_t{ quantity } : -std::int64_t{ quantity };
+        }
+
+    private:
+        template <Side S>
+        static bool Within (const AccountLimits& limits, const AccountExposure& exposure, const Order& order) {
+            const std::int64_t quantity = order.GetOpenQuantity();
+            const std::int64_t worstPosition = S == Side::Buy
+                ? exposure.position_ + exposure.openBuy_ + quantity
+                : exposure.openSell_ + quantity - exposure.position_;
+
+            return worstPosition <= limits.maxPosition_
+                && exposure.openNotional_ + Notional(order.GetPrice(), quantity) <= limits.maxNotional_;
+        }
+
+        static std::int64_t Notional (Price price, std::int64_t quantity) {
+            return (price < 0 ? -std::int64_t{ price } : std::int64_t{ price }) * quantity;
+        }
+
+        static void Open (AccountExposure& exposure, const Order& order, std::int64_t quantity) {
+            (order.GetSide() == Side::Buy ? exposure.openBuy_ : exposure.openSell_) += quantity;
+            exposure.openNotional_ += Notional(order.GetPrice(), quantity);
+        }
+
+        struct alignas(Constants::CacheLineSize) Account {
+            AccountLimits limits_;
+            AccountExposure exposure_;
+        };
+
+        std::vector<Account> accounts_;
+};
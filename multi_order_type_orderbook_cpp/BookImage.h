@@ -0,0 +1,180 @@
+#pragma once
+
+/**
+ * @file BookImage.h
+ * @brief Flat image of a pool-backed book that a new book adopts by mapping it.
+ *
+ * The pool's slots already link FIFOs and the free list by index, so the
+ * slab is position independent: an image is the slab verbatim plus one
+ * record per price level (its FIFO ends and LevelData aggregates). Adopting
+ * it copies the slab in bulk and reinserts levels, not orders, and nothing
+ * is matched again (see BasicOrderbook::WriteImage / AdoptImage).
+ *
+ * Layout. Native byte order and struct layout: the image is meant to be
+ * reloaded by the same build on the same host, and the header records both
+ * so a mismatch is rejected instead of misread. A CRC-32 over the header
+ * (crc_ zeroed) and everything after it rejects a torn or corrupt image
+ * before any of it is trusted.
+ *   0                       BookImageHeader
+ *   SlotsOffset             slotCount_ OrderPool::Slot (free slots included)
+ *   LevelsOffset(slots)     bidLevelCount_ then askLevelCount_ BookImageLevel, best first
+ *   AccountsOffset(header)  accountCount_ BookImageAccount, lowest id first
+ *   ExpiriesOffset(header)  expiringCount_ OrderId in expiry order, the first
+ *                           sealedCount_ of them sealed (see ExpiryIndex::ForEach)
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "AccountRisk.h"
+#include "Crc32.h"
+#include "MappedFile.h"
+#include "OrderPool.h"
+
+struct BookImageHeader
+{
+    static constexpr std::string_view Magic{ "OBBOOKI3" };
+    static constexpr std::uint32_t ByteOrderMark = 0x01020304;
+
+    char magic_[8];
+    std::uint32_t byteOrder_;
+    std::uint32_t slotSize_;
+    std::uint32_t levelSize_;
+    OrderSlot freeHead_;
+    std::uint64_t slotCount_;
+    std::uint64_t orderCount_;
+    std::uint64_t bidLevelCount_;
+    std::uint64_t askLevelCount_;
+    std::uint64_t sequence_;            // Caller's journal sequence at the time of the image
+    std::uint64_t levelUpdateSequence_; // So level-update sequences continue after adoption
+    Price lastTradePrice_;              // So stops added after adoption trigger against it
+    std::uint32_t hasLastTradePrice_;
+    std::uint64_t accountCount_;
+    std::uint32_t accountSize_;
+    std::uint64_t expiringCount_;
+    std::uint64_t sealedCount_;         // Good‑For‑Day orders of an expiry in progress
+    std::uint32_t crc_;                 // See Checksum
+};
+
+/**
+ * @brief One price level: where its FIFO starts and ends in the slab, and its aggregates.
+ */
+struct BookImageLevel
+{
+    Price price_;
+    OrderSlot head_;
+    OrderSlot tail_;
+    Quantity quantity_;
+    Quantity count_;
+    Quantity hidden_;
+};
+
+/**
+ * @brief Limits, self-trade prevention mode and position of one account.
+ */
+struct BookImageAccount
+{
+    std::int64_t maxPosition_;
+    std::int64_t maxNotional_;
+    std::int64_t position_;
+    AccountId account_;
+    SelfTradePrevention selfTradePrevention_;
+    std::uint8_t reserved_[5];
+};
+
+struct BookImage
+{
+    static_assert(std::is_trivially_copyable_v<OrderPool::Slot>, "Slots are imaged verbatim");
+    static_assert(std::is_trivially_copyable_v<BookImageLevel>);
+    static_assert(std::is_trivially_copyable_v<BookImageAccount>);
+    static_assert(sizeof(BookImageLevel) % alignof(BookImageAccount) == 0);
+    static_assert(sizeof(BookImageAccount) % alignof(OrderId) == 0);
+    static_assert(sizeof(OrderPool::Slot) % alignof(BookImageLevel) == 0);
+
+    /** @brief Slots start on a cache line (mappings are page aligned). */
+    static constexpr std::size_t SlotsOffset = (sizeof(BookImageHeader) + 63) / 64 * 64;
+
+    static constexpr std::size_t LevelsOffset(std::uint64_t slotCount)
+    {
+        return SlotsOffset + slotCount * sizeof(OrderPool::Slot);
+    }
+
+    static constexpr std::size_t AccountsOffset(const BookImageHeader& header)
+    {
+        return LevelsOffset(header.slotCount_) + (header.bidLevelCount_ + header.askLevelCount_) * sizeof(BookImageLevel);
+    }
+
+    static constexpr std::size_t ExpiriesOffset(const BookImageHeader& header)
+    {
+        return AccountsOffset(header) + header.accountCount_ * sizeof(BookImageAccount);
+    }
+
+    /** @return Zero bytes between the header and the slots. */
+    static std::span<const unsigned char> Padding()
+    {
+        static constexpr std::array<unsigned char, SlotsOffset - sizeof(BookImageHeader)> padding{ };
+        return padding;
+    }
+
+    template <typename T>
+    static std::span<const unsigned char> Bytes(std::span<const T> values)
+    {
+        return { reinterpret_cast<const unsigned char*>(values.data()), values.size_bytes() };
+    }
+
+    /**
+     * @return CRC-32 of an image made of parts, the header first with its
+     *         crc_ zeroed (the writer zero-fills the header, padding included).
+     */
+    static std::uint32_t Checksum(std::span<const std::span<const unsigned char>> parts)
+    {
+        std::uint32_t crc = 0;
+        for (const auto& part : parts)
+            crc = Crc32::Compute(part.data(), part.size(), crc);
+        return crc;
+    }
+
+    /**
+     * @brief Checks the header of a mapped image and the file size it implies.
+     * @throws std::runtime_error if the file is not an image of this layout.
+     */
+    static BookImageHeader ReadHeader(const MappedFile& file, const std::string& path)
+    {
+        BookImageHeader header;
+        if (file.Size() < SlotsOffset)
+            throw std::runtime_error("Not a book image: " + path);
+
+        std::memcpy(&header, file.Data(), sizeof(header));
+        if (std::string_view{ header.magic_, sizeof(header.magic_) } != BookImageHeader::Magic)
+            throw std::runtime_error("Not a book image: " + path);
+
+        if (header.byteOrder_ != BookImageHeader::ByteOrderMark || header.slotSize_ != sizeof(OrderPool::Slot)
+            || header.levelSize_ != sizeof(BookImageLevel) || header.accountSize_ != sizeof(BookImageAccount))
+            throw std::runtime_error("Book image has a different layout: " + path);
+
+        const std::uint64_t levelCount = header.bidLevelCount_ + header.askLevelCount_;
+        if (header.slotCount_ > file.Size() / sizeof(OrderPool::Slot) || levelCount > file.Size() / sizeof(BookImageLevel)
+            || header.accountCount_ > file.Size() / sizeof(BookImageAccount)
+            || header.expiringCount_ > file.Size() / sizeof(OrderId) || header.sealedCount_ > header.expiringCount_
+            || file.Size() != ExpiriesOffset(header) + header.expiringCount_ * sizeof(OrderId))
+            throw std::runtime_error("Truncated book image: " + path);
+
+        std::array<unsigned char, sizeof(BookImageHeader)> zeroed;
+        std::memcpy(zeroed.data(), file.Data(), zeroed.size());
+        std::memset(zeroed.data() + offsetof(BookImageHeader, crc_), 0, sizeof(header.crc_));
+        const std::span<const unsigned char> parts[] = {
+            zeroed,
+            { reinterpret_cast<const unsigned char*>(file.Data()) + zeroed.size(), file.Size() - zeroed.size() } };
+        if (Checksum(parts) != header.crc_)
+            throw std::runtime_error("Corrupt book image: " + path);
+
+        return header;
+    }
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <bit>
+
+#include "Usings.h"
+#include "AccountRisk.h"
+#include "Order.h"
+#include "OrderModify.h"
+
+/**
+ * @brief Kinds of instruction a book can be sent.
+ *
+ * - Add: insert a new order (orderType_, orderId_, side_, price_, quantity_).
+ * - Cancel: cancel orderId_.
+ * - Modify: replace orderId_ with side_, price_, quantity_ (keeps its order type).
+ * - PruneGoodForDay: cancel resting Good‑For‑Day orders; quantity_ limits how
+ *   many (0: all of them), so a large expiry can run in slices (see ExpiryIndex).
+ * - ExpireGoodTillDate: cancel Good‑Till‑Date orders whose expiry is at or
+ *   before expiry_; quantity_ limits how many (0: all of them).
+ * - SetAccountLimits: set the limits of account_: maximum position in
+ *   orderId_ and maximum notional in expiry_ (both as two's complement bits),
+ *   SelfTradePrevention in quantity_. Journaled like any other command, so
+ *   replay sees the limits every order was checked against.
+ */
+enum class CommandType
+{
+    Add,
+    Cancel,
+    Modify,
+    PruneGoodForDay,
+    ExpireGoodTillDate,
+    SetAccountLimits,
+};
+
+/**
+ * @brief One instruction for a book, as a flat trivially-copyable value.
+ *
+ * Commands are what travels through the engine's ring buffers, so they carry
+ * plain fields rather than an OrderPointer. Fields unused by a type are ignored.
+ * instrumentId_ selects the book in multi-book engines (single books ignore it);
+ * account_ is the owner of an added order.
+ */
+struct Command
+{
+    CommandType type_{ CommandType::Cancel };
+    OrderType orderType_{ OrderType::GoodTillCancel };
+    Side side_{ Side::Buy };
+    Price price_{ };
+    Quantity quantity_{ };
+    OrderId orderId_{ };
+    InstrumentId instrumentId_{ };
+    AccountId account_{ Constants::NoAccount };
+    Expiry expiry_{ Constants::NoExpiry };
+
+    /** @brief Builds an Add command for the given order. */
+    static Command Add(const Order& order, InstrumentId instrumentId = { })
+    {
+        return Command{ CommandType::Add, order.GetOrderType(), order.GetSide(),
+            order.GetPrice(), order.GetInitialQuantity(), order.GetOrderId(), instrumentId, order.GetAccount(), order.GetExpiry() };
+    }
+
+    /** @brief Builds a Cancel command for the given order id. */
+    static Command Cancel(OrderId orderId, InstrumentId instrumentId = { })
+    {
+        return Command{ CommandType::Cancel, OrderType::GoodTillCancel, Side::Buy, Price{ }, Quantity{ }, orderId, instrumentId };
+    }
+
+    /** @brief Builds a Modify command from a modification request. */
+    static Command Modify(const OrderModify& modify, InstrumentId instrumentId = { })
+    {
+        return Command{ CommandType::Modify, OrderType::GoodTillCancel, modify.GetSide(),
+            modify.GetPrice(), modify.GetQuantity(), modify.GetOrderId(), instrumentId };
+    }
+
+    /** @brief Builds a command that expires at most limit Good‑For‑Day orders (0: all of them). */
+    static Command PruneGoodForDay(InstrumentId instrumentId = { }, Quantity limit = { })
+    {
+        return Command{ CommandType::PruneGoodForDay, OrderType::GoodTillCancel, Side::Buy, Price{ }, limit, OrderId{ }, instrumentId };
+    }
+
+    /** @brief Builds a command that expires at most limit (0: all) Good‑Till‑Date orders due by now. */
+    static Command ExpireGoodTillDate(Expiry now, InstrumentId instrumentId = { }, Quantity limit = { })
+    {
+        return Command{ CommandType::ExpireGoodTillDate, OrderType::GoodTillCancel, Side::Buy, Price{ }, limit, OrderId{ }, instrumentId, Constants::NoAccount, now };
+    }
+
+    /** @brief Builds a command that sets the limits and self-trade prevention mode of account. */
+    static Command SetAccountLimits(AccountId account, const AccountLimits& limits, InstrumentId instrumentId = { })
+    {
+        return Command{ CommandType::SetAccountLimits, OrderType::GoodTillCancel, Side::Buy, Price{ },
+            static_cast<Quantity>(limits.selfTradePrevention_), std::bit_cast<OrderId>(limits.maxPosition_), instrumentId, account,
+            std::bit_cast<Expiry>(limits.maxNotional_) };
+    }
+
+    /** @return The order described by an Add command. */
+    Order ToOrder() const { return Order{ orderType_, orderId_, side_, price_, quantity_, expiry_, account_ }; }
+
+    /** @return The modification described by a Modify command. */
+    OrderModify ToOrderModify() const { return OrderModify{ orderId_, side_, price_, quantity_ }; }
+
+    /** @return The limits described by a SetAccountLimits command. */
+    AccountLimits ToAccountLimits() const
+    {
+        return AccountLimits{ std::bit_cast<std::int64_t>(orderId_), std::bit_cast<std::int64_t>(expiry_),
+            static_cast<SelfTradePrevention>(quantity_) };
+    }
+};
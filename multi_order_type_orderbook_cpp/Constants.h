@@ -1,12 +1,17 @@
 #pragma once
 
 #include <limits>
+#include <cstddef>
 
 #include "Usings.h"
 
-// Common constants, including an invalid price sentinel (NaN).
+// Common constants, including an invalid price sentinel (NaN) and the cache line
+// size used to keep independently written fields apart.
 
 struct Constants
 {
     static const Price InvalidPrice = std::numeric_limits<Price>::quiet_NaN();
+    static constexpr std::size_t CacheLineSize = 64;
+    static constexpr Expiry NoExpiry = 0;
+    static constexpr AccountId NoAccount = 0; // Orders without an owner: never self-trade-checked or limited
 };
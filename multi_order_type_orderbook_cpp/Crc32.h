@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected, as used by zlib) for detecting torn or corrupt records.
+ */
+struct Crc32
+{
+    /**
+     * @param bytes Data to checksum.
+     * @param size Number of bytes.
+     * @param crc Result of a previous call, to checksum data in pieces.
+     */
+    static std::uint32_t Compute(const unsigned char* bytes, std::size_t size, std::uint32_t crc = 0)
+    {
+        crc = ~crc;
+        for (std::size_t index = 0; index < size; ++index)
+            crc = Table[(crc ^ bytes[index]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+private:
+    static constexpr std::array<std::uint32_t, 256> Table = []
+    {
+        std::array<std::uint32_t, 256> table{ };
+        for (std::uint32_t value = 0; value < 256; ++value)
+        {
+            std::uint32_t crc = value;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) != 0 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            table[value] = crc;
+        }
+        return table;
+    }();
+};
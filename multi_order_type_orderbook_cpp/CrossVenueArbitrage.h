@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "Command.h"
+#include "Orderbook.h"
+#include "TopOfBook.h"
+
+/**
+ * @brief A crossed pair of quotes on two venues: buying at one venue's ask
+ *        and selling at the other's bid earns edge_ per unit after fees.
+ */
+struct CrossVenueSignal
+{
+    InstrumentId instrumentId_{ };
+    VenueId buyVenue_{ };   // Venue whose ask is lifted
+    VenueId sellVenue_{ };  // Venue whose bid is hit
+    Price buyPrice_{ };
+    Price sellPrice_{ };
+    Quantity quantity_{ };  // Smaller of the two top-level quantities
+    Price edge_{ };         // Per unit, net of both venues' fees
+    std::uint64_t timestamp_{ }; // Timestamp of the update that made the cross visible
+};
+
+/**
+ * @brief Callable invoked with each signal: void(const CrossVenueSignal&).
+ */
+template <typename Sink>
+concept CrossVenueSignalSink = std::invocable<Sink&, const CrossVenueSignal&>;
+
+/**
+ * @brief Detects cross-venue crossed quotes from per-venue top-of-book changes.
+ *
+ * Venues and pairs are registered up front and referred to by the dense
+ * indices the registration returns. Each pair keeps the last top of book of
+ * every venue in a fixed array, so an update costs one pass over at most
+ * MaxVenues quotes whatever the number of pairs or the depth of the books,
+ * and never allocates.
+ *
+ * When venue V's top changes, its bid is compared against the cheapest other
+ * ask and its ask against the richest other bid, each net of the fees of
+ * both venues (a fee is a price per unit traded). At most two signals are
+ * emitted per update, one per direction; crosses between two other venues
+ * were already reported when they appeared.
+ */
+template <std::size_t MaxVenues = 8>
+class CrossVenueDetector {
+    public:
+        /**
+         * @param minimumEdge Smallest net edge per unit worth a signal.
+         */
+        explicit CrossVenueDetector (Price minimumEdge = 1)
+            : minimumEdge_ { minimumEdge }
+        { }
+
+        /**
+         * @param feePerUnit Cost of trading one unit on the venue, in price ticks.
+         * @return Dense index of the venue.
+         * @throws std::length_error if MaxVenues venues are already registered.
+         */
+        std::size_t AddVenue (VenueId venueId, Price feePerUnit) {
+            if (venueCount_ == MaxVenues)
+                throw std::length_error("CrossVenueDetector supports at most MaxVenues venues.");
+
+            venues_[venueCount_] = Venue{ venueId, feePerUnit };
+            return venueCount_++;
+        }
+
+        /** @return Dense index of the pair. */
+        std::size_t AddPair (InstrumentId instrumentId) {
+            pairs_.push_back(PairQuotes{ instrumentId, { } });
+            return pairs_.size() - 1;
+        }
+
+        /**
+         * @brief Records venue's new top of book for pair and reports any cross it creates.
+         * @param timestamp Copied into every signal, e.g. the receive time of the feed message.
+         */
+        template <CrossVenueSignalSink Sink>
+        void OnTopOfBook (std::size_t pair, std::size_t venue, const TopOfBook& top, std::uint64_t timestamp, Sink&& sink) {
+            auto& quotes = pairs_[pair];
+            quotes.venues_[venue] = top;
+
+            // Cheapest other ask and richest other bid, fees included
+            std::size_t askVenue = MaxVenues;
+            std::size_t bidVenue = MaxVenues;
+            Price askCost = std::numeric_limits<Price>::max();
+            Price bidValue = std::numeric_limits<Price>::min();
+
+            for (std::size_t other = 0; other < venueCount_; ++other)
+            {
+                if (other == venue)
+                    continue;
+
+                const TopOfBook& quote = quotes.venues_[other];
+                const Price fee = venues_[other].fee_;
+
+                if (quote.HasAsk() && quote.askPrice_ + fee < askCost)
+                {
+                    askCost = quote.askPrice_ + fee;
+                    askVenue = other;
+                }
+                if (quote.HasBid() && quote.bidPrice_ - fee > bidValue)
+                {
+                    bidValue = quote.bidPrice_ - fee;
+                    bidVenue = other;
+                }
+            }
+
+            const Price fee = venues_[venue].fee_;
+
+            if (top.HasBid() && askVenue != MaxVenues)
+            {
+                const Price edge = top.bidPrice_ - fee - askCost;
+                if (edge >= minimumEdge_)
+                {
+                    const TopOfBook& ask = quotes.venues_[askVenue];
+                    sink(CrossVenueSignal{ quotes.instrumentId_, venues_[askVenue].venueId_, venues_[venue].venueId_,
+                        ask.askPrice_, top.bidPrice_, std::min(ask.askQuantity_, top.bidQuantity_), edge, timestamp });
+                }
+            }
+
+            if (top.HasAsk() && bidVenue != MaxVenues)
+            {
+                const Price edge = bidValue - (top.askPrice_ + fee);
+                if (edge >= minimumEdge_)
+                {
+                    const TopOfBook& bid = quotes.venues_[bidVenue];
+                    sink(CrossVenueSignal{ quotes.instrumentId_, venues_[venue].venueId_, venues_[bidVenue].venueId_,
+                        top.askPrice_, bid.bidPrice_, std::min(top.askQuantity_, bid.bidQuantity_), edge, timestamp });
+                }
+            }
+        }
+
+        /** @return Last top of book recorded for venue on pair. */
+        const TopOfBook& GetTopOfBook (std::size_t pair, std::size_t venue) const { return pairs_[pair].venues_[venue]; }
+
+        std::size_t VenueCount () const { return venueCount_; }
+        std::size_t PairCount () const { return pairs_.size(); }
+
+    private:
+        struct Venue {
+            VenueId venueId_{ };
+            Price fee_{ };
+        };
+
+        struct PairQuotes {
+            InstrumentId instrumentId_{ };
+            std::array<TopOfBook, MaxVenues> venues_;
+        };
+
+        Price minimumEdge_;
+        std::array<Venue, MaxVenues> venues_{ };
+        std::size_t venueCount_{ 0 };
+        std::vector<PairQuotes> pairs_;
+};
+
+/**
+ * @brief One order-by-order book per (venue, pair) feeding a CrossVenueDetector.
+ *
+ * The owner applies each venue's market-data commands to that venue's book
+ * with Apply; after the batch the book's top of book is read in O(1) and,
+ * only if it changed, handed to the detector with the batch's timestamp.
+ * Updates below the top therefore cost a book update and one comparison.
+ *
+ * Books are SingleWriterTraits books: the monitor and everything it owns
+ * belong to one thread, so nothing on the update-to-signal path locks.
+ */
+template <typename BookTraits = LadderOrderbookTraits, std::size_t MaxVenues = 8>
+class CrossVenueMonitor {
+    public:
+        using Book = BasicOrderbook<SingleWriterTraits<BookTraits>>;
+
+        /**
+         * @param minimumEdge Smallest net edge per unit worth a signal.
+         * @param orderCapacity Orders each book reserves room for.
+         */
+        explicit CrossVenueMonitor (Price minimumEdge = 1, std::size_t orderCapacity = Book::DefaultOrderCapacity)
+            : detector_ { minimumEdge }
+            , orderCapacity_ { orderCapacity }
+        { }
+
+        /**
+         * @brief Registers a venue and creates its book for every pair registered so far.
+         * @return Dense venue index to pass to Apply.
+         * @throws std::length_error if MaxVenues venues are already registered.
+         */
+        std::size_t AddVenue (VenueId venueId, Price feePerUnit) {
+            const std::size_t venue = detector_.AddVenue(venueId, feePerUnit);
+            for (std::size_t pair = 0; pair < detector_.PairCount(); ++pair)
+                CreateBook(pair, venue);
+            return venue;
+        }
+
+        /**
+         * @brief Registers a pair and creates its book on every venue registered so far.
+         * @return Dense pair index to pass to Apply.
+         */
+        std::size_t AddPair (InstrumentId instrumentId) {
+            const std::size_t pair = detector_.AddPair(instrumentId);
+            books_.resize(books_.size() + MaxVenues);
+            for (std::size_t venue = 0; venue < detector_.VenueCount(); ++venue)
+                CreateBook(pair, venue);
+            return pair;
+        }
+
+        /**
+         * @brief Applies one venue's commands for one pair, then checks for crosses.
+         *
+         * A feed that crosses itself is matched by the book like any other
+         * flow; the resulting trades are discarded.
+         * @param timestamp Stamped on every signal this batch triggers.
+         * @throws Whatever the book throws for an invalid command (see ProcessBatch).
+         */
+        template <CrossVenueSignalSink Sink>
+        void Apply (std::size_t pair, std::size_t venue, std::span<const Command> commands, std::uint64_t timestamp, Sink&& sink) {
+            Book& book = *books_[pair * MaxVenues + venue];
+            book.ProcessBatch(commands, [](const Trade&) { });
+
+            const TopOfBook top = book.GetTopOfBook();
+            if (top != detector_.GetTopOfBook(pair, venue))
+                detector_.OnTopOfBook(pair, venue, top, timestamp, sink);
+        }
+
+        const Book& GetBook (std::size_t pair, std::size_t venue) const { return *books_[pair * MaxVenues + venue]; }
+
+        const CrossVenueDetector<MaxVenues>& GetDetector () const { return detector_; }
+
+    private:
+        void CreateBook (std::size_t pair, std::size_t venue) {
+            books_[pair * MaxVenues + venue] = std::make_unique<Book>(orderCapacity_);
+        }
+
+        CrossVenueDetector<MaxVenues> detector_;
+        std::size_t orderCapacity_;
+        std::vector<std::unique_ptr<Book>> books_; // MaxVenues slots per pair
+};
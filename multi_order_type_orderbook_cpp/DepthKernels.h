@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "LevelInfo.h"
+#include "Side.h"
+
+/**
+ * @brief What sweeping a side for some quantity costs.
+ */
+struct SweepCost
+{
+    Quantity quantity_{ };      // Quantity available, at most the quantity asked for
+    Price worstPrice_{ };       // Price of the last level touched (meaningless if quantity_ == 0)
+    std::int64_t notional_{ };  // Sum of price * quantity over the levels touched
+    bool truncated_{ };         // Fell short at the last level held, with more resting beyond it
+
+    /** @return Volume-weighted average price of the fill, 0 if nothing fills. */
+    double Vwap () const { return quantity_ == 0 ? 0.0 : static_cast<double>(notional_) / quantity_; }
+};
+
+/**
+ * @brief Depth aggregation over contiguous levels of one side, best first.
+ *
+ * A LevelInfo is 8 bytes, so one 256-bit AVX2 register (or a two-register
+ * NEON deinterleaving load) covers four levels. The kernels compare, mask
+ * and sum four levels per step and only drop to scalar code for the block
+ * where the answer lies. The vector path is chosen at compile time from the
+ * target (-mavx2, -march=native, or any AArch64 build); otherwise the scalar
+ * versions run, and they are also the reference the vector ones must match.
+ */
+struct DepthKernels
+{
+    /**
+     * @brief Quantity at the leading levels that an order of the opposite side limited at price can reach.
+     * @param levelSide Side the levels rest on: bids reach down to price, asks up to it.
+     */
+    static Quantity QuantityUpTo(std::span<const LevelInfo> levels, Side levelSide, Price price)
+    {
+#if defined(__AVX2__)
+        return Avx2QuantityUpTo(levels, levelSide, price);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        return NeonQuantityUpTo(levels, levelSide, price);
+#else
+        return ScalarQuantityUpTo(levels, levelSide, price);
+#endif
+    }
+
+    /**
+     * @brief Cost of taking quantity from the leading levels, and the price it reaches.
+     */
+    static SweepCost Sweep(std::span<const LevelInfo> levels, Quantity quantity)
+    {
+#if defined(__AVX2__)
+        return Avx2Sweep(levels, quantity);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        return NeonSweep(levels, quantity);
+#else
+        return ScalarSweep(levels, quantity);
+#endif
+    }
+
+    static Quantity ScalarQuantityUpTo(std::span<const LevelInfo> levels, Side levelSide, Price price, std::size_t from = 0, std::uint64_t total = 0)
+    {
+        for (std::size_t index = from; index < levels.size() && Reaches(levelSide, levels[index].price_, price); ++index)
+            total += levels[index].quantity_;
+        return Saturate(total);
+    }
+
+    static SweepCost ScalarSweep(std::span<const LevelInfo> levels, Quantity quantity, std::size_t from = 0, SweepCost cost = { })
+    {
+        for (std::size_t index = from; index < levels.size() && cost.quantity_ < quantity; ++index)
+        {
+            const Quantity taken = std::min(levels[index].quantity_, quantity - cost.quantity_);
+            cost.quantity_ += taken;
+            cost.notional_ += std::int64_t{ levels[index].price_ } * taken;
+            cost.worstPrice_ = levels[index].price_;
+        }
+        return cost;
+    }
+
+private:
+    static_assert(sizeof(LevelInfo) == 8 && offsetof(LevelInfo, price_) == 0 && offsetof(LevelInfo, quantity_) == 4,
+        "The vector kernels load LevelInfo as (price, quantity) pairs of 32-bit lanes");
+
+    static bool Reaches(Side levelSide, Price levelPrice, Price price)
+    {
+        return levelSide == Side::Buy ? levelPrice >= price : levelPrice <= price;
+    }
+
+    static Quantity Saturate(std::uint64_t total)
+    {
+        constexpr std::uint64_t Largest = std::numeric_limits<Quantity>::max();
+        return static_cast<Quantity>(std::min(total, Largest));
+    }
+
+#if defined(__AVX2__)
+    static std::uint64_t Sum64(__m256i lanes)
+    {
+        const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+        return static_cast<std::uint64_t>(_mm_cvtsi128_si64(half)) + static_cast<std::uint64_t>(_mm_extract_epi64(half, 1));
+    }
+
+    static Quantity Avx2QuantityUpTo(std::span<const LevelInfo> levels, Side levelSide, Price price)
+    {
+        const __m256i bound = _mm256_set1_epi32(price);
+        __m256i total = _mm256_setzero_si256();
+        std::size_t index = 0;
+
+        for (; index + 4 <= levels.size(); index += 4)
+        {
+            // Each 64-bit lane is one level: price in the low half, quantity in the high half
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(levels.data() + index));
+            const __m256i beyond32 = levelSide == Side::Buy ? _mm256_cmpgt_epi32(bound, block) : _mm256_cmpgt_epi32(block, bound);
+            const __m256i beyond = _mm256_shuffle_epi32(beyond32, _MM_SHUFFLE(2, 2, 0, 0));
+            total = _mm256_add_epi64(total, _mm256_andnot_si256(beyond, _mm256_srli_epi64(block, 32)));
+
+            // Levels are best first, so the first level out of reach ends the prefix
+            if (!_mm256_testz_si256(beyond, beyond))
+                return Saturate(Sum64(total));
+        }
+
+        return ScalarQuantityUpTo(levels, levelSide, price, index, Sum64(total));
+    }
+
+    static SweepCost Avx2Sweep(std::span<const LevelInfo> levels, Quantity quantity)
+    {
+        __m256i notional = _mm256_setzero_si256();
+        std::uint64_t filled = 0;
+        std::size_t index = 0;
+
+        for (; index + 4 <= levels.size(); index += 4)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(levels.data() + index));
+
+            // _mm256_mul_epi32 multiplies signed lanes; leave quantities of 2^31 and more to the scalar path
+            if ((_mm256_movemask_ps(_mm256_castsi256_ps(block)) & 0xAA) != 0)
+                break;
+
+            const __m256i quantities = _mm256_srli_epi64(block, 32);
+            const std::uint64_t blockQuantity = Sum64(quantities);
+            if (filled + blockQuantity >= quantity)
+                break;
+
+            filled += blockQuantity;
+            notional = _mm256_add_epi64(notional, _mm256_mul_epi32(block, quantities));
+        }
+
+        SweepCost cost{ static_cast<Quantity>(filled), index == 0 ? Price{ } : levels[index - 1].price_,
+            static_cast<std::int64_t>(Sum64(notional)) };
+        return ScalarSweep(levels, quantity, index, cost);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static Quantity NeonQuantityUpTo(std::span<const LevelInfo> levels, Side levelSide, Price price)
+    {
+        const int32x4_t bound = vdupq_n_s32(price);
+        uint64x2_t total = vdupq_n_u64(0);
+        std::size_t index = 0;
+
+        for (; index + 4 <= levels.size(); index += 4)
+        {
+            // val[0] holds the four prices, val[1] the four quantities
+            const uint32x4x2_t block = vld2q_u32(reinterpret_cast<const std::uint32_t*>(levels.data() + index));
+            const int32x4_t prices = vreinterpretq_s32_u32(block.val[0]);
+            const uint32x4_t reach = levelSide == Side::Buy ? vcgeq_s32(prices, bound) : vcleq_s32(prices, bound);
+            total = vpadalq_u32(total, vandq_u32(block.val[1], reach));
+
+            if (vminvq_u32(reach) == 0)
+                return Saturate(vaddvq_u64(total));
+        }
+
+        return ScalarQuantityUpTo(levels, levelSide, price, index, vaddvq_u64(total));
+    }
+
+    static SweepCost NeonSweep(std::span<const LevelInfo> levels, Quantity quantity)
+    {
+        int64x2_t notional = vdupq_n_s64(0);
+        std::uint64_t filled = 0;
+        std::size_t index = 0;
+
+        for (; index + 4 <= levels.size(); index += 4)
+        {
+            const uint32x4x2_t block = vld2q_u32(reinterpret_cast<const std::uint32_t*>(levels.data() + index));
+
+            // vmull_s32 multiplies signed lanes; leave quantities of 2^31 and more to the scalar path
+            if (vmaxvq_u32(block.val[1]) >= 0x80000000u)
+                break;
+
+            const std::uint64_t blockQuantity = vaddlvq_u32(block.val[1]);
+            if (filled + blockQuantity >= quantity)
+                break;
+
+            const int32x4_t prices = vreinterpretq_s32_u32(block.val[0]);
+            const int32x4_t quantities = vreinterpretq_s32_u32(block.val[1]);
+            filled += blockQuantity;
+            notional = vaddq_s64(notional, vmull_s32(vget_low_s32(prices), vget_low_s32(quantities)));
+            notional = vaddq_s64(notional, vmull_high_s32(prices, quantities));
+        }
+
+        SweepCost cost{ static_cast<Quantity>(filled), index == 0 ? Price{ } : levels[index - 1].price_, vaddvq_s64(notional) };
+        return ScalarSweep(levels, quantity, index, cost);
+    }
+#endif
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include "DepthKernels.h"
+#include "LevelInfo.h"
+#include "Side.h"
+
+/**
+ * @brief Fixed-size top-of-book depth: the best Depth levels of each side.
+ *
+ * Built from the books' per-level running quantities, so producing one costs
+ * O(Depth) regardless of how many orders rest at each level. Trivially
+ * copyable, so it can be published through a SeqLock.
+ */
+template <std::size_t Depth>
+struct DepthSnapshot
+{
+    std::array<LevelInfo, Depth> bids_{ }; // Highest price first
+    std::array<LevelInfo, Depth> asks_{ }; // Lowest price first
+    std::size_t bidCount_{ };              // Valid entries in bids_
+    std::size_t askCount_{ };              // Valid entries in asks_
+    bool bidsTruncated_{ };                // More bids rest than bids_ holds
+    bool asksTruncated_{ };
+
+    /** @return Valid levels of side, best first. */
+    std::span<const LevelInfo> Levels (Side side) const {
+        return side == Side::Buy ? std::span<const LevelInfo>{ bids_.data(), bidCount_ } : std::span<const LevelInfo>{ asks_.data(), askCount_ };
+    }
+
+    /** @return True if side has levels beyond the ones held here. */
+    bool Truncated (Side side) const { return side == Side::Buy ? bidsTruncated_ : asksTruncated_; }
+
+    /**
+     * @brief Quantity within these levels that an order of side limited at price could trade with.
+     */
+    Quantity QuantityUpTo (Side side, Price price) const {
+        const Side opposite = side == Side::Buy ? Side::Sell : Side::Buy;
+        return DepthKernels::QuantityUpTo(Levels(opposite), opposite, price);
+    }
+
+    /**
+     * @brief What an order of side for quantity would pay or receive sweeping these levels.
+     *        A result short of quantity means the depth does not hold enough;
+     *        it is marked truncated_ if the side has levels past these.
+     */
+    SweepCost Sweep (Side side, Quantity quantity) const {
+        const Side opposite = side == Side::Buy ? Side::Sell : Side::Buy;
+        SweepCost cost = DepthKernels::Sweep(Levels(opposite), quantity);
+        cost.truncated_ = cost.quantity_ < quantity && Truncated(opposite);
+        return cost;
+    }
+};
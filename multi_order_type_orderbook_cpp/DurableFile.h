@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <initializer_list>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Durably replaces the file at path with the concatenation of parts.
+ *
+ * Writes a temporary file, syncs it and renames it over path, so a crash
+ * leaves either the previous file or the new one, never a mix.
+ * @throws std::runtime_error on any I/O failure.
+ */
+inline void WriteFileDurably(const std::string& path, std::span<const std::span<const unsigned char>> parts)
+{
+    const std::string temporary = path + ".tmp";
+
+#ifdef _WIN32
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+        throw std::runtime_error("Cannot create " + temporary);
+
+    bool written = true;
+    for (const auto& part : parts)
+        written = written && std::fwrite(part.data(), 1, part.size(), file) == part.size();
+    written = written && std::fflush(file) == 0 && _commit(_fileno(file)) == 0;
+    std::fclose(file);
+#else
+    const int file = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0)
+        throw std::runtime_error("Cannot create " + temporary);
+
+    bool written = true;
+    for (const auto& part : parts)
+    {
+        for (std::size_t offset = 0; written && offset < part.size(); )
+        {
+            const auto count = ::write(file, part.data() + offset, part.size() - offset);
+            written = count > 0;
+            offset += written ? static_cast<std::size_t>(count) : 0;
+        }
+    }
+    written = written && fsync(file) == 0;
+    close(file);
+#endif
+    if (!written)
+        throw std::runtime_error("Cannot write " + temporary);
+
+    std::filesystem::rename(temporary, path);
+
+#ifndef _WIN32
+    // Make the rename itself durable
+    const auto directory = std::filesystem::absolute(path).parent_path();
+    const int handle = open(directory.c_str(), O_RDONLY);
+    if (handle >= 0)
+    {
+        fsync(handle);
+        close(handle);
+    }
+#endif
+}
+
+/** @brief WriteFileDurably for a braced list of parts. */
+inline void WriteFileDurably(const std::string& path, std::initializer_list<std::span<const unsigned char>> parts)
+{
+    WriteFileDurably(path, std::span<const std::span<const unsigned char>>{ parts.begin(), parts.size() });
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <map>
+
+#include "Order.h"
+#include "OrderIndex.h"
+
+/**
+ * @return Time point as an Expiry (nanoseconds since the Unix epoch).
+ */
+inline Expiry ToExpiry(std::chrono::system_clock::time_point time)
+{
+    using namespace std::chrono;
+    return static_cast<Expiry>(duration_cast<nanoseconds>(time.time_since_epoch()).count());
+}
+
+/**
+ * @return Expiry as a system clock time point.
+ */
+inline std::chrono::system_clock::time_point FromExpiry(Expiry expiry)
+{
+    using namespace std::chrono;
+    return system_clock::time_point{ duration_cast<system_clock::duration>(nanoseconds{ expiry }) };
+}
+
+/**
+ * @brief Resting orders that expire, grouped by when, so expiry touches only them.
+ *
+ * Good‑For‑Day orders sit in the current day's list. Starting a prune seals
+ * that list (new Good‑For‑Day orders go to a fresh one) and the book then
+ * pops sealed orders in slices of its choosing, so an expiry of any size
+ * never holds the lock for long and orders arriving meanwhile are not caught
+ * by it. Good‑Till‑Date orders sit in one list per expiry time, earliest first.
+ *
+ * The lists are intrusive and keyed by order id: each expiring order has one
+ * link (its neighbours and its list) in a flat index, so adding, cancelling
+ * and filling an expiring order are O(1) and orders that never expire cost
+ * nothing. Within a list, orders pop oldest first.
+ */
+class ExpiryIndex {
+    public:
+        /** @return True for order types the index tracks. */
+        static constexpr bool Expires (OrderType orderType) {
+            return orderType == OrderType::GoodForDay || orderType == OrderType::GoodTillDate;
+        }
+
+        /**
+         * @brief Tracks a resting order; does nothing for types that do not expire.
+         */
+        void Add (const Order& order) {
+            if (order.GetOrderType() == OrderType::GoodForDay)
+                PushBack(goodForDay_[current_], order.GetOrderId());
+            else if (order.GetOrderType() == OrderType::GoodTillDate)
+            {
+                auto& list = goodTillDate_[order.GetExpiry()];
+                list.expiry_ = order.GetExpiry();
+                PushBack(list, order.GetOrderId());
+            }
+        }
+
+        /**
+         * @brief Stops tracking an order that left the book (cancelled or filled).
+         */
+        void Remove (const Order& order) {
+            if (!Expires(order.GetOrderType()))
+                return;
+
+            Link link;
+            if (links_.Extract(order.GetOrderId(), link))
+                Unlink(order.GetOrderId(), link);
+        }
+
+        /** @return True while a sealed Good‑For‑Day list still holds orders. */
+        bool IsExpiringGoodForDay () const { return goodForDay_[current_ ^ 1].count_ != 0; }
+
+        /**
+         * @brief Starts a Good‑For‑Day expiry: the current list becomes the
+         *        one PopGoodForDay drains. Only call when IsExpiringGoodForDay() is false.
+         */
+        void SealGoodForDay () { current_ ^= 1; }
+
+        /**
+         * @brief Takes the oldest order of the sealed Good‑For‑Day list.
+         * @return False if the sealed list is empty.
+         */
+        bool PopGoodForDay (OrderId& orderId) { return PopFront(goodForDay_[current_ ^ 1], orderId); }
+
+        /** @return Earliest Good‑Till‑Date expiry, or Constants::NoExpiry if none rests. */
+        Expiry NextExpiry () const {
+            return goodTillDate_.empty() ? Constants::NoExpiry : goodTillDate_.begin()->first;
+        }
+
+        /**
+         * @brief Takes the oldest order of the earliest Good‑Till‑Date list due by now.
+         * @return False if no order expires at or before now.
+         */
+        bool PopExpired (Expiry now, OrderId& orderId) {
+            if (goodTillDate_.empty() || goodTillDate_.begin()->first > now)
+                return false;
+
+            return PopFront(goodTillDate_.begin()->second, orderId);
+        }
+
+        /**
+         * @brief Moves a tracked order to the back of its list, or of the sealed
+         *        Good‑For‑Day list if sealed. Requeuing every order in the order
+         *        ForEach visited them rebuilds the lists, expiry in progress included.
+         */
+        void Requeue (const Order& order, bool sealed) {
+            Remove(order);
+            if (sealed)
+                PushBack(goodForDay_[current_ ^ 1], order.GetOrderId());
+            else
+                Add(order);
+        }
+
+        /**
+         * @brief Invokes function(orderId, sealed) for each tracked order: the
+         *        sealed Good‑For‑Day list, the current one, then the Good‑Till‑Date
+         *        lists earliest first, each oldest first.
+         */
+        template <typename Function>
+        void ForEach (Function&& function) const {
+            Visit(goodForDay_[current_ ^ 1], true, function);
+            Visit(goodForDay_[current_], false, function);
+            for (const auto& [expiry, list] : goodTillDate_)
+                Visit(list, false, function);
+        }
+
+        /** @return Number of orders tracked. */
+        std::size_t Size () const { return links_.Size(); }
+
+        /** @brief Visits the link index (see MemoryPlacement.h). */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&& function) const { links_.ForEachMemoryRegion(function); }
+
+    private:
+        struct List {
+            OrderId head_{ };
+            OrderId tail_{ };
+            std::size_t count_{ 0 };
+            Expiry expiry_{ Constants::NoExpiry }; // Key of a Good‑Till‑Date list
+        };
+
+        /**
+         * @brief An order's place in its list. Nodes and the two day lists never
+         *        move, so the list pointer stays valid while the order rests.
+         */
+        struct Link {
+            OrderId prev_{ };
+            OrderId next_{ };
+            List* list_{ nullptr };
+        };
+
+        void PushBack (List& list, OrderId orderId) {
+            if (list.count_ == 0)
+                list.head_ = orderId;
+            else
+                links_.Find(list.tail_)->next_ = orderId;
+
+            links_.Insert(orderId, Link{ list.tail_, OrderId{ }, &list });
+            list.tail_ = orderId;
+            ++list.count_;
+        }
+
+        template <typename Function>
+        void Visit (const List& list, bool sealed, Function& function) const {
+            OrderId orderId = list.head_;
+            for (std::size_t index = 0; index < list.count_; ++index)
+            {
+                function(orderId, sealed);
+                if (index + 1 < list.count_)
+                    orderId = links_.Find(orderId)->next_;
+            }
+        }
+
+        bool PopFront (List& list, OrderId& orderId) {
+            if (list.count_ == 0)
+                return false;
+
+            orderId = list.head_;
+            Link link;
+            links_.Extract(orderId, link);
+            Unlink(orderId, link);
+            return true;
+        }
+
+        /** @brief Detaches an extracted link; the ends of its list mark where prev_/next_ are unset. */
+        void Unlink (OrderId orderId, const Link& link) {
+            List& list = *link.list_;
+
+            if (list.head_ == orderId)
+                list.head_ = link.next_;
+            else
+                links_.Find(link.prev_)->next_ = link.next_;
+
+            if (list.tail_ == orderId)
+                list.tail_ = link.prev_;
+            else
+                links_.Find(link.next_)->prev_ = link.prev_;
+
+            if (--list.count_ == 0 && list.expiry_ != Constants::NoExpiry)
+                goodTillDate_.erase(list.expiry_);
+        }
+
+        FlatOrderIndex<Link> links_;
+        std::array<List, 2> goodForDay_;
+        std::size_t current_{ 0 };
+        std::map<Expiry, List> goodTillDate_;
+};
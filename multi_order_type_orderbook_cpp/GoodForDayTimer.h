@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "Orderbook.h"
+
+/**
+ * @brief Sleeping thread that fires a callback at every Good‑For‑Day cutoff (16:00).
+ *
+ * The callback only enqueues work (e.g. a PruneGoodForDay command) for the
+ * threads that own the books; the timer itself never touches a book, so it
+ * cannot contend with matching.
+ */
+class GoodForDayTimer {
+    public:
+        /**
+         * @brief Starts the timer thread.
+         * @param onCutoff Invoked on the timer thread at each cutoff.
+         */
+        explicit GoodForDayTimer (std::function<void()> onCutoff)
+            : onCutoff_ { std::move(onCutoff) }
+            , thread_ { [this] { Run(); } }
+        { }
+
+        GoodForDayTimer(const GoodForDayTimer&) = delete;
+        void operator=(const GoodForDayTimer&) = delete;
+
+        /** @brief Wakes and joins the timer thread. */
+        ~GoodForDayTimer () {
+            {
+                std::scoped_lock lock{ mutex_ };
+                shutdown_ = true;
+            }
+            shutdownConditionVariable_.notify_one();
+            thread_.join();
+        }
+
+    private:
+        void Run () {
+            using namespace std::chrono;
+
+            while (true)
+            {
+                const auto now = system_clock::now();
+                const auto till = NextGoodForDayCutoff(now) - now + milliseconds(100);
+
+                {
+                    std::unique_lock lock{ mutex_ };
+                    if (shutdownConditionVariable_.wait_for(lock, till, [this] { return shutdown_; }))
+                        return;
+                }
+
+                onCutoff_();
+            }
+        }
+
+        std::function<void()> onCutoff_;
+        std::mutex mutex_;
+        std::condition_variable shutdownConditionVariable_;
+        bool shutdown_ { false };
+        std::thread thread_; // Last, so it starts after the members it uses
+};
@@ -0,0 +1,328 @@
+#pragma once
+
+/**
+ * @file Instrumentation.h
+ * @brief Compile-time switchable latency and counter instrumentation for BasicOrderbook.
+ *
+ * Books take an Instrumentation policy from their traits. NullInstrumentation
+ * (the default) has only empty inline hooks, so every call compiles away.
+ * OrderbookInstrumentation records timings in per-thread HDR-style histograms
+ * and counters that another thread can snapshot at any time without stopping
+ * or locking the book (see OrderbookInstrumentation::Snapshot).
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define ORDERBOOK_HAS_RDTSC 1
+#endif
+
+#include "LatencyHistogram.h"
+
+/**
+ * @brief Timed sections of the book, recorded in nanoseconds.
+ */
+enum class OrderbookTimer
+{
+    AddOrder,     // Whole AddOrder call, including lock wait and matching
+    CancelOrder,  // Whole CancelOrder call
+    ModifyOrder,  // Whole ModifyOrder call
+    ProcessBatch, // Whole ProcessBatch call
+    LockWait,     // Time to acquire ordersMutex_ in a public call
+    MatchOrders,  // Matching pass after an insertion
+    Count,
+};
+
+/**
+ * @brief Event counters.
+ */
+enum class OrderbookCounter
+{
+    OrdersAdded,     // Orders that came to rest or matched (rejections excluded)
+    OrdersCancelled, // Cancellations, expiries and Fill‑And‑Kill leftovers
+    Trades,          // Trades generated
+    LevelsCrossed,   // Price levels traded through, summed over aggressive orders
+    SelfTradesPrevented, // Crosses between orders of one account resolved without a trade
+    RiskRejections,  // Orders rejected by their account's position or notional limit
+    Count,
+};
+
+/**
+ * @brief Value distributions that are not times.
+ */
+enum class OrderbookDistribution
+{
+    LevelsCrossed, // Price levels traded through per aggressive order
+    Count,
+};
+
+/**
+ * @brief Cheap timestamp source: the TSC where available, steady_clock otherwise.
+ */
+struct CycleClock
+{
+    static std::uint64_t Now()
+    {
+#ifdef ORDERBOOK_HAS_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /**
+     * @brief Measures ticks against steady_clock for a couple of milliseconds.
+     * @return Nanoseconds per tick.
+     */
+    static double CalibrateNanosecondsPerTick()
+    {
+#ifdef ORDERBOOK_HAS_RDTSC
+        using namespace std::chrono;
+
+        const auto startTime = steady_clock::now();
+        const auto startTicks = Now();
+        while (steady_clock::now() - startTime < milliseconds(2)) { }
+        const auto ticks = Now() - startTicks;
+        const auto nanoseconds = duration_cast<std::chrono::nanoseconds>(steady_clock::now() - startTime).count();
+
+        return ticks == 0 ? 1.0 : static_cast<double>(nanoseconds) / static_cast<double>(ticks);
+#else
+        return 1.0;
+#endif
+    }
+};
+
+/**
+ * @brief Instrumentation that does nothing; every hook is empty and inlined away.
+ */
+struct NullInstrumentation
+{
+    struct Scope { };
+
+    Scope Time(OrderbookTimer) { return { }; }
+    std::uint64_t Start() const { return 0; }
+    void Stop(OrderbookTimer, std::uint64_t) { }
+    void Count(OrderbookCounter, std::uint64_t = 1) { }
+    void Sample(OrderbookDistribution, std::uint64_t) { }
+};
+
+/**
+ * @brief Merged view of every thread's measurements at one point in time.
+ */
+class OrderbookMetrics {
+    public:
+        const LatencyHistogram& Timer (OrderbookTimer timer) const { return timers_[static_cast<std::size_t>(timer)]; }
+        const LatencyHistogram& Distribution (OrderbookDistribution distribution) const { return distributions_[static_cast<std::size_t>(distribution)]; }
+        std::uint64_t Counter (OrderbookCounter counter) const { return counters_[static_cast<std::size_t>(counter)]; }
+
+    private:
+        friend class OrderbookInstrumentation;
+
+        std::array<LatencyHistogram, static_cast<std::size_t>(OrderbookTimer::Count)> timers_;
+        std::array<LatencyHistogram, static_cast<std::size_t>(OrderbookDistribution::Count)> distributions_;
+        std::array<std::uint64_t, static_cast<std::size_t>(OrderbookCounter::Count)> counters_ { };
+};
+
+/**
+ * @brief Writes one line per non-empty timer/distribution and one per counter.
+ */
+inline std::ostream& operator<<(std::ostream& stream, const OrderbookMetrics& metrics)
+{
+    static constexpr const char* TimerNames[] = { "AddOrder", "CancelOrder", "ModifyOrder", "ProcessBatch", "LockWait", "MatchOrders" };
+    static constexpr const char* CounterNames[] = { "OrdersAdded", "OrdersCancelled", "Trades", "LevelsCrossed", "SelfTradesPrevented", "RiskRejections" };
+
+    auto Describe = [&stream](const char* name, const LatencyHistogram& histogram, const char* unit)
+    {
+        if (histogram.Count() == 0)
+            return;
+
+        stream << name << ": count " << histogram.Count()
+            << " p50 " << histogram.Percentile(50.0) << unit
+            << " p99 " << histogram.Percentile(99.0) << unit
+            << " p99.9 " << histogram.Percentile(99.9) << unit
+            << " max " << histogram.Max() << unit << '\n';
+    };
+
+    for (std::size_t timer = 0; timer < static_cast<std::size_t>(OrderbookTimer::Count); ++timer)
+        Describe(TimerNames[timer], metrics.Timer(static_cast<OrderbookTimer>(timer)), "ns");
+
+    Describe("LevelsCrossedPerOrder", metrics.Distribution(OrderbookDistribution::LevelsCrossed), "");
+
+    for (std::size_t counter = 0; counter < static_cast<std::size_t>(OrderbookCounter::Count); ++counter)
+        stream << CounterNames[counter] << ": " << metrics.Counter(static_cast<OrderbookCounter>(counter)) << '\n';
+
+    return stream;
+}
+
+/**
+ * @brief Recording instrumentation: per-thread histograms and counters.
+ *
+ * Each thread that calls into the book gets its own block of relaxed-atomic
+ * buckets on first use, so recording never contends with other threads and
+ * never shares a cache line with them. Only the owning thread writes a block;
+ * Snapshot() reads all blocks concurrently and merges them. Blocks are
+ * published on a lock-free append-only list, and each thread caches its
+ * blocks by book id, so a thread recording into many books (an
+ * OrderbookEngine shard) finds its block without a lock either.
+ */
+class OrderbookInstrumentation {
+    public:
+        /**
+         * @brief Running timer for one section; records when it goes out of scope.
+         */
+        class Scope {
+            public:
+                Scope (OrderbookInstrumentation& instrumentation, OrderbookTimer timer)
+                    : instrumentation_ { instrumentation }
+                    , timer_ { timer }
+                    , start_ { CycleClock::Now() }
+                { }
+
+                Scope(const Scope&) = delete;
+                void operator=(const Scope&) = delete;
+
+                ~Scope () { instrumentation_.Stop(timer_, start_); }
+
+            private:
+                OrderbookInstrumentation& instrumentation_;
+                OrderbookTimer timer_;
+                std::uint64_t start_;
+        };
+
+        OrderbookInstrumentation ()
+            : nanosecondsPerTick_ { CycleClock::CalibrateNanosecondsPerTick() }
+        { }
+
+        OrderbookInstrumentation(const OrderbookInstrumentation&) = delete;
+        void operator=(const OrderbookInstrumentation&) = delete;
+
+        ~OrderbookInstrumentation () {
+            for (ThreadMetrics* thread = threads_.load(std::memory_order_acquire); thread != nullptr; )
+                delete std::exchange(thread, thread->next_);
+        }
+
+        /** @brief Times the enclosing scope. */
+        Scope Time (OrderbookTimer timer) { return Scope{ *this, timer }; }
+
+        std::uint64_t Start () const { return CycleClock::Now(); }
+
+        /** @brief Records the time since start (a value returned by Start). */
+        void Stop (OrderbookTimer timer, std::uint64_t start) {
+            const std::uint64_t ticks = CycleClock::Now() - start;
+            const auto nanoseconds = static_cast<std::uint64_t>(static_cast<double>(ticks) * nanosecondsPerTick_);
+            Local().timers_[static_cast<std::size_t>(timer)].Record(nanoseconds);
+        }
+
+        void Count (OrderbookCounter counter, std::uint64_t count = 1) {
+            auto& value = Local().counters_[static_cast<std::size_t>(counter)];
+            value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+
+        void Sample (OrderbookDistribution distribution, std::uint64_t value) {
+            Local().distributions_[static_cast<std::size_t>(distribution)].Record(value);
+        }
+
+        /**
+         * @brief Merges every thread's measurements; safe while the book is in use.
+         *
+         * Counts recorded concurrently may or may not be included, but nothing
+         * is lost: a later snapshot sees them.
+         */
+        OrderbookMetrics Snapshot () const {
+            OrderbookMetrics metrics;
+
+            for (const ThreadMetrics* thread = threads_.load(std::memory_order_acquire); thread != nullptr; thread = thread->next_)
+            {
+                for (std::size_t timer = 0; timer < thread->timers_.size(); ++timer)
+                    thread->timers_[timer].MergeInto(metrics.timers_[timer]);
+
+                for (std::size_t distribution = 0; distribution < thread->distributions_.size(); ++distribution)
+                    thread->distributions_[distribution].MergeInto(metrics.distributions_[distribution]);
+
+                for (std::size_t counter = 0; counter < thread->counters_.size(); ++counter)
+                    metrics.counters_[counter] += thread->counters_[counter].load(std::memory_order_relaxed);
+            }
+
+            return metrics;
+        }
+
+    private:
+        /**
+         * @brief Histogram buckets written by one thread and readable by any.
+         */
+        class ThreadHistogram {
+            public:
+                void Record (std::uint64_t value) {
+                    auto& count = counts_[LatencyHistogram::Index(value)];
+                    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                }
+
+                void MergeInto (LatencyHistogram& histogram) const {
+                    for (std::size_t index = 0; index < LatencyHistogram::BucketCount; ++index)
+                        histogram.AddToBucket(index, counts_[index].load(std::memory_order_relaxed));
+                }
+
+            private:
+                std::array<std::atomic<std::uint64_t>, LatencyHistogram::BucketCount> counts_ { };
+        };
+
+        struct alignas(64) ThreadMetrics {
+            std::thread::id owner_;
+            ThreadMetrics* next_ { nullptr }; // Set before the block is published, then never changed
+            std::array<ThreadHistogram, static_cast<std::size_t>(OrderbookTimer::Count)> timers_;
+            std::array<ThreadHistogram, static_cast<std::size_t>(OrderbookDistribution::Count)> distributions_;
+            std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(OrderbookCounter::Count)> counters_ { };
+        };
+
+        /** @return The calling thread's block, registering it on first use. */
+        ThreadMetrics& Local () {
+            // Direct-mapped per thread and keyed by id_, not this, so a new book
+            // at a recycled address misses. Ids are sequential, so up to
+            // CachedBooks books created together never evict each other.
+            struct CacheEntry {
+                std::uint64_t owner_ { 0 };
+                ThreadMetrics* metrics_ { nullptr };
+            };
+            thread_local std::array<CacheEntry, CachedBooks> cache;
+
+            CacheEntry& entry = cache[id_ % CachedBooks];
+            if (entry.owner_ != id_)
+                entry = CacheEntry{ id_, &Register() };
+            return *entry.metrics_;
+        }
+
+        /** @return The calling thread's block, found on the list or pushed onto it. */
+        ThreadMetrics& Register () {
+            const auto self = std::this_thread::get_id();
+
+            ThreadMetrics* head = threads_.load(std::memory_order_acquire);
+            for (ThreadMetrics* thread = head; thread != nullptr; thread = thread->next_)
+                if (thread->owner_ == self)
+                    return *thread;
+
+            // Only this thread registers self, so blocks pushed meanwhile are other threads'
+            auto metrics = std::make_unique<ThreadMetrics>();
+            metrics->owner_ = self;
+            metrics->next_ = head;
+            while (!threads_.compare_exchange_weak(metrics->next_, metrics.get(), std::memory_order_release, std::memory_order_acquire)) { }
+            return *metrics.release();
+        }
+
+        static constexpr std::size_t CachedBooks = 64;
+
+        static inline std::atomic<std::uint64_t> nextId_ { 1 };
+
+        std::uint64_t id_ { nextId_.fetch_add(1, std::memory_order_relaxed) };
+        double nanosecondsPerTick_;
+        std::atomic<ThreadMetrics*> threads_ { nullptr };
+};
@@ -0,0 +1,471 @@
+#pragma once
+
+/**
+ * @file Journal.h
+ * @brief Append-only command journal, its reader, and crash recovery.
+ *
+ * The owner of a book appends every command it applies (adds, cancels,
+ * modifies and expiry commands) to a JournalWriter in the order it
+ * applies them. Matching is deterministic, so replaying the journal into an
+ * empty book (or into a snapshot taken at journal sequence S, replaying only
+ * records after S) rebuilds the book exactly, rejected orders included.
+ *
+ * File layout: the 8-byte magic "OBJOURN2", then fixed 48-byte records (see
+ * JournalRecord). The writer preallocates the file ahead of the records, so
+ * the valid journal ends at the first record whose checksum or sequence does
+ * not match: zero-filled space and a record torn by a crash both stop it.
+ *
+ * Durability is a group commit: Append only hands the command to the writer
+ * thread, which writes and syncs it shortly after, while the matcher carries
+ * on. A crash loses at most the commands not yet reported by
+ * DurableSequence(); anything that must not be lost (e.g. acknowledgements)
+ * should wait for that sequence.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#error "Journal.h needs POSIX file I/O (pwrite, fdatasync)."
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Command.h"
+#include "Crc32.h"
+#include "MappedFile.h"
+#include "Snapshot.h"
+#include "SpscRing.h"
+#include "ThreadAffinity.h"
+#include "Trade.h"
+#include "WireFormat.h"
+
+/**
+ * @brief Layout of one journal record:
+ *
+ *   0  u64  sequence (consecutive, starting at any value >= 1)
+ *   8  WireCommand (32 bytes)
+ *  40  u16  account (the wire encoding leaves it to the gateway)
+ *  42  u16  reserved (0)
+ *  44  u32  CRC-32 of bytes 0..43
+ *
+ * The magic was "OBJOURNL" before records carried the account; such files
+ * are refused rather than replayed without their accounts.
+ */
+struct JournalRecord
+{
+    static constexpr std::string_view Magic{ "OBJOURN2" };
+    static constexpr std::size_t HeaderSize = 8;
+    static constexpr std::size_t Size = 8 + WireCommand::Size + 8;
+
+    static void Encode(std::uint64_t sequence, const Command& command, unsigned char* bytes)
+    {
+        LittleEndian::Store(bytes, sequence);
+        WireCommand::Encode(command, bytes + 8);
+        LittleEndian::Store(bytes + AccountOffset, command.account_);
+        LittleEndian::Store(bytes + AccountOffset + 2, std::uint16_t{ 0 });
+        LittleEndian::Store(bytes + ChecksumOffset, Crc32::Compute(bytes, ChecksumOffset));
+    }
+
+    /**
+     * @return False (outputs untouched) if the checksum or an enum field is wrong.
+     */
+    static bool TryDecode(const unsigned char* bytes, std::uint64_t& sequence, Command& command)
+    {
+        if (Crc32::Compute(bytes, ChecksumOffset) != LittleEndian::Load<std::uint32_t>(bytes + ChecksumOffset))
+            return false;
+
+        if (!WireCommand::TryDecode(std::span<const unsigned char>{ bytes + 8, WireCommand::Size }, command))
+            return false;
+
+        command.account_ = LittleEndian::Load<AccountId>(bytes + AccountOffset);
+        sequence = LittleEndian::Load<std::uint64_t>(bytes);
+        return true;
+    }
+
+private:
+    static constexpr std::size_t AccountOffset = 8 + WireCommand::Size;
+    static constexpr std::size_t ChecksumOffset = AccountOffset + 4;
+};
+
+/**
+ * @brief Where a journal continues: the next sequence to assign and the file
+ *        offset to write it at. offset_ 0 means a new (or truncated) file.
+ */
+struct JournalPosition
+{
+    std::uint64_t nextSequence_{ 1 };
+    std::uint64_t offset_{ 0 };
+};
+
+/**
+ * @brief Sequential reader of a journal file through a memory mapping.
+ */
+class JournalReader {
+    public:
+        /**
+         * @param path Journal to read; a missing or empty file reads as an empty journal.
+         * @throws std::runtime_error if the file exists but is not a journal.
+         */
+        explicit JournalReader (const std::string& path) {
+            if (!std::filesystem::exists(path) || std::filesystem::file_size(path) == 0)
+                return;
+
+            file_.emplace(path);
+            if (file_->View().substr(0, JournalRecord::Magic.size()) != JournalRecord::Magic)
+                throw std::runtime_error("Not a journal: " + path);
+
+            offset_ = JournalRecord::HeaderSize;
+        }
+
+        /**
+         * @brief Reads the next valid record.
+         * @return False at the end of the valid journal.
+         */
+        bool Next (std::uint64_t& sequence, Command& command) {
+            if (!file_ || file_->Size() - offset_ < JournalRecord::Size)
+                return false;
+
+            const auto* bytes = reinterpret_cast<const unsigned char*>(file_->Data()) + offset_;
+            std::uint64_t recordSequence;
+            if (!JournalRecord::TryDecode(bytes, recordSequence, command))
+                return false;
+
+            if (recordSequence == 0 || (lastSequence_ != 0 && recordSequence != lastSequence_ + 1))
+                return false;
+
+            sequence = lastSequence_ = recordSequence;
+            offset_ += JournalRecord::Size;
+            return true;
+        }
+
+        /**
+         * @return Where a writer continues after the records read so far.
+         */
+        JournalPosition Position () const { return JournalPosition{ lastSequence_ + 1, offset_ }; }
+
+    private:
+        std::optional<MappedFile> file_;
+        std::uint64_t offset_{ 0 };
+        std::uint64_t lastSequence_{ 0 };
+};
+
+/**
+ * @brief Appends commands to a journal file from a dedicated I/O thread.
+ *
+ * The matching thread calls Append, which only copies the command into an
+ * SPSC ring. The writer thread drains the ring in batches, encodes them into
+ * a reusable buffer, writes each batch with one pwrite into space the file
+ * already owns (it is extended with fallocate in large steps, so appends do
+ * not allocate blocks), and syncs with fdatasync once per batch.
+ *
+ * The writer thread also writes snapshots handed over with SubmitSnapshot,
+ * once every record the snapshot includes is durable.
+ */
+class JournalWriter {
+    public:
+        static constexpr std::size_t DefaultRingCapacity = 1 << 16;
+        static constexpr std::size_t BatchRecords = 1024;
+        static constexpr std::uint64_t PreallocationBytes = 64 << 20;
+
+        /**
+         * @param path Journal file; created if missing.
+         * @param position Where to continue (from JournalReader or RecoverOrderbook);
+         *        the file is truncated there. The default starts a new journal,
+         *        discarding any existing content.
+         * @param syncEachBatch Whether to fdatasync every batch (off: the OS decides).
+         * @param ringCapacity Commands that can be pending (power of two).
+         * @throws std::runtime_error if the file cannot be opened or initialised.
+         */
+        explicit JournalWriter (const std::string& path, JournalPosition position = { },
+            bool syncEachBatch = true, std::size_t ringCapacity = DefaultRingCapacity)
+            : pending_ { ringCapacity }
+            , buffer_ (BatchRecords * JournalRecord::Size)
+            , offset_ { position.offset_ }
+            , appendedSequence_ { position.nextSequence_ - 1 }
+            , writtenSequence_ { position.nextSequence_ - 1 }
+            , durableSequence_ { position.nextSequence_ - 1 }
+            , syncEachBatch_ { syncEachBatch }
+        {
+            file_ = open(path.c_str(), O_WRONLY | O_CREAT | (offset_ == 0 ? O_TRUNC : 0), 0644);
+            if (file_ < 0)
+                throw std::runtime_error("Cannot open journal " + path);
+
+            allocated_ = static_cast<std::uint64_t>(lseek(file_, 0, SEEK_END));
+
+            // Cut off the torn record and everything after it: a stale record that
+            // happened to continue the new sequence would otherwise read as valid
+            if (offset_ != 0)
+            {
+                if (ftruncate(file_, static_cast<off_t>(offset_)) != 0 || fdatasync(file_) != 0)
+                {
+                    close(file_);
+                    throw std::runtime_error("Cannot truncate journal " + path);
+                }
+                allocated_ = offset_;
+            }
+
+            if (offset_ == 0)
+            {
+                if (!WriteFully(reinterpret_cast<const unsigned char*>(JournalRecord::Magic.data()), JournalRecord::HeaderSize, 0) || fdatasync(file_) != 0)
+                {
+                    close(file_);
+                    throw std::runtime_error("Cannot initialise journal " + path);
+                }
+                offset_ = JournalRecord::HeaderSize;
+            }
+
+            thread_ = std::thread{ [this] { Run(); } };
+        }
+
+        JournalWriter(const JournalWriter&) = delete;
+        void operator=(const JournalWriter&) = delete;
+
+        /**
+         * @brief Writes and syncs everything appended, plus any pending snapshot, then closes the file.
+         */
+        ~JournalWriter () {
+            stop_.store(true, std::memory_order_release);
+            thread_.join();
+            close(file_);
+        }
+
+        /**
+         * @brief Producer (matching thread) side: queues a command for the journal.
+         *
+         * Waits for ring space if the writer has fallen behind, so the journal
+         * never silently drops a command.
+         * @return The sequence assigned to the command.
+         */
+        std::uint64_t Append (const Command& command) {
+            while (!pending_.TryPush(command))
+                CpuRelax();
+            return ++appendedSequence_;
+        }
+
+        void Append (std::span<const Command> commands) {
+            for (const Command& command : commands)
+                Append(command);
+        }
+
+        /**
+         * @return Sequence of the last command appended. Producer side only.
+         */
+        std::uint64_t LastSequence () const { return appendedSequence_; }
+
+        /**
+         * @return Sequence of the last command known to be on disk (synced when syncEachBatch).
+         */
+        std::uint64_t DurableSequence () const { return durableSequence_.load(std::memory_order_acquire); }
+
+        /**
+         * @return True once a write failed; nothing after DurableSequence() is journaled then.
+         */
+        bool Failed () const { return failed_.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Hands a snapshot to the writer thread, which writes it to path
+         *        once the journal is durable up to image.Sequence().
+         *
+         * A snapshot still waiting when another arrives is replaced by the newer one.
+         */
+        void SubmitSnapshot (SnapshotImage image, std::string path) {
+            std::scoped_lock lock{ snapshotMutex_ };
+            snapshot_.emplace(std::move(image), std::move(path));
+        }
+
+        /**
+         * @return Sequence of the last snapshot written (0 if none).
+         */
+        std::uint64_t SnapshotSequence () const { return snapshotSequence_.load(std::memory_order_acquire); }
+
+    private:
+        static constexpr auto IdleSleep = std::chrono::microseconds(50);
+
+        void Run () {
+            while (true)
+            {
+                const bool stopping = stop_.load(std::memory_order_acquire);
+
+                const std::size_t count = Drain();
+                if (count > 0)
+                    WriteBatch(count);
+
+                WritePendingSnapshot();
+
+                if (count == 0)
+                {
+                    if (stopping)
+                        return;
+                    std::this_thread::sleep_for(IdleSleep);
+                }
+            }
+        }
+
+        /** @return Number of records encoded into buffer_. */
+        std::size_t Drain () {
+            std::size_t count = 0;
+            Command command;
+            while (count < BatchRecords && pending_.TryPop(command))
+            {
+                JournalRecord::Encode(++writtenSequence_, command, buffer_.data() + count * JournalRecord::Size);
+                ++count;
+            }
+            return count;
+        }
+
+        void WriteBatch (std::size_t count) {
+            if (failed_.load(std::memory_order_relaxed))
+                return;
+
+            const std::size_t size = count * JournalRecord::Size;
+            if (offset_ + size > allocated_)
+                Preallocate(offset_ + size);
+
+            const bool written = WriteFully(buffer_.data(), size, offset_)
+                && (!syncEachBatch_ || fdatasync(file_) == 0);
+            if (!written)
+            {
+                failed_.store(true, std::memory_order_release);
+                return;
+            }
+
+            offset_ += size;
+            durableSequence_.store(writtenSequence_, std::memory_order_release);
+        }
+
+        /** @brief Extends the file in PreallocationBytes steps so appends stay within allocated blocks. */
+        void Preallocate (std::uint64_t size) {
+            const std::uint64_t target = (size / PreallocationBytes + 1) * PreallocationBytes;
+#if defined(__linux__)
+            // Best effort: file systems without fallocate simply grow on write
+            if (posix_fallocate(file_, static_cast<off_t>(allocated_), static_cast<off_t>(target - allocated_)) != 0)
+                return;
+#endif
+            allocated_ = target;
+        }
+
+        bool WriteFully (const unsigned char* bytes, std::size_t size, std::uint64_t offset) {
+            while (size > 0)
+            {
+                const auto count = pwrite(file_, bytes, size, static_cast<off_t>(offset));
+                if (count <= 0)
+                    return false;
+
+                bytes += count;
+                size -= static_cast<std::size_t>(count);
+                offset += static_cast<std::uint64_t>(count);
+            }
+            return true;
+        }
+
+        void WritePendingSnapshot () {
+            std::optional<std::pair<SnapshotImage, std::string>> snapshot;
+            {
+                std::scoped_lock lock{ snapshotMutex_ };
+                if (!snapshot_ || snapshot_->first.Sequence() > durableSequence_.load(std::memory_order_relaxed))
+                    return;
+                snapshot.swap(snapshot_);
+            }
+
+            try
+            {
+                snapshot->first.Write(snapshot->second);
+                snapshotSequence_.store(snapshot->first.Sequence(), std::memory_order_release);
+            }
+            catch (const std::exception&)
+            {
+                failed_.store(true, std::memory_order_release);
+            }
+        }
+
+        SpscRing<Command> pending_;
+        std::vector<unsigned char> buffer_; // Writer thread only
+        int file_{ -1 };
+        std::uint64_t offset_;              // Writer thread only (after construction)
+        std::uint64_t allocated_{ 0 };      // Writer thread only (after construction)
+        std::uint64_t appendedSequence_;    // Producer only
+        std::uint64_t writtenSequence_;     // Writer thread only
+        std::atomic<std::uint64_t> durableSequence_;
+        std::atomic<std::uint64_t> snapshotSequence_{ 0 };
+        std::atomic<bool> failed_{ false };
+        std::atomic<bool> stop_{ false };
+        bool syncEachBatch_;
+        std::mutex snapshotMutex_;
+        std::optional<std::pair<SnapshotImage, std::string>> snapshot_;
+        std::thread thread_; // Last, so it starts after the members it uses
+};
+
+/**
+ * @brief Rebuilds a book after a restart: loads the snapshot (if any), then
+ *        replays the journal records after it, in batches.
+ * @param book An empty book.
+ * @param snapshotPath Snapshot to start from; a missing file starts from an empty book.
+ * @param journalPath Journal to replay; a missing file replays nothing.
+ * @param sink Receives the trades of the replayed commands (already reported before the crash).
+ * @return Position a JournalWriter continues the journal at.
+ * @throws std::runtime_error if the snapshot is corrupt or the journal does not continue it.
+ */
+template <typename Book, TradeSink Sink>
+JournalPosition RecoverOrderbook(Book& book, const std::string& snapshotPath, const std::string& journalPath, Sink&& sink)
+{
+    std::uint64_t snapshotSequence = 0;
+    if (std::filesystem::exists(snapshotPath))
+    {
+        const SnapshotImage image = SnapshotImage::Load(snapshotPath);
+        image.Restore(book);
+        snapshotSequence = image.Sequence();
+    }
+
+    JournalReader reader{ journalPath };
+    std::array<Command, 256> batch;
+    std::size_t count = 0;
+    std::uint64_t sequence = 0;
+    bool first = true;
+
+    while (reader.Next(sequence, batch[count]))
+    {
+        if (first && sequence > snapshotSequence + 1)
+            throw std::runtime_error("Journal " + journalPath + " starts after snapshot " + snapshotPath);
+        first = false;
+
+        if (sequence <= snapshotSequence)
+            continue;
+
+        if (++count == batch.size())
+        {
+            book.ProcessBatch(std::span<const Command>{ batch.data(), count }, sink);
+            count = 0;
+        }
+    }
+    book.ProcessBatch(std::span<const Command>{ batch.data(), count }, sink);
+
+    JournalPosition position = reader.Position();
+    if (position.nextSequence_ <= snapshotSequence)
+        position = JournalPosition{ snapshotSequence + 1, 0 }; // Journal ends before the snapshot: start a new one
+
+    return position;
+}
+
+/**
+ * @brief RecoverOrderbook discarding the replayed trades.
+ */
+template <typename Book>
+JournalPosition RecoverOrderbook(Book& book, const std::string& snapshotPath, const std::string& journalPath)
+{
+    return RecoverOrderbook(book, snapshotPath, journalPath, [](const Trade&) { });
+}
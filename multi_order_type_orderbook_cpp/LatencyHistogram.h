@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Fixed-size log-linear latency histogram (HDR style).
+ *
+ * Values below 2^SubBucketBits are counted exactly; above that every power of
+ * two is split into 2^SubBucketBits equal sub-buckets, so any recorded value
+ * is reported within ~3% of itself. Recording is a few instructions and never
+ * allocates, which keeps it usable on the measured path.
+ */
+class LatencyHistogram {
+    public:
+        static constexpr unsigned SubBucketBits = 5;
+        static constexpr std::size_t SubBucketCount = std::size_t{ 1 } << SubBucketBits;
+        static constexpr std::size_t BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+        /** @brief Counts one sample (in whatever unit the caller uses, typically nanoseconds). */
+        void Record (std::uint64_t value) {
+            ++counts_[Index(value)];
+            ++count_;
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+        }
+
+        /** @brief Adds every sample of other to this histogram. */
+        void Merge (const LatencyHistogram& other) {
+            for (std::size_t index = 0; index < BucketCount; ++index)
+                counts_[index] += other.counts_[index];
+
+            count_ += other.count_;
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+        }
+
+        /**
+         * @brief Adds count samples to one bucket, e.g. when rebuilding a histogram from raw bucket counts.
+         */
+        void AddToBucket (std::size_t index, std::uint64_t count) {
+            if (count == 0)
+                return;
+
+            counts_[index] += count;
+            count_ += count;
+            min_ = std::min(min_, LowerBound(index));
+            max_ = std::max(max_, UpperBound(index));
+        }
+
+        void Reset () { *this = LatencyHistogram{ }; }
+
+        /**
+         * @param percentile In [0, 100], e.g. 99.9.
+         * @return Upper bound of the bucket holding that percentile (0 if empty).
+         */
+        std::uint64_t Percentile (double percentile) const {
+            if (count_ == 0)
+                return 0;
+
+            const auto rank = std::max<std::uint64_t>(1,
+                static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count_))));
+
+            std::uint64_t seen = 0;
+            for (std::size_t index = 0; index < BucketCount; ++index)
+            {
+                seen += counts_[index];
+                if (seen >= rank)
+                    return std::min(UpperBound(index), max_);
+            }
+
+            return max_;
+        }
+
+        std::uint64_t Count () const { return count_; }
+        std::uint64_t Min () const { return count_ == 0 ? 0 : min_; }
+        std::uint64_t Max () const { return max_; }
+
+        /** @return Bucket a value is counted in. */
+        static std::size_t Index (std::uint64_t value) {
+            if (value < SubBucketCount)
+                return static_cast<std::size_t>(value);
+
+            const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SubBucketBits;
+            return (shift + 1) * SubBucketCount + static_cast<std::size_t>((value >> shift) - SubBucketCount);
+        }
+
+        /** @return Largest value counted in a bucket. */
+        static std::uint64_t UpperBound (std::size_t index) {
+            if (index < SubBucketCount)
+                return index;
+
+            const std::size_t shift = index / SubBucketCount - 1;
+            const std::uint64_t top = SubBucketCount + index % SubBucketCount;
+            return ((top + 1) << shift) - 1;
+        }
+
+        /** @return Smallest value counted in a bucket. */
+        static std::uint64_t LowerBound (std::size_t index) {
+            if (index < SubBucketCount)
+                return index;
+
+            const std::size_t shift = index / SubBucketCount - 1;
+            return (SubBucketCount + index % SubBucketCount) << shift;
+        }
+
+    private:
+
+        std::array<std::uint64_t, BucketCount> counts_ { };
+        std::uint64_t count_ { 0 };
+        std::uint64_t min_ { std::numeric_limits<std::uint64_t>::max() };
+        std::uint64_t max_ { 0 };
+};
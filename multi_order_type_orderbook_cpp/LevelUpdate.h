@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Usings.h"
+#include "Side.h"
+
+/**
+ * @brief Market-data event: the new state of one price level after a change.
+ *
+ * Emitted every time a level's aggregates change. An update with
+ * orderCount_ == 0 means the level is gone. sequence_ increases by one per
+ * update emitted by a book, including updates dropped because the ring was
+ * full, so a consumer that sees a jump knows it missed events and should
+ * resynchronise from a snapshot (see BasicOrderbook::GetOrderInfos).
+ */
+struct LevelUpdate
+{
+    std::uint64_t sequence_{ };
+    Side side_{ Side::Buy };
+    Price price_{ };
+    Quantity quantity_{ };   // New total remaining quantity at the level
+    Quantity orderCount_{ }; // New number of orders at the level
+};
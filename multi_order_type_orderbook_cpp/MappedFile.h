@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Lets multi-gigabyte inputs be scanned in place: the kernel pages the file
+ * in on demand and nothing is copied into user buffers.
+ */
+class MappedFile {
+    public:
+        /**
+         * @param path File to map.
+         * @throws std::runtime_error if the file cannot be opened or mapped.
+         */
+        explicit MappedFile (const std::string& path) {
+#ifdef _WIN32
+            file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE)
+                throw std::runtime_error("Cannot open " + path);
+
+            LARGE_INTEGER size;
+            GetFileSizeEx(file_, &size);
+            size_ = static_cast<std::size_t>(size.QuadPart);
+            if (size_ == 0)
+                return;
+
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_ == nullptr)
+                throw std::runtime_error("Cannot map " + path);
+
+            data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+#else
+            file_ = open(path.c_str(), O_RDONLY);
+            if (file_ < 0)
+                throw std::runtime_error("Cannot open " + path);
+
+            struct stat status;
+            fstat(file_, &status);
+            size_ = static_cast<std::size_t>(status.st_size);
+            if (size_ == 0)
+                return;
+
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_, 0);
+            if (data == MAP_FAILED)
+                throw std::runtime_error("Cannot map " + path);
+
+            madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        void operator=(const MappedFile&) = delete;
+
+        ~MappedFile () {
+#ifdef _WIN32
+            if (data_ != nullptr)
+                UnmapViewOfFile(data_);
+            if (mapping_ != nullptr)
+                CloseHandle(mapping_);
+            if (file_ != INVALID_HANDLE_VALUE)
+                CloseHandle(file_);
+#else
+            if (data_ != nullptr)
+                munmap(const_cast<char*>(data_), size_);
+            if (file_ >= 0)
+                close(file_);
+#endif
+        }
+
+        const char* Data () const { return data_; }
+        std::size_t Size () const { return size_; }
+        std::string_view View () const { return { data_, size_ }; }
+
+    private:
+        const char* data_ { nullptr };
+        std::size_t size_ { 0 };
+#ifdef _WIN32
+        HANDLE file_ { INVALID_HANDLE_VALUE };
+        HANDLE mapping_ { nullptr };
+#else
+        int file_ { -1 };
+#endif
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "LevelUpdate.h"
+#include "OrderbookLevelInfos.h"
+#include "Side.h"
+#include "TopOfBook.h"
+#include "Usings.h"
+
+/**
+ * @brief One side of a MarketByPriceBook: levels in a sorted flat array.
+ *
+ * Levels are kept worst first, so the best level is the last element: the
+ * updates that dominate a feed, at and near the touch, insert and erase at
+ * the end of the array and move little or nothing. Lookups are binary
+ * searches over 12-byte entries that share cache lines.
+ */
+template <Side S>
+class MarketByPriceSide {
+    public:
+        struct Level {
+            Price price_{ };
+            Quantity quantity_{ };
+            Quantity count_{ };
+        };
+
+        explicit MarketByPriceSide (std::size_t capacity) { levels_.reserve(capacity); }
+
+        /**
+         * @brief Creates or replaces the level at price; a zero quantity deletes it.
+         *        A level with quantity holds at least one order, so a zero count
+         *        (a venue that publishes none) is stored as 1.
+         */
+        void Set (Price price, Quantity quantity, Quantity count) {
+            if (quantity == 0)
+            {
+                Delete(price);
+                return;
+            }
+
+            count = std::max<Quantity>(count, 1);
+
+            const auto level = Find(price);
+            if (level != levels_.end() && level->price_ == price)
+            {
+                level->quantity_ = quantity;
+                level->count_ = count;
+            }
+            else
+                levels_.insert(level, Level{ price, quantity, count });
+        }
+
+        /** @brief Removes the level at price, if any. */
+        void Delete (Price price) {
+            const auto level = Find(price);
+            if (level != levels_.end() && level->price_ == price)
+                levels_.erase(level);
+        }
+
+        void Clear () { levels_.clear(); }
+
+        bool Empty () const { return levels_.empty(); }
+        std::size_t Size () const { return levels_.size(); }
+
+        /** @return Best level (side must not be empty). */
+        const Level& Best () const { return levels_.back(); }
+
+        /** @brief Invokes function(level) best first until it returns false. */
+        template <typename Function>
+        void ForEachLevel (Function&& function) const {
+            for (auto level = levels_.rbegin(); level != levels_.rend(); ++level)
+                if (!function(*level))
+                    return;
+        }
+
+    private:
+        /** @return True if price belongs before than in the array, i.e. is worse. */
+        static bool IsWorse (Price price, Price than) { return S == Side::Buy ? price < than : price > than; }
+
+        /** @return First level not worse than price. */
+        typename std::vector<Level>::iterator Find (Price price) {
+            return std::lower_bound(levels_.begin(), levels_.end(), price,
+                [](const Level& level, Price value) { return IsWorse(level.price_, value); });
+        }
+
+        std::vector<Level> levels_;
+};
+
+/**
+ * @brief Aggregated (market-by-price) book for venues that publish only level data.
+ *
+ * Holds price -> (quantity, order count) per side and nothing per order:
+ * there are no Order objects, no per-level FIFOs and no id index. Updates
+ * set or delete a level outright, either directly or from a LevelUpdate
+ * stream (an order count of zero deletes), such as the one an order-by-order
+ * book publishes. The book answers the same depth queries as BasicOrderbook
+ * (GetOrderInfos, GetTopOfBook, Size).
+ *
+ * Not thread-safe: one thread applies updates and reads it, e.g. the thread
+ * polling the feed that carries them.
+ */
+class MarketByPriceBook {
+    public:
+        static constexpr std::size_t DefaultLevelCapacity = 256;
+
+        /** @param levelCapacity Levels each side holds before its array grows. */
+        explicit MarketByPriceBook (std::size_t levelCapacity = DefaultLevelCapacity)
+            : bids_ { levelCapacity }
+            , asks_ { levelCapacity }
+        { }
+
+        /**
+         * @brief Sets the level at price on side; a zero quantity deletes it.
+         * @param count Orders at the level; 0 for venues that publish no count (stored as 1).
+         */
+        void SetLevel (Side side, Price price, Quantity quantity, Quantity count) {
+            if (side == Side::Buy)
+                bids_.Set(price, quantity, count);
+            else
+                asks_.Set(price, quantity, count);
+        }
+
+        void DeleteLevel (Side side, Price price) {
+            if (side == Side::Buy)
+                bids_.Delete(price);
+            else
+                asks_.Delete(price);
+        }
+
+        /**
+         * @brief Applies a level update and remembers its sequence.
+         *
+         * A caller that sees update.sequence_ != LastSequence() + 1 missed
+         * updates and should Clear and resynchronise from a snapshot.
+         */
+        void Apply (const LevelUpdate& update) {
+            SetLevel(update.side_, update.price_, update.orderCount_ == 0 ? 0 : update.quantity_, update.orderCount_);
+            lastSequence_ = update.sequence_;
+        }
+
+        /** @brief Removes every level, e.g. before loading a snapshot. */
+        void Clear () {
+            bids_.Clear();
+            asks_.Clear();
+        }
+
+        /** @return Sequence of the last update applied (0 if none). */
+        std::uint64_t LastSequence () const { return lastSequence_; }
+
+        /** @return Number of levels on both sides. */
+        std::size_t Size () const { return bids_.Size() + asks_.Size(); }
+
+        TopOfBook GetTopOfBook () const {
+            TopOfBook top;
+            if (!bids_.Empty())
+            {
+                const auto& best = bids_.Best();
+                top.bidPrice_ = best.price_;
+                top.bidQuantity_ = best.quantity_;
+                top.bidCount_ = best.count_;
+            }
+            if (!asks_.Empty())
+            {
+                const auto& best = asks_.Best();
+                top.askPrice_ = best.price_;
+                top.askQuantity_ = best.quantity_;
+                top.askCount_ = best.count_;
+            }
+            return top;
+        }
+
+        /** @return Every level, bids highest first and asks lowest first. */
+        OrderbookLevelInfos GetOrderInfos () const {
+            LevelInfos bidInfos, askInfos;
+            bidInfos.reserve(bids_.Size());
+            askInfos.reserve(asks_.Size());
+
+            bids_.ForEachLevel([&bidInfos](const auto& level) { bidInfos.push_back(LevelInfo{ level.price_, level.quantity_ }); return true; });
+            asks_.ForEachLevel([&askInfos](const auto& level) { askInfos.push_back(LevelInfo{ level.price_, level.quantity_ }); return true; });
+
+            return OrderbookLevelInfos{ bidInfos, askInfos };
+        }
+
+    private:
+        MarketByPriceSide<Side::Buy> bids_;
+        MarketByPriceSide<Side::Sell> asks_;
+        std::uint64_t lastSequence_{ 0 };
+};
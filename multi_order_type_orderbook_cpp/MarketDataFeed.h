@@ -0,0 +1,480 @@
+#pragma once
+
+/**
+ * @file MarketDataFeed.h
+ * @brief UDP market-data ingestion: packet sources, A/B line arbitration and
+ *        zero-copy decoding into command batches.
+ *
+ * A venue publishes the same sequenced packets on two lines, A and B. A
+ * packet is a WirePacket header followed by WireCommand messages (see
+ * WireFormat.h). FeedHandler polls both lines and merges what they delivered
+ * by sequence. It drops whatever the other line already delivered, holds
+ * packets that arrive past a hole until the other line fills it, reports
+ * holes that neither line filled in time as gaps, and decodes each new message once,
+ * straight from the receive buffer. The decoded commands are handed over as
+ * runs per instrument, which the caller passes to its books, e.g. with
+ * ProcessBatch.
+ *
+ * A packet source is anything with
+ *   std::size_t Receive(std::span<std::span<const unsigned char>> packets)
+ * that fills up to packets.size() views of received datagrams without
+ * blocking, each valid until its next Receive:
+ * - MulticastReceiver implements it with recvmmsg.
+ * - A kernel-bypass stack (ef_vi, DPDK, ...) plugs in the same way, with
+ *   views into its own receive ring.
+ * - MemoryPacketSource serves tests and replays.
+ */
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <deque>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "Command.h"
+#include "WireFormat.h"
+
+/**
+ * @brief Non-blocking source of received datagrams (see the file comment).
+ */
+template <typename Source>
+concept PacketSource = requires(Source& source, std::span<std::span<const unsigned char>> packets)
+{
+    { source.Receive(packets) } -> std::convertible_to<std::size_t>;
+};
+
+#ifdef __linux__
+/**
+ * @brief UDP receiver that fetches datagrams in batches with recvmmsg.
+ *
+ * Datagrams land in one preallocated buffer of batchSize slots of packetSize
+ * bytes, and Receive hands out views of it, so nothing is copied or
+ * allocated after construction. Longer datagrams are truncated to
+ * packetSize, and the handler then rejects them as malformed.
+ */
+class MulticastReceiver {
+    public:
+        /**
+         * @param group Multicast group to join, or a unicast address to bind to (e.g. "127.0.0.1").
+         * @param port UDP port; 0 picks a free one (see Port).
+         * @param interfaceAddress Local interface to join the group on.
+         * @param batchSize Datagrams fetched per recvmmsg call at most.
+         * @param packetSize Largest datagram kept whole.
+         * @throws std::runtime_error if the socket cannot be set up.
+         */
+        MulticastReceiver (const std::string& group, std::uint16_t port, const std::string& interfaceAddress = "0.0.0.0",
+            std::size_t batchSize = 64, std::size_t packetSize = 2048)
+            : packetSize_ { packetSize }
+            , buffers_ (batchSize * packetSize)
+            , vectors_ (batchSize)
+            , headers_ (batchSize)
+        {
+            in_addr groupAddress{ };
+            in_addr localAddress{ };
+            if (inet_pton(AF_INET, group.c_str(), &groupAddress) != 1 || inet_pton(AF_INET, interfaceAddress.c_str(), &localAddress) != 1)
+                throw std::runtime_error("Invalid address: " + group + " on " + interfaceAddress);
+
+            socket_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+            if (socket_ < 0)
+                throw std::runtime_error("Cannot create a UDP socket");
+
+            const int enable = 1;
+            const int receiveBuffer = 8 << 20; // Best effort: absorbs bursts between polls
+            setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+            setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+
+            sockaddr_in address{ };
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr = groupAddress;
+            if (bind(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+            {
+                close(socket_);
+                throw std::runtime_error("Cannot bind to " + group + ":" + std::to_string(port));
+            }
+
+            if (IN_MULTICAST(ntohl(groupAddress.s_addr)))
+            {
+                const ip_mreq membership{ groupAddress, localAddress };
+                if (setsockopt(socket_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+                {
+                    close(socket_);
+                    throw std::runtime_error("Cannot join " + group + " on " + interfaceAddress);
+                }
+            }
+
+            for (std::size_t slot = 0; slot < batchSize; ++slot)
+            {
+                vectors_[slot] = iovec{ buffers_.data() + slot * packetSize_, packetSize_ };
+                headers_[slot].msg_hdr.msg_iov = &vectors_[slot];
+                headers_[slot].msg_hdr.msg_iovlen = 1;
+            }
+        }
+
+        MulticastReceiver(const MulticastReceiver&) = delete;
+        void operator=(const MulticastReceiver&) = delete;
+
+        ~MulticastReceiver () { close(socket_); }
+
+        /**
+         * @brief Fetches the datagrams already queued on the socket, without blocking.
+         * @return Number of views written to packets.
+         */
+        std::size_t Receive (std::span<std::span<const unsigned char>> packets) {
+            const auto count = static_cast<unsigned>(std::min(packets.size(), headers_.size()));
+            const int received = recvmmsg(socket_, headers_.data(), count, MSG_DONTWAIT, nullptr);
+            if (received <= 0)
+                return 0;
+
+            for (int index = 0; index < received; ++index)
+                packets[index] = { buffers_.data() + index * packetSize_, headers_[index].msg_len };
+            return static_cast<std::size_t>(received);
+        }
+
+        /** @return Local port the socket is bound to. */
+        std::uint16_t Port () const {
+            sockaddr_in address{ };
+            socklen_t length = sizeof(address);
+            getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+            return ntohs(address.sin_port);
+        }
+
+    private:
+        int socket_ { -1 };
+        std::size_t packetSize_;
+        std::vector<unsigned char> buffers_;
+        std::vector<iovec> vectors_;
+        std::vector<mmsghdr> headers_;
+};
+#endif
+
+/**
+ * @brief In-memory packet source: packets pushed in are received in order.
+ */
+class MemoryPacketSource {
+    public:
+        void Push (std::vector<unsigned char> packet) { queued_.push_back(std::move(packet)); }
+
+        std::size_t Receive (std::span<std::span<const unsigned char>> packets) {
+            delivered_.clear();
+            while (delivered_.size() < packets.size() && !queued_.empty())
+            {
+                delivered_.push_back(std::move(queued_.front()));
+                queued_.pop_front();
+            }
+
+            for (std::size_t index = 0; index < delivered_.size(); ++index)
+                packets[index] = delivered_[index];
+            return delivered_.size();
+        }
+
+    private:
+        std::deque<std::vector<unsigned char>> queued_;
+        std::vector<std::vector<unsigned char>> delivered_; // Backs the views until the next Receive
+};
+
+/**
+ * @brief Consecutive new commands of one instrument, decoded from one packet.
+ */
+struct FeedBatch
+{
+    InstrumentId instrumentId_{ };
+    std::uint64_t sequence_{ };         // Sequence of the first command
+    std::span<const Command> commands_; // Valid during the sink call only
+};
+
+/**
+ * @brief Messages [from_, to_) that neither line delivered.
+ */
+struct FeedGap
+{
+    std::uint64_t from_{ };
+    std::uint64_t to_{ };
+};
+
+struct FeedStats
+{
+    std::uint64_t packets_{ };        // Well-formed packets received on either line
+    std::uint64_t duplicates_{ };     // Packets whose messages had all been applied, or were already held
+    std::uint64_t messages_{ };       // Messages decoded and handed to the batch sink
+    std::uint64_t gaps_{ };
+    std::uint64_t missedMessages_{ }; // Sum of the gaps' lengths
+    std::uint64_t malformed_{ };      // Packets rejected, whole or from a bad message on
+    std::uint64_t held_{ };           // Packets that arrived past a hole and waited in the reorder buffer
+};
+
+/**
+ * @brief Arbitrates lines A and B of a sequenced feed and decodes it into command batches.
+ *
+ * Each Poll receives what both lines have queued, sorts the packets by
+ * sequence (the views stay valid until the next Poll) and applies them in
+ * order. Only messages at or after the next expected sequence are decoded:
+ * a packet the other line already delivered is dropped, and a partly-seen
+ * one contributes only its tail. The first packet ever seen sets the
+ * starting sequence.
+ *
+ * A packet that starts past the expected sequence is copied into a reorder
+ * buffer, and the hole before it stays open: lines are skewed by more than
+ * one poll, so the other line's copy of the missing packet usually comes
+ * later. Held packets are applied as soon as the hole closes. The hole is
+ * reported to the gap sink, and the feed continues from the earliest held
+ * packet, only once it has stayed open through holdPolls further Polls or
+ * the buffer is full. The owner then resynchronises the books from a
+ * snapshot and may call Reset.
+ *
+ * Decoding writes straight from the datagram (or its held copy) into one
+ * reusable command array, and the array's spans go to the batch sink, which
+ * typically calls a book's ProcessBatch. Nothing is allocated per packet:
+ * the reorder buffer's slots are allocated once, at construction.
+ */
+template <PacketSource Source>
+class FeedHandler {
+    public:
+        static constexpr std::size_t PacketsPerPoll = 64; // Per line
+        static constexpr std::size_t DefaultReorderCapacity = 64;
+        static constexpr std::size_t DefaultHoldPolls = 4;
+
+        /**
+         * @param lineB Second line of the same feed, or nullptr for a single line.
+         * @param maxMessagesPerPacket Longer packets are rejected as malformed.
+         * @param reorderCapacity Packets held past a hole at most (0: report holes at once).
+         * @param holdPolls Polls a hole may stay open after the one that found it.
+         */
+        explicit FeedHandler (Source& lineA, Source* lineB = nullptr, std::size_t maxMessagesPerPacket = 64,
+            std::size_t reorderCapacity = DefaultReorderCapacity, std::size_t holdPolls = DefaultHoldPolls)
+            : lines_ { &lineA, lineB }
+            , commands_ (maxMessagesPerPacket)
+            , slotSize_ { WirePacket::HeaderSize + maxMessagesPerPacket * WireCommand::Size }
+            , slotBytes_ (reorderCapacity * slotSize_)
+            , holdPolls_ { holdPolls }
+        {
+            held_.reserve(reorderCapacity);
+            freeSlots_.reserve(reorderCapacity);
+            for (std::size_t slot = reorderCapacity; slot > 0; --slot)
+                freeSlots_.push_back(slot - 1);
+        }
+
+        /**
+         * @brief Applies whatever both lines have received since the last call.
+         * @param batches Invoked as batches(const FeedBatch&) for each run of new commands, in sequence order.
+         * @param gaps Invoked as gaps(const FeedGap&) for each hole neither line filled.
+         * @return Number of packets received on either line.
+         */
+        template <typename BatchSink, typename GapSink>
+        std::size_t Poll (BatchSink&& batches, GapSink&& gaps) {
+            std::size_t count = 0;
+            std::size_t received = 0;
+            for (Source* line : lines_)
+                if (line != nullptr)
+                    received += Collect(*line, count);
+
+            std::sort(pending_.begin(), pending_.begin() + count,
+                [](const Pending& left, const Pending& right) { return left.sequence_ < right.sequence_; });
+
+            for (std::size_t index = 0; index < count; ++index)
+                Accept(pending_[index], batches, gaps);
+
+            // A hole past its window is given up on; a later one gets a window of its own
+            if (held_.empty())
+                holeAge_ = 0;
+            else if (++holeAge_ > holdPolls_)
+            {
+                SkipHole(held_.front().sequence_, gaps);
+                Drain(batches);
+                holeAge_ = 0;
+            }
+
+            return received;
+        }
+
+        /** @return Sequence of the next message expected (0 before the first packet). */
+        std::uint64_t NextSequence () const { return next_; }
+
+        /**
+         * @brief Continues from sequence, e.g. the one after a resynchronising
+         *        snapshot; 0 takes the next packet's sequence. Held packets are dropped.
+         */
+        void Reset (std::uint64_t sequence) {
+            next_ = sequence;
+            for (const Held& packet : held_)
+                freeSlots_.push_back(packet.slot_);
+            held_.clear();
+            holeAge_ = 0;
+        }
+
+        /** @return Packets waiting in the reorder buffer for the hole before them to close. */
+        std::size_t HeldPackets () const { return held_.size(); }
+
+        const FeedStats& GetStats () const { return stats_; }
+
+    private:
+        struct Pending {
+            std::uint64_t sequence_{ };
+            std::uint32_t count_{ };
+            std::span<const unsigned char> bytes_;
+        };
+
+        /** @brief A packet copied into reorder slot slot_; bytes_ views the copy. */
+        struct Held : Pending {
+            std::size_t slot_{ };
+        };
+
+        /** @return Packets received from line; well-formed ones are appended to pending_. */
+        std::size_t Collect (Source& line, std::size_t& count) {
+            const std::size_t received = line.Receive(received_);
+
+            for (std::size_t index = 0; index < received; ++index)
+            {
+                Pending& packet = pending_[count];
+                if (!WirePacket::TryDecodeHeader(received_[index], packet.sequence_, packet.count_) || packet.count_ > commands_.size())
+                {
+                    ++stats_.malformed_;
+                    continue;
+                }
+
+                packet.bytes_ = received_[index];
+                ++stats_.packets_;
+                ++count;
+            }
+
+            return received;
+        }
+
+        /** @brief Applies a packet that continues the feed, or holds one that starts past a hole. */
+        template <typename BatchSink, typename GapSink>
+        void Accept (const Pending& packet, BatchSink& batches, GapSink& gaps) {
+            if (next_ == 0)
+                next_ = packet.sequence_;
+
+            // The other line's copy of a packet already held takes no second slot
+            if (packet.sequence_ > next_ && IsHeld(packet.sequence_))
+            {
+                ++stats_.duplicates_;
+                return;
+            }
+
+            // With the buffer full, give up on the earliest hole to make room
+            while (packet.sequence_ > next_ && freeSlots_.empty())
+            {
+                SkipHole(held_.empty() ? packet.sequence_ : std::min(packet.sequence_, held_.front().sequence_), gaps);
+                Drain(batches);
+            }
+
+            if (packet.sequence_ > next_)
+            {
+                Hold(packet);
+                return;
+            }
+
+            Apply(packet, batches);
+            Drain(batches);
+        }
+
+        /** @return True if a packet starting at sequence waits in the reorder buffer. */
+        bool IsHeld (std::uint64_t sequence) const {
+            const auto position = std::lower_bound(held_.begin(), held_.end(), sequence,
+                [](const Held& held, std::uint64_t value) { return held.sequence_ < value; });
+            return position != held_.end() && position->sequence_ == sequence;
+        }
+
+        /** @brief Copies a packet into a free reorder slot, keeping held_ sorted by sequence. */
+        void Hold (const Pending& packet) {
+            Held held;
+            held.sequence_ = packet.sequence_;
+            held.count_ = packet.count_;
+            held.slot_ = freeSlots_.back();
+            freeSlots_.pop_back();
+
+            const std::size_t size = WirePacket::HeaderSize + std::size_t{ packet.count_ } * WireCommand::Size;
+            unsigned char* copy = slotBytes_.data() + held.slot_ * slotSize_;
+            std::copy_n(packet.bytes_.data(), size, copy);
+            held.bytes_ = { copy, size };
+
+            const auto position = std::upper_bound(held_.begin(), held_.end(), held.sequence_,
+                [](std::uint64_t sequence, const Held& other) { return sequence < other.sequence_; });
+            held_.insert(position, held);
+            ++stats_.held_;
+        }
+
+        /** @brief Applies held packets from the front for as long as they continue the feed. */
+        template <typename BatchSink>
+        void Drain (BatchSink& batches) {
+            std::size_t drained = 0;
+            for (; drained < held_.size() && held_[drained].sequence_ <= next_; ++drained)
+            {
+                Apply(held_[drained], batches);
+                freeSlots_.push_back(held_[drained].slot_);
+            }
+            held_.erase(held_.begin(), held_.begin() + drained);
+        }
+
+        /** @brief Reports [next_, to) as a gap and continues from to. */
+        template <typename GapSink>
+        void SkipHole (std::uint64_t to, GapSink& gaps) {
+            gaps(FeedGap{ next_, to });
+            ++stats_.gaps_;
+            stats_.missedMessages_ += to - next_;
+            next_ = to;
+        }
+
+        /** @brief Decodes the new messages of a packet that starts at or before next_. */
+        template <typename BatchSink>
+        void Apply (const Pending& packet, BatchSink& batches) {
+            if (packet.sequence_ + packet.count_ <= next_)
+            {
+                ++stats_.duplicates_;
+                return;
+            }
+
+            const unsigned char* messages = packet.bytes_.data() + WirePacket::HeaderSize;
+            std::size_t decoded = 0;
+            for (auto index = static_cast<std::size_t>(next_ - packet.sequence_); index < packet.count_; ++index)
+            {
+                if (!WireCommand::TryDecode({ messages + index * WireCommand::Size, WireCommand::Size }, commands_[decoded]))
+                {
+                    // The rest of the packet counts as missing; the next packet reports the gap
+                    ++stats_.malformed_;
+                    break;
+                }
+                ++decoded;
+            }
+
+            // One batch per run of consecutive commands for the same instrument
+            for (std::size_t begin = 0, end = 0; begin < decoded; begin = end)
+            {
+                const InstrumentId instrumentId = commands_[begin].instrumentId_;
+                while (end < decoded && commands_[end].instrumentId_ == instrumentId)
+                    ++end;
+
+                batches(FeedBatch{ instrumentId, next_ + begin, std::span<const Command>{ commands_.data() + begin, end - begin } });
+            }
+
+            next_ += decoded;
+            stats_.messages_ += decoded;
+        }
+
+        std::array<Source*, 2> lines_;
+        std::array<std::span<const unsigned char>, PacketsPerPoll> received_;
+        std::array<Pending, 2 * PacketsPerPoll> pending_;
+        std::vector<Command> commands_;
+        std::size_t slotSize_;                  // Bytes of the longest packet accepted
+        std::vector<unsigned char> slotBytes_;  // Reorder slots, slotSize_ bytes each
+        std::vector<std::size_t> freeSlots_;
+        std::vector<Held> held_;                // Sorted by sequence
+        std::size_t holdPolls_;
+        std::size_t holeAge_{ 0 };              // Polls the current hole has stayed open
+        std::uint64_t next_{ 0 };
+        FeedStats stats_;
+};
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "Command.h"
+#include "GoodForDayTimer.h"
+#include "Journal.h"
+#include "MemoryPlacement.h"
+#include "OrderOwners.h"
+#include "Orderbook.h"
+#include "SpscRing.h"
+#include "ThreadAffinity.h"
+
+/**
+ * @brief Single-writer matching engine: one pinned thread owns a book exclusively.
+ *
+ * Each producer (gateway thread) gets its own lock-free SPSC command ring and
+ * a matching outbound trade ring, so producers never contend with each other
+ * or with the matcher. The matching thread busy-polls the command rings round
+ * robin, applies each drained batch to a lock-free book (SingleWriterTraits)
+ * with one ProcessBatch call, and the book's trade sink pushes each trade
+ * onto the rings of the producers that own its two orders, so a gateway
+ * hears of its passive fills too (see OrderOwners.h). Good‑For‑Day expiry
+ * arrives as a PruneGoodForDay command injected by a timer into a control
+ * ring that the matcher drains with the others.
+ * Expiry runs as commands of BookTraits::ExpirySlice orders, one per poll
+ * after the producers' batches, until it is done; Good‑Till‑Date orders
+ * are expired the same way once the earliest of them is due.
+ *
+ * With a journal attached, every drained batch (control batches included) is
+ * appended to the journal before the book applies it, and RequestSnapshot has
+ * the matcher capture a snapshot between batches for the journal thread to
+ * write. Recover rebuilds the book from both before Start.
+ *
+ * A pinned matcher first places the book and every ring on its core's NUMA
+ * node, pre-faulted and locked (see MemoryPlacement.h), and Start returns
+ * only once that is done, so the first command already runs on resident,
+ * local memory. An unpinned matcher leaves memory where it is.
+ *
+ * Producer i must be a single thread and must keep draining its trade ring:
+ * the matcher never waits on a producer, so a trade that finds the ring full
+ * is dropped and counted (see DroppedTrades). Fills of orders recovered
+ * before Start reach no producer, as their owners are not journaled.
+ */
+template <typename BookTraits = LadderOrderbookTraits>
+class MatchingEngine {
+    public:
+        using Book = BasicOrderbook<SingleWriterTraits<BookTraits>>;
+
+        static_assert(std::same_as<typename BookTraits::Storage, PooledOrderStorage>,
+            "Trade routing indexes owners by slab slot, so the engine needs a pool-backed book.");
+
+        static constexpr std::size_t DefaultRingCapacity = 1 << 16;
+
+        /**
+         * @param producerCount Number of producer threads (one command ring each).
+         * @param core Core to pin the matching thread to; negative leaves it unpinned.
+         * @param ringCapacity Capacity of each command and trade ring (power of two).
+         * @param orderCapacity Orders the book reserves room for.
+         */
+        explicit MatchingEngine (std::size_t producerCount, int core = -1,
+            std::size_t ringCapacity = DefaultRingCapacity,
+            std::size_t orderCapacity = Book::DefaultOrderCapacity)
+            : book_ { orderCapacity }
+            , owners_ { orderCapacity }
+            , control_ { ControlRingCapacity }
+            , core_ { core }
+        {
+            producers_.reserve(producerCount);
+            for (std::size_t producer = 0; producer < producerCount; ++producer)
+                producers_.push_back(std::make_unique<Producer>(ringCapacity));
+        }
+
+        MatchingEngine(const MatchingEngine&) = delete;
+        void operator=(const MatchingEngine&) = delete;
+
+        ~MatchingEngine () { Stop(); }
+
+        /**
+         * @brief Starts the matching thread and the Good‑For‑Day timer once
+         *        the matcher has pinned itself and placed its memory.
+         */
+        void Start () {
+            if (running_.exchange(true))
+                return;
+
+            ready_.store(false);
+            thread_ = std::thread{ [this] { Run(); } };
+            while (!ready_.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            timer_ = std::make_unique<GoodForDayTimer>([this] { control_.TryPush(Command::PruneGoodForDay({ }, BookTraits::ExpirySlice)); });
+        }
+
+        /**
+         * @brief Stops the timer, lets the matcher apply every command already
+         *        submitted, then joins it.
+         */
+        void Stop () {
+            timer_.reset();
+
+            if (!running_.exchange(false))
+                return;
+
+            thread_.join();
+        }
+
+        /**
+         * @brief Producer side: enqueues a command for the matching thread.
+         * @param producer Index of the calling producer.
+         * @return False if the producer's ring is full (nothing was enqueued).
+         */
+        bool Submit (std::size_t producer, const Command& command) {
+            return producers_[producer]->commands_.TryPush(command);
+        }
+
+        /**
+         * @brief Producer side: takes the next trade of an order this producer
+         *        added or modified, whether it was the aggressor or rested.
+         *        A trade between two of its own orders comes once.
+         * @return False if no trade is waiting.
+         */
+        bool PollTrade (std::size_t producer, Trade& trade) {
+            return producers_[producer]->trades_.TryPop(trade);
+        }
+
+        /**
+         * @return Trades dropped so far because the producer's trade ring was full (any thread).
+         */
+        std::uint64_t DroppedTrades (std::size_t producer) const {
+            return producers_[producer]->droppedTrades_.load(std::memory_order_relaxed);
+        }
+
+        std::size_t ProducerCount () const { return producers_.size(); }
+
+        /**
+         * @brief Journals every command the matcher applies. Only before Start().
+         * @param journal Must outlive the engine's run.
+         * @param snapshotPath Where snapshots requested with RequestSnapshot are written.
+         */
+        void AttachJournal (JournalWriter& journal, std::string snapshotPath) {
+            journal_ = &journal;
+            snapshotPath_ = std::move(snapshotPath);
+        }
+
+        /**
+         * @brief Rebuilds the book from a snapshot and journal tail. Only before Start().
+         * @return Position to open the JournalWriter at before attaching it.
+         */
+        JournalPosition Recover (const std::string& snapshotPath, const std::string& journalPath) {
+            return RecoverOrderbook(book_, snapshotPath, journalPath);
+        }
+
+        /**
+         * @brief Asks the matcher to snapshot the book after its current batch
+         *        (any thread; ignored without a journal).
+         */
+        void RequestSnapshot () { snapshotRequested_.store(true, std::memory_order_release); }
+
+        /**
+         * @brief The engine's book; only safe to use while the engine is stopped.
+         */
+        const Book& GetBook () const { return book_; }
+
+        /**
+         * @brief Where the matcher's memory ended up; set by Start, empty if unpinned.
+         */
+        const MemoryPlacement& GetMemoryPlacement () const { return placement_; }
+
+    private:
+        static constexpr std::size_t ControlRingCapacity = 16;
+        static constexpr std::size_t CommandsPerPoll = 64; // Per producer, keeps polling fair
+
+        using ProducerIndex = typename OrderOwners<Book>::ProducerIndex;
+        static constexpr ProducerIndex NoProducer = OrderOwners<Book>::NoProducer;
+
+        struct Producer {
+            explicit Producer (std::size_t capacity)
+                : commands_ { capacity }
+                , trades_ { capacity }
+            { }
+
+            SpscRing<Command> commands_;
+            SpscRing<Trade> trades_;
+            std::atomic<std::uint64_t> droppedTrades_ { 0 };
+        };
+
+        void Run () {
+            if (PinThisThread(core_))
+                PlaceMemory();
+            ready_.store(true, std::memory_order_release);
+
+            while (running_.load(std::memory_order_acquire))
+            {
+                if (!Poll())
+                    CpuRelax();
+            }
+
+            // Apply whatever was submitted before Stop()
+            while (Poll()) { }
+        }
+
+        /**
+         * @brief Moves the book and rings to the matcher's node and makes them resident.
+         */
+        void PlaceMemory () {
+            const int node = NumaNodeOfCore(core_);
+            PlaceMemoryOf(book_, node, placement_);
+            PlaceMemoryOf(control_, node, placement_);
+            for (const auto& producer : producers_)
+            {
+                PlaceMemoryOf(producer->commands_, node, placement_);
+                PlaceMemoryOf(producer->trades_, node, placement_);
+            }
+        }
+
+        void Deliver (ProducerIndex producer, const Trade& trade) {
+            if (producer == NoProducer)
+                return;
+
+            auto& target = *producers_[producer];
+            if (!target.trades_.TryPush(trade))
+                target.droppedTrades_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /** @return True if any command was applied. */
+        bool Poll () {
+            bool worked = false;
+
+            std::size_t count = 0;
+            while (count < ControlRingCapacity && control_.TryPop(batch_[count]))
+                ++count;
+            worked |= Execute(NoProducer, count);
+
+            for (std::size_t producer = 0; producer < producers_.size(); ++producer)
+            {
+                count = 0;
+                while (count < CommandsPerPoll && producers_[producer]->commands_.TryPop(batch_[count]))
+                    ++count;
+                worked |= Execute(static_cast<ProducerIndex>(producer), count);
+            }
+
+            worked |= ExpireOrders();
+
+            if (snapshotRequested_.load(std::memory_order_relaxed) && snapshotRequested_.exchange(false) && journal_ != nullptr)
+                journal_->SubmitSnapshot(SnapshotImage::Capture(book_, journal_->LastSequence()), snapshotPath_);
+
+            return worked;
+        }
+
+        /**
+         * @brief Applies the next slice of a Good‑For‑Day expiry in progress and
+         *        of any Good‑Till‑Date orders due now.
+         * @return True if there was anything to expire.
+         */
+        bool ExpireOrders () {
+            std::size_t count = 0;
+            if (book_.IsExpiringGoodForDay())
+                batch_[count++] = Command::PruneGoodForDay({ }, BookTraits::ExpirySlice);
+
+            const Expiry next = book_.NextExpiry();
+            if (next != Constants::NoExpiry)
+            {
+                const Expiry now = ToExpiry(std::chrono::system_clock::now());
+                if (next <= now)
+                    batch_[count++] = Command::ExpireGoodTillDate(now, { }, BookTraits::ExpirySlice);
+            }
+
+            return Execute(NoProducer, count);
+        }
+
+        /**
+         * @param producer Producer that sent the batch, NoProducer for control commands.
+         * @return True if the batch was not empty.
+         */
+        bool Execute (ProducerIndex producer, std::size_t count) {
+            if (count == 0)
+                return false;
+
+            const std::span<const Command> commands{ batch_.data(), count };
+            if (journal_ != nullptr)
+                journal_->Append(commands);
+
+            if (producer != NoProducer)
+                owners_.Claim(book_, producer, commands);
+
+            book_.ProcessBatch(commands, [this](const Trade& trade)
+            {
+                const ProducerIndex bidOwner = owners_.OwnerOf(book_, trade.GetBidTrade().orderId_);
+                const ProducerIndex askOwner = owners_.OwnerOf(book_, trade.GetAskTrade().orderId_);
+
+                Deliver(bidOwner, trade);
+                if (askOwner != bidOwner)
+                    Deliver(askOwner, trade);
+            });
+
+            owners_.Place(book_, commands);
+            return true;
+        }
+
+        Book book_;
+        OrderOwners<Book> owners_;                  // Matching thread only
+        std::vector<std::unique_ptr<Producer>> producers_;
+        SpscRing<Command> control_; // Single producer: the timer thread
+        std::unique_ptr<GoodForDayTimer> timer_;
+        std::array<Command, CommandsPerPoll> batch_; // Matching thread only
+        JournalWriter* journal_ { nullptr };
+        std::string snapshotPath_;
+        std::atomic<bool> snapshotRequested_ { false };
+        std::atomic<bool> running_ { false };
+        std::atomic<bool> ready_ { false };
+        MemoryPlacement placement_;
+        int core_;
+        std::thread thread_;
+};
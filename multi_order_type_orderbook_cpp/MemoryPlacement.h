@@ -0,0 +1,127 @@
+#pragma once
+
+/**
+ * @file MemoryPlacement.h
+ * @brief Helpers for memory a pinned thread owns: NUMA placement, pre-faulting and locking.
+ *
+ * A pinned thread calls PlaceMemory on each region it will touch on the hot
+ * path (see the ForEachMemoryRegion visitors of the book, the rings and the
+ * indices) before it starts polling, so trading never takes a page fault or
+ * reaches across the interconnect for its own data. Everything is best
+ * effort and recorded in a MemoryPlacement; on platforms other than Linux
+ * the calls only count bytes.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief What placement achieved, summed over every region placed with it.
+ */
+struct MemoryPlacement
+{
+    std::size_t bytes_{ };         // Bytes placed, rounded out to whole pages
+    std::size_t movedBytes_{ };    // Bound to (and migrated onto) the requested node
+    std::size_t lockedBytes_{ };   // Resident and locked with mlock
+    std::size_t residentBytes_{ }; // Resident, locked or not
+};
+
+/**
+ * @return NUMA node of a CPU core, or -1 if unknown (negative core, no NUMA
+ *         information, or not Linux).
+ */
+inline int NumaNodeOfCore(int core)
+{
+#ifdef __linux__
+    if (core < 0)
+        return -1;
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator{ "/sys/devices/system/cpu/cpu" + std::to_string(core), error })
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.starts_with("node"))
+            return std::stoi(name.substr(4));
+    }
+#else
+    (void)core;
+#endif
+    return -1;
+}
+
+/**
+ * @brief Makes the pages covering [data, data + size) resident on node.
+ *
+ * In order: ranges of at least one huge page are advised to use transparent
+ * huge pages; the range gets a preferred policy for node and its existing
+ * pages are migrated there; the range is locked, which also faults in every
+ * page. If locking is refused (RLIMIT_MEMLOCK), the pages are populated
+ * without it. Pages are shared with whatever else lies in them, so adjacent
+ * data is placed too.
+ * @param node NUMA node, or negative to leave placement to the kernel.
+ */
+inline void PlaceMemory(const void* data, std::size_t size, int node, MemoryPlacement& placement)
+{
+    if (size == 0)
+        return;
+
+#ifdef __linux__
+    const auto page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<std::uintptr_t>(data) & ~(page - 1);
+    const auto end = (reinterpret_cast<std::uintptr_t>(data) + size + page - 1) & ~(page - 1);
+    void* address = reinterpret_cast<void*>(begin);
+    const std::size_t length = end - begin;
+    placement.bytes_ += length;
+
+#ifdef MADV_HUGEPAGE
+    constexpr std::size_t HugePageSize = std::size_t{ 2 } << 20;
+    if (length >= HugePageSize)
+        madvise(address, length, MADV_HUGEPAGE);
+#endif
+
+    // mbind(2) without libnuma: MPOL_PREFERRED, MPOL_MF_MOVE
+    constexpr int PreferredPolicy = 1;
+    constexpr unsigned MoveExisting = 1u << 1;
+    if (node >= 0 && node < 63)
+    {
+        const unsigned long nodeMask = 1ul << node;
+        if (syscall(SYS_mbind, address, length, PreferredPolicy, &nodeMask, sizeof(nodeMask) * 8, MoveExisting) == 0)
+            placement.movedBytes_ += length;
+    }
+
+    if (mlock(address, length) == 0)
+    {
+        placement.lockedBytes_ += length;
+        placement.residentBytes_ += length;
+    }
+#ifdef MADV_POPULATE_WRITE
+    else if (madvise(address, length, MADV_POPULATE_WRITE) == 0)
+        placement.residentBytes_ += length;
+#endif
+#else
+    (void)data;
+    (void)node;
+    placement.bytes_ += size;
+#endif
+}
+
+/**
+ * @brief Places every region an object visits with ForEachMemoryRegion.
+ */
+template <typename Owner>
+void PlaceMemoryOf(const Owner& owner, int node, MemoryPlacement& placement)
+{
+    owner.ForEachMemoryRegion([node, &placement](const void* data, std::size_t size)
+    {
+        PlaceMemory(data, size, node, placement);
+    });
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <list>
 #include <exception>
 #include <sstream>
@@ -16,6 +18,16 @@
  * Tracks order details (type, ID, side, price, quantity) and manages 
  * remaining quantity after fills. Supports converting market orders to 
  * Good‑Till‑Cancel orders.
+ *
+ * Layout: the fields matching reads and writes (id, price, remaining
+ * quantity) fill the first 16 bytes; the ones only read on entry, cancel,
+ * amend and snapshot follow, the 16-bit account in what was padding. 32
+ * bytes in all, so a pooled slot stays small (see OrderPool::Slot).
+ *
+ * The 64-bit expiry word is only an expiry for Good‑Till‑Date orders. Stop
+ * orders keep their stop price in it and icebergs their display quantity
+ * (low half) and hidden reserve (high half), so commands, journals and
+ * snapshots, which carry the word as is, need no extra fields for them.
  */
 class Order {
     public:
@@ -26,15 +38,19 @@ class Order {
          * @param side Buy or sell side
          * @param price Price for limit orders, Constants::InvalidPrice for market orders
          * @param quantity Total quantity of the order
+         * @param expiry When a GoodTillDate order expires (ignored by other types)
+         * @param account Owner, for self-trade prevention and risk limits (see AccountRisk.h)
          */
-        Order (OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity)
-            : orderType_ {orderType}
-            , orderId_ {orderId}
-            , side_ {side}
+        Order (OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity, Expiry expiry = Constants::NoExpiry,
+            AccountId account = Constants::NoAccount)
+            : orderId_ {orderId}
             , price_ {price}
-            , quantity_ {quantity}
-            , initialQuantity_ {quantity}
             , remainingQuantity_ {quantity}
+            , initialQuantity_ {quantity}
+            , orderType_ {orderType}
+            , side_ {side}
+            , account_ {account}
+            , expiry_ {expiry}
         {}
 
         /**
@@ -47,6 +63,30 @@ class Order {
         : Order(OrderType::Market, orderId, side, Constants::InvalidPrice, quantity)
         {}
 
+        /**
+         * @brief Builds a stop order: a Market order once a trade reaches stopPrice
+         *        (at or above it for a buy, at or below it for a sell).
+         */
+        static Order Stop (OrderId orderId, Side side, Price stopPrice, Quantity quantity, AccountId account = Constants::NoAccount) {
+            return Order{ OrderType::Stop, orderId, side, Constants::InvalidPrice, quantity, StopWord(stopPrice), account };
+        }
+
+        /**
+         * @brief Builds a stop-limit order: a Good‑Till‑Cancel order at price once a trade reaches stopPrice.
+         */
+        static Order StopLimit (OrderId orderId, Side side, Price stopPrice, Price price, Quantity quantity,
+            AccountId account = Constants::NoAccount) {
+            return Order{ OrderType::StopLimit, orderId, side, price, quantity, StopWord(stopPrice), account };
+        }
+
+        /**
+         * @brief Builds an iceberg order that shows at most displayQuantity of quantity at a time.
+         */
+        static Order Iceberg (OrderId orderId, Side side, Price price, Quantity quantity, Quantity displayQuantity,
+            AccountId account = Constants::NoAccount) {
+            return Order{ OrderType::Iceberg, orderId, side, price, quantity, Expiry{ displayQuantity }, account };
+        }
+
         /** @return Unique order ID. */
         OrderId GetOrderId () const { return orderId_; }
 
@@ -59,16 +99,37 @@ class Order {
         /** @return Type of the order (Market, Limit, etc.). */
         OrderType GetOrderType() const { return orderType_; }
 
+        /**
+         * @return Expiry time of a GoodTillDate order (Constants::NoExpiry for most
+         *         others); the encoded stop price or iceberg quantities for those types.
+         */
+        Expiry GetExpiry() const { return expiry_; }
+
+        /** @return Price a trade must reach for a Stop or StopLimit order to trigger. */
+        Price GetStopPrice() const { return static_cast<Price>(static_cast<std::uint32_t>(expiry_)); }
+
+        /** @return Most an Iceberg order shows at a time. */
+        Quantity GetDisplayQuantity() const { return static_cast<Quantity>(expiry_); }
+
+        /** @return Quantity an Iceberg order holds back beyond what it shows (0 for other types). */
+        Quantity GetHiddenQuantity() const { return orderType_ == OrderType::Iceberg ? static_cast<Quantity>(expiry_ >> 32) : 0; }
+
+        /** @return Quantity the order may still trade: what it shows plus any hidden reserve. */
+        Quantity GetOpenQuantity() const { return GetRemainingQuantity() + GetHiddenQuantity(); }
+
+        /** @return Account that owns the order (Constants::NoAccount if none). */
+        AccountId GetAccount() const { return account_; }
+
         /** @return Original total quantity of the order. */
         Quantity GetInitialQuantity() const { return initialQuantity_; }
 
-        /** @return Quantity still unfilled. */
+        /** @return Quantity still unfilled (for an iceberg, of the part it shows). */
         Quantity GetRemainingQuantity() const {return remainingQuantity_;}
 
         /** @return Quantity that has been filled so far. */
-        Quantity GetFilledQuantity() const { return GetInitialQuantity() - GetRemainingQuantity(); }
+        Quantity GetFilledQuantity() const { return GetInitialQuantity() - GetOpenQuantity(); }
 
-        /** @return True if the order is completely filled. */
+        /** @return True if the order is completely filled (for an iceberg, the part it shows). */
         bool IsFilled() const { return GetRemainingQuantity() == 0; }
 
         /**
@@ -86,6 +147,22 @@ class Order {
             remainingQuantity_ -= quantity;
         }
 
+        /**
+         * @brief Lowers the unfilled quantity in place (an amend that keeps time priority).
+         * @param quantity New remaining quantity (must not exceed remaining quantity)
+         * @throws std::logic_error if quantity > remaining quantity
+         */
+        void ReduceQuantity (Quantity quantity) {
+            if (quantity > GetRemainingQuantity()) {
+                std::stringstream ss;
+                ss << "Order (" << orderId_ << ") cannot be reduced to quantity (" << quantity << ") greater than remaining quantity (" << GetRemainingQuantity() << ")";
+                throw std::logic_error(ss.str());
+            }
+
+            initialQuantity_ -= GetRemainingQuantity() - quantity;
+            remainingQuantity_ = quantity;
+        }
+
         /**
          * @brief Converts a market order into a Good‑Till‑Cancel order with a specified price.
          * @param price New limit price for the order
@@ -102,16 +179,74 @@ class Order {
             orderType_ = OrderType::GoodTillCancel;
         }
 
+        /**
+         * @brief Turns a triggered stop order into the order it enters the book as:
+         *        Market for Stop, Good‑Till‑Cancel at its limit price for StopLimit.
+         * @throws std::logic_error if the order is not a stop order
+         */
+        void Trigger () {
+            if (GetOrderType() != OrderType::Stop && GetOrderType() != OrderType::StopLimit) {
+                std::stringstream ss;
+                ss << "Order (" << orderId_ << ") cannot be triggered, only stop orders can.";
+                throw std::logic_error(ss.str());
+            }
+
+            orderType_ = GetOrderType() == OrderType::Stop ? OrderType::Market : OrderType::GoodTillCancel;
+            expiry_ = Constants::NoExpiry;
+        }
+
+        /**
+         * @brief Moves all but the display quantity of an entering iceberg's
+         *        remaining quantity into its hidden reserve.
+         * @throws std::logic_error if the order is not an iceberg
+         */
+        void HideReserve () {
+            if (GetOrderType() != OrderType::Iceberg) {
+                std::stringstream ss;
+                ss << "Order (" << orderId_ << ") cannot hide quantity, only iceberg orders can.";
+                throw std::logic_error(ss.str());
+            }
+
+            const Quantity shown = std::min(GetDisplayQuantity(), GetRemainingQuantity());
+            SetIcebergWord(GetDisplayQuantity(), GetRemainingQuantity() - shown);
+            remainingQuantity_ = shown;
+        }
+
+        /**
+         * @brief Shows the next display quantity of a filled iceberg from its reserve.
+         * @throws std::logic_error if the order is not a filled iceberg with a reserve
+         */
+        void Replenish () {
+            if (!IsFilled() || GetHiddenQuantity() == 0) {
+                std::stringstream ss;
+                ss << "Order (" << orderId_ << ") cannot be replenished, only filled iceberg orders with a reserve can.";
+                throw std::logic_error(ss.str());
+            }
+
+            const Quantity shown = std::min(GetDisplayQuantity(), GetHiddenQuantity());
+            SetIcebergWord(GetDisplayQuantity(), GetHiddenQuantity() - shown);
+            remainingQuantity_ = shown;
+        }
+
     private:
-        OrderType orderType_;
+        static Expiry StopWord (Price stopPrice) { return static_cast<std::uint32_t>(stopPrice); }
+
+        void SetIcebergWord (Quantity display, Quantity hidden) { expiry_ = Expiry{ hidden } << 32 | display; }
+
+        // Hot: touched by every match
         OrderId orderId_;
-        Side side_;
         Price price_;
-        Quantity quantity_;
-        Quantity initialQuantity_;
         Quantity remainingQuantity_;
-        
-};      
+
+        // Cold
+        Quantity initialQuantity_;
+        OrderType orderType_;
+        Side side_;
+        AccountId account_;
+        Expiry expiry_;
+};
+
+static_assert(sizeof(Order) == 32, "Order layout grew; pooled slots and images depend on it");
 
 using OrderPointer = std::shared_ptr<Order>;
 using OrderPointers = std::list<OrderPointer>;
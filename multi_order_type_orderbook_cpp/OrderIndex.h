@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "Usings.h"
+
+/**
+ * @brief Order id -> storage entry index: open addressing with linear probing.
+ *
+ * Slots are a power-of-two size and aligned to it, so no slot straddles a
+ * cache line and a probe that moves on usually stays in the same line (four
+ * slots per line for pooled entries). Ids are hashed with a Fibonacci
+ * multiply, which spreads dense, monotonically increasing ids as well as
+ * ids that differ only in their high bits (e.g. per-gateway prefixes).
+ *
+ * Deletion shifts the following run back instead of leaving tombstones, so
+ * probe lengths stay short however much the book churns and Extract finds
+ * and removes an order in one probe sequence. The table stays at most half
+ * full; it only allocates when it grows past the capacity it was reserved for.
+ *
+ * The largest OrderId marks free slots; an order with that id is kept in a
+ * dedicated out-of-table slot.
+ */
+template <typename Entry>
+class FlatOrderIndex {
+    public:
+        explicit FlatOrderIndex (std::size_t capacity = 0) { Reserve(capacity); }
+
+        /** @brief Makes room for count orders without further allocation. */
+        void Reserve (std::size_t count) {
+            const std::size_t needed = std::bit_ceil(std::max<std::size_t>(2 * count, MinimumSlots));
+            if (needed > slots_.size())
+                Rehash(needed);
+        }
+
+        std::size_t Size () const { return size_; }
+
+        /** @return Orders the table holds before it has to grow. */
+        std::size_t Capacity () const { return slots_.size() / 2; }
+        bool Empty () const { return size_ == 0; }
+
+        bool Contains (OrderId orderId) const { return Find(orderId) != nullptr; }
+
+        /** @return The order's entry, or nullptr if it is not indexed. */
+        Entry* Find (OrderId orderId) {
+            return const_cast<Entry*>(std::as_const(*this).Find(orderId));
+        }
+
+        const Entry* Find (OrderId orderId) const {
+            if (orderId == EmptyKey)
+                return hasEmptyKey_ ? &emptyKeyEntry_ : nullptr;
+
+            for (std::size_t index = Home(orderId); ; index = (index + 1) & mask_)
+            {
+                const Slot& slot = slots_[index];
+                if (slot.orderId_ == orderId)
+                    return &slot.entry_;
+                if (slot.orderId_ == EmptyKey)
+                    return nullptr;
+            }
+        }
+
+        /**
+         * @brief Indexes an order that is not indexed yet (the caller checks).
+         */
+        void Insert (OrderId orderId, const Entry& entry) {
+            if (orderId == EmptyKey)
+            {
+                hasEmptyKey_ = true;
+                emptyKeyEntry_ = entry;
+                ++size_;
+                return;
+            }
+
+            if (2 * (size_ + 1) > slots_.size())
+                Rehash(2 * slots_.size());
+
+            std::size_t index = Home(orderId);
+            while (slots_[index].orderId_ != EmptyKey)
+                index = (index + 1) & mask_;
+
+            slots_[index].orderId_ = orderId;
+            slots_[index].entry_ = entry;
+            ++size_;
+        }
+
+        /**
+         * @brief Finds and removes an order in one probe sequence.
+         * @return False (entry untouched) if the order is not indexed.
+         */
+        bool Extract (OrderId orderId, Entry& entry) {
+            if (orderId == EmptyKey)
+            {
+                if (!hasEmptyKey_)
+                    return false;
+
+                entry = std::exchange(emptyKeyEntry_, Entry{ });
+                hasEmptyKey_ = false;
+                --size_;
+                return true;
+            }
+
+            std::size_t index = Home(orderId);
+            while (slots_[index].orderId_ != orderId)
+            {
+                if (slots_[index].orderId_ == EmptyKey)
+                    return false;
+                index = (index + 1) & mask_;
+            }
+
+            entry = std::move(slots_[index].entry_);
+            EraseAt(index);
+            return true;
+        }
+
+        /** @return False if the order was not indexed. */
+        bool Erase (OrderId orderId) {
+            Entry entry;
+            return Extract(orderId, entry);
+        }
+
+        /** @brief Invokes function(orderId, entry) for every indexed order, in no particular order. */
+        template <typename Function>
+        void ForEach (Function&& function) const {
+            for (const Slot& slot : slots_)
+                if (slot.orderId_ != EmptyKey)
+                    function(slot.orderId_, slot.entry_);
+
+            if (hasEmptyKey_)
+                function(EmptyKey, emptyKeyEntry_);
+        }
+
+        /** @brief Invokes function(data, size) for the slot table (see MemoryPlacement.h). */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&& function) const {
+            function(static_cast<const void*>(slots_.data()), slots_.size() * sizeof(Slot));
+        }
+
+    private:
+        static constexpr OrderId EmptyKey = std::numeric_limits<OrderId>::max();
+        static constexpr std::size_t MinimumSlots = 16;
+        static constexpr std::size_t SlotSize = std::bit_ceil(sizeof(OrderId) + sizeof(Entry));
+
+        struct alignas(SlotSize) Slot {
+            OrderId orderId_{ EmptyKey };
+            Entry entry_{ };
+        };
+
+        std::size_t Home (OrderId orderId) const {
+            return static_cast<std::size_t>((orderId * 0x9E3779B97F4A7C15ull) >> shift_);
+        }
+
+        /**
+         * @brief Empties a slot, moving later members of its run back so every
+         *        id stays reachable from its home without tombstones.
+         */
+        void EraseAt (std::size_t hole) {
+            for (std::size_t index = (hole + 1) & mask_; slots_[index].orderId_ != EmptyKey; index = (index + 1) & mask_)
+            {
+                // The id at index may fill the hole unless its home lies cyclically in (hole, index]
+                const std::size_t home = Home(slots_[index].orderId_);
+                const bool staysPut = hole <= index
+                    ? hole < home && home <= index
+                    : hole < home || home <= index;
+                if (staysPut)
+                    continue;
+
+                slots_[hole] = std::move(slots_[index]);
+                hole = index;
+            }
+
+            slots_[hole] = Slot{ };
+            --size_;
+        }
+
+        void Rehash (std::size_t slotCount) {
+            std::vector<Slot> previous(slotCount);
+            previous.swap(slots_);
+            mask_ = slotCount - 1;
+            shift_ = 64 - std::countr_zero(slotCount);
+
+            size_ = hasEmptyKey_ ? 1 : 0;
+            for (Slot& slot : previous)
+                if (slot.orderId_ != EmptyKey)
+                    Insert(slot.orderId_, std::move(slot.entry_));
+        }
+
+        std::vector<Slot> slots_;
+        std::size_t mask_{ 0 };
+        int shift_{ 64 };
+        std::size_t size_{ 0 };
+        bool hasEmptyKey_{ false };
+        Entry emptyKeyEntry_{ };
+};
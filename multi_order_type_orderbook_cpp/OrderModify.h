@@ -47,6 +47,17 @@ class OrderModify {
             return std::make_shared<Order> (type, GetOrderId(), GetSide(), GetPrice(), GetQuantity());
         }
 
+        /**
+         * @brief Creates a new Order value from this modification request (no allocation).
+         * @param type Order type for the new order (e.g., GoodTillCancel, FillAndKill).
+         * @param expiry Expiry carried over from the order being replaced.
+         * @param account Account carried over from the order being replaced.
+         * @return The newly created Order.
+         */
+        Order ToOrder (OrderType type, Expiry expiry = Constants::NoExpiry, AccountId account = Constants::NoAccount) const {
+            return Order{ type, GetOrderId(), GetSide(), GetPrice(), GetQuantity(), expiry, account };
+        }
+
     private:
         OrderId orderId_;
         Price price_;
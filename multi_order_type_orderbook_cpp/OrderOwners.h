@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "Command.h"
+#include "OrderIndex.h"
+#include "OrderPool.h"
+
+/**
+ * @brief Which producer submitted each order of one book, so a trade can be
+ *        routed to the owners of both of its orders.
+ *
+ * Owners are kept in a table indexed by the order's slab slot (see
+ * BasicOrderbook::SlotOf), which needs no cleanup as orders leave: an entry
+ * also holds its order id, so one left behind by an order that has since
+ * left the slot is told apart. A batch's new orders are claimed by id before
+ * the book applies it, because they may trade before their slot is recorded,
+ * and are moved to the table afterwards. Only the thread that applies the
+ * book's commands may use it.
+ */
+template <typename Book>
+class OrderOwners {
+    public:
+        using ProducerIndex = std::uint32_t;
+        static constexpr ProducerIndex NoProducer = std::numeric_limits<ProducerIndex>::max();
+
+        /** @param capacity Orders the book reserves room for. */
+        explicit OrderOwners (std::size_t capacity)
+            : owners_ ( capacity )
+        { }
+
+        /**
+         * @brief Claims the orders a producer's batch adds or replaces before the
+         *        book applies it, so their trades are routed while their slots are unknown.
+         *        A modify of anything but a resting order changes nothing, so claims nothing.
+         */
+        void Claim (const Book& book, ProducerIndex producer, std::span<const Command> commands) {
+            for (const auto& command : commands)
+            {
+                if (command.type_ != CommandType::Add
+                    && (command.type_ != CommandType::Modify || book.SlotOf(command.orderId_) == OrderPool::InvalidSlot))
+                    continue;
+
+                if (ProducerIndex* owner = unplaced_.Find(command.orderId_))
+                    *owner = producer;
+                else
+                    unplaced_.Insert(command.orderId_, producer);
+            }
+        }
+
+        /**
+         * @brief Moves the claims of a batch just applied to the owner table.
+         *        Pending stops stay claimed until they enter the book and trade
+         *        or are cancelled; every other claim is settled here.
+         */
+        void Place (const Book& book, std::span<const Command> commands) {
+            for (const auto& command : commands)
+            {
+                if (command.type_ == CommandType::Cancel)
+                {
+                    unplaced_.Erase(command.orderId_);
+                    continue;
+                }
+
+                if (command.type_ != CommandType::Add && command.type_ != CommandType::Modify)
+                    continue;
+
+                // A modify left without a slot never claimed its id; leave a pending stop's claim alone
+                const OrderSlot slot = book.SlotOf(command.orderId_);
+                if (slot == OrderPool::InvalidSlot && command.type_ == CommandType::Modify)
+                    continue;
+
+                ProducerIndex producer;
+                if (!unplaced_.Extract(command.orderId_, producer))
+                    continue;
+
+                if (slot != OrderPool::InvalidSlot)
+                    Record(slot, command.orderId_, producer);
+                else if (command.orderType_ == OrderType::Stop || command.orderType_ == OrderType::StopLimit)
+                    unplaced_.Insert(command.orderId_, producer);
+            }
+        }
+
+        /**
+         * @return Producer that owns an order being matched, or NoProducer for
+         *         one no producer submitted (e.g. recovered).
+         */
+        ProducerIndex OwnerOf (const Book& book, OrderId orderId) {
+            const OrderSlot slot = book.SlotOf(orderId);
+
+            if (slot == OrderPool::InvalidSlot)
+                return NoProducer;
+
+            ProducerIndex producer;
+            if (unplaced_.Extract(orderId, producer))
+            {
+                Record(slot, orderId, producer);
+                return producer;
+            }
+
+            if (slot < owners_.size() && owners_[slot].orderId_ == orderId)
+                return owners_[slot].producer_;
+            return NoProducer;
+        }
+
+    private:
+        /**
+         * @brief Who submitted the order now in a slot.
+         */
+        struct Owner {
+            OrderId orderId_ { };
+            ProducerIndex producer_ { NoProducer };
+        };
+
+        void Record (OrderSlot slot, OrderId orderId, ProducerIndex producer) {
+            if (slot >= owners_.size())
+                owners_.resize(std::max<std::size_t>(slot + 1, 2 * owners_.size()));
+            owners_[slot] = Owner{ orderId, producer };
+        }
+
+        std::vector<Owner> owners_;                 // By slab slot
+        FlatOrderIndex<ProducerIndex> unplaced_;    // Owners of orders whose slot is not recorded yet
+};
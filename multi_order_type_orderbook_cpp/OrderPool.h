@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <span>
+#include <algorithm>
+#include <cstddef>
+
+#include "Order.h"
+
+using OrderSlot = std::uint32_t;
+
+/**
+ * @brief Preallocated slab of Order objects linked into intrusive price-level FIFOs.
+ *
+ * Orders are addressed by slot index rather than by pointer, so links stay valid
+ * if the slab ever has to grow. Released slots are kept on a free list and reused,
+ * which means a book that stays within its reserved capacity never allocates.
+ */
+class OrderPool {
+    public:
+        static constexpr OrderSlot InvalidSlot = std::numeric_limits<OrderSlot>::max();
+
+        /**
+         * @brief One pooled order plus its neighbours in the price-level FIFO.
+         *
+         * The links come first so they sit next to the order's hot fields:
+         * walking and matching a level reads the first 24 of the slot's 40 bytes.
+         * While a slot is on the free list, next_ links to the next free slot.
+         */
+        struct Slot {
+            OrderSlot prev_ { InvalidSlot };
+            OrderSlot next_ { InvalidSlot };
+            Order order_;
+        };
+
+        /**
+         * @brief Intrusive FIFO of the orders resting at one price level (oldest first).
+         */
+        struct Queue {
+            OrderSlot head_ { InvalidSlot };
+            OrderSlot tail_ { InvalidSlot };
+
+            /** @return True if no order rests at this level. */
+            bool empty() const { return head_ == InvalidSlot; }
+        };
+
+        /**
+         * @brief Constructs a pool with room for the given number of orders.
+         * @param capacity Number of slots reserved up front.
+         */
+        explicit OrderPool (std::size_t capacity) {
+            slots_.reserve(capacity);
+        }
+
+        /**
+         * @brief Copies an order into a free slot (reusing released slots first).
+         * @param order Order to store.
+         * @return Index of the slot now holding the order.
+         */
+        OrderSlot Allocate (const Order& order) {
+            if (freeHead_ != InvalidSlot) {
+                const OrderSlot slot = freeHead_;
+                Slot& entry = slots_[slot];
+                freeHead_ = entry.next_;
+                entry.order_ = order;
+                entry.prev_ = InvalidSlot;
+                entry.next_ = InvalidSlot;
+                return slot;
+            }
+
+            slots_.push_back(Slot{ InvalidSlot, InvalidSlot, order });
+            return static_cast<OrderSlot>(slots_.size() - 1);
+        }
+
+        /**
+         * @brief Returns a slot to the free list. The slot must already be unlinked.
+         */
+        void Release (OrderSlot slot) {
+            slots_[slot].next_ = freeHead_;
+            freeHead_ = slot;
+        }
+
+        /** @return Order held in the given slot. */
+        Order& Get (OrderSlot slot) { return slots_[slot].order_; }
+
+        /** @return Order held in the given slot. */
+        const Order& Get (OrderSlot slot) const { return slots_[slot].order_; }
+
+        /** @return Slot queued behind the given one, or InvalidSlot at the tail. */
+        OrderSlot Next (OrderSlot slot) const { return slots_[slot].next_; }
+
+        /**
+         * @brief Appends a slot to the back of a price-level FIFO.
+         */
+        void PushBack (Queue& queue, OrderSlot slot) {
+            Slot& entry = slots_[slot];
+            entry.prev_ = queue.tail_;
+            entry.next_ = InvalidSlot;
+
+            if (queue.tail_ != InvalidSlot)
+                slots_[queue.tail_].next_ = slot;
+            else
+                queue.head_ = slot;
+
+            queue.tail_ = slot;
+        }
+
+        /**
+         * @brief Removes a slot from anywhere in a price-level FIFO in O(1).
+         */
+        void Unlink (Queue& queue, OrderSlot slot) {
+            Slot& entry = slots_[slot];
+
+            if (entry.prev_ != InvalidSlot)
+                slots_[entry.prev_].next_ = entry.next_;
+            else
+                queue.head_ = entry.next_;
+
+            if (entry.next_ != InvalidSlot)
+                slots_[entry.next_].prev_ = entry.prev_;
+            else
+                queue.tail_ = entry.prev_;
+
+            entry.prev_ = InvalidSlot;
+            entry.next_ = InvalidSlot;
+        }
+
+        /** @return Number of slots reserved without reallocation. */
+        std::size_t Capacity() const { return slots_.capacity(); }
+
+        /**
+         * @brief Invokes function(data, size) for the slab's whole reserved
+         *        capacity, slots not handed out yet included (see MemoryPlacement.h).
+         */
+        template <typename Function>
+        void ForEachMemoryRegion(Function&& function) const {
+            function(static_cast<const void*>(slots_.data()), slots_.capacity() * sizeof(Slot));
+        }
+
+        /** @return Every slot handed out so far, free ones included (for imaging the pool). */
+        std::span<const Slot> Slots() const { return slots_; }
+
+        /** @return First slot of the free list, or InvalidSlot. */
+        OrderSlot FreeHead() const { return freeHead_; }
+
+        /**
+         * @brief Replaces the pool's content with slots from an image in one bulk copy.
+         *
+         * Links are slot indices, so the copied FIFOs and free list stay valid
+         * wherever the slots end up.
+         * @param slots Slots as returned by Slots() (Slot is trivially copyable).
+         * @param freeHead First free slot, as returned by FreeHead().
+         */
+        void Adopt(std::span<const Slot> slots, OrderSlot freeHead) {
+            slots_.reserve(std::max(slots_.capacity(), slots.size()));
+            slots_.assign(slots.begin(), slots.end());
+            freeHead_ = freeHead;
+        }
+
+    private:
+        std::vector<Slot> slots_;
+        OrderSlot freeHead_ { InvalidSlot };
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <iterator>
+#include <cstddef>
+
+#include "Order.h"
+#include "OrderPool.h"
+
+/**
+ * @brief Order storage policies used by BasicOrderbook.
+ *
+ * A storage policy decides how resting orders are held: the per-price-level
+ * FIFO type (Queue), the handle the book keeps per order id (Entry), and how
+ * orders are inserted, reached and removed. Both policies expose the same
+ * member functions so the book's matching logic is written once.
+ *
+ * Bytes per resting order on a 64-bit build, allocator overhead aside, with
+ * the id index at its maximum load of one order per two slots:
+ * - Shared: 48 (make_shared block: control block + 32-byte Order)
+ *   + 32 (list node) + 64 (two 32-byte index slots) = 144.
+ * - Pooled: 40 (slab slot) + 32 (two 16-byte index slots) = 72.
+ */
+
+/**
+ * @brief Original storage: shared_ptr<Order> held in a std::list per price level.
+ */
+class SharedOrderStorage {
+    public:
+        using Queue = OrderPointers;
+
+        /**
+         * @brief Associates an order with its iterator in the price-level list for quick removal.
+         */
+        struct Entry {
+            OrderPointer order_{ nullptr };
+            OrderPointers::iterator location_;
+        };
+
+        /** @brief Capacity is not used; list nodes are allocated per order. */
+        explicit SharedOrderStorage (std::size_t) { }
+
+        /** @brief Appends the caller's order object itself to the level. */
+        Entry Insert (Queue& queue, const OrderPointer& order) {
+            queue.push_back(order);
+            return Entry{ order, std::prev(queue.end()) };
+        }
+
+        /** @brief Appends a heap copy of the order to the level. */
+        Entry Insert (Queue& queue, const Order& order) {
+            return Insert(queue, std::make_shared<Order>(order));
+        }
+
+        /** @brief Unlinks the order from its level. */
+        void Erase (Queue& queue, const Entry& entry) { queue.erase(entry.location_); }
+
+        /** @brief Relinks the order behind the rest of its level; the node and entry stay valid. */
+        void MoveToBack (Queue& queue, const Entry& entry) { queue.splice(queue.end(), queue, entry.location_); }
+
+        /** @return Handle of the oldest order at the level (level must not be empty). */
+        Entry Front (Queue& queue) const { return Entry{ queue.front(), queue.begin() }; }
+
+        /** @return True if no order rests at the level. */
+        bool Empty (const Queue& queue) const { return queue.empty(); }
+
+        Order& Get (const Entry& entry) { return *entry.order_; }
+        const Order& Get (const Entry& entry) const { return *entry.order_; }
+
+        /** @brief Invokes function with each order at the level, oldest first. */
+        template <typename Function>
+        void ForEach (const Queue& queue, Function&& function) const {
+            for (const auto& order : queue)
+                function(*order);
+        }
+
+        /** @brief Orders and list nodes are allocated one by one, so there is no region to visit. */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&&) const { }
+};
+
+/**
+ * @brief Pool-backed storage: orders live in an OrderPool slab and levels are
+ *        intrusive FIFOs of slot indices, so add/cancel/match never allocate.
+ */
+class PooledOrderStorage {
+    public:
+        using Queue = OrderPool::Queue;
+
+        /**
+         * @brief Slot index of the order; the slot also carries its FIFO links.
+         */
+        struct Entry {
+            OrderSlot slot_{ OrderPool::InvalidSlot };
+        };
+
+        /** @param capacity Number of orders the slab holds before it has to grow. */
+        explicit PooledOrderStorage (std::size_t capacity)
+            : pool_{ capacity }
+        { }
+
+        /** @brief Copies the order into a pooled slot; the caller's object is not retained. */
+        Entry Insert (Queue& queue, const OrderPointer& order) {
+            return Insert(queue, *order);
+        }
+
+        /** @brief Copies the order into a pooled slot at the back of the level. */
+        Entry Insert (Queue& queue, const Order& order) {
+            const OrderSlot slot = pool_.Allocate(order);
+            pool_.PushBack(queue, slot);
+            return Entry{ slot };
+        }
+
+        /** @brief Unlinks the order from its level and returns the slot to the pool. */
+        void Erase (Queue& queue, const Entry& entry) {
+            pool_.Unlink(queue, entry.slot_);
+            pool_.Release(entry.slot_);
+        }
+
+        /** @brief Relinks the order behind the rest of its level, in the same slot. */
+        void MoveToBack (Queue& queue, const Entry& entry) {
+            pool_.Unlink(queue, entry.slot_);
+            pool_.PushBack(queue, entry.slot_);
+        }
+
+        /** @return Handle of the oldest order at the level (level must not be empty). */
+        Entry Front (const Queue& queue) const { return Entry{ queue.head_ }; }
+
+        /** @return True if no order rests at the level. */
+        bool Empty (const Queue& queue) const { return queue.empty(); }
+
+        Order& Get (const Entry& entry) { return pool_.Get(entry.slot_); }
+        const Order& Get (const Entry& entry) const { return pool_.Get(entry.slot_); }
+
+        /** @brief Invokes function with each order at the level, oldest first. */
+        template <typename Function>
+        void ForEach (const Queue& queue, Function&& function) const {
+            for (OrderSlot slot = queue.head_; slot != OrderPool::InvalidSlot; slot = pool_.Next(slot))
+                function(pool_.Get(slot));
+        }
+
+        /** @brief Visits the slab (see MemoryPlacement.h). */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&& function) const { pool_.ForEachMemoryRegion(function); }
+
+        /** @return The slab itself, for imaging and adopting (see BookImage.h). */
+        OrderPool& Pool () { return pool_; }
+        const OrderPool& Pool () const { return pool_; }
+
+    private:
+        OrderPool pool_;
+};
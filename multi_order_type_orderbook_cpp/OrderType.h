@@ -1,3 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
 /**
  * @brief Defines the lifespan and execution behavior of an order.
  * 
@@ -6,11 +10,20 @@
  * - FillOrKill: Must be filled completely immediately; otherwise cancelled.
  * - GoodForDay: Active only until the end of the trading day.
  * - Market: Executes immediately at the best available price (no limit).
+ * - GoodTillDate: Active until its expiry time (an order without one is rejected).
+ * - Stop: Waits off the book until a trade reaches its stop price, then enters as a Market order.
+ * - StopLimit: Like Stop, but enters as a Good‑Till‑Cancel order at its limit price.
+ * - Iceberg: Good‑Till‑Cancel order that shows only its display quantity and
+ *   refills it from a hidden reserve, at the back of its level, as it fills.
  */
-enum class OrderType {
+enum class OrderType : std::uint8_t {
     GoodTillCancel,
     FillAndKill,
     FillOrKill,
     GoodForDay,
-    Market
+    Market,
+    GoodTillDate,
+    Stop,
+    StopLimit,
+    Iceberg
 };
\ No newline at end of file
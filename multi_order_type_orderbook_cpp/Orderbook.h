@@ -1,32 +1,72 @@
 #pragma once
 
-#include <map>
-#include <unordered_map>
+#include <algorithm>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <concepts>
+#include <stdexcept>
 
 #include "Usings.h"
+#include "AccountRisk.h"
+#include "BookImage.h"
+#include "Command.h"
+#include "DurableFile.h"
+#include "DepthSnapshot.h"
+#include "ExpiryIndex.h"
+#include "Instrumentation.h"
+#include "LevelUpdate.h"
 #include "Order.h"
+#include "OrderIndex.h"
 #include "OrderModify.h"
 #include "OrderbookLevelInfos.h"
+#include "OrderbookTraits.h"
+#include "SeqLock.h"
+#include "SpscRing.h"
+#include "StopIndex.h"
+#include "TopOfBook.h"
 #include "Trade.h"
 
+/**
+ * @brief Thread-safe wrapper for localtime (Windows/POSIX compatible).
+ */
+std::tm safe_localtime(std::time_t t);
+
+/**
+ * @brief Returns the next 16:00 local time strictly after now, when Good‑For‑Day orders expire.
+ */
+std::chrono::system_clock::time_point NextGoodForDayCutoff(std::chrono::system_clock::time_point now);
+
 /**
  * @brief Central limit order book managing bids/asks, order matching, and order lifecycle.
+ *
+ * The book is parameterized on a traits type (see OrderbookTraits.h) selecting
+ * how resting orders are stored and which container holds the price levels.
+ * Use the Orderbook / PooledOrderbook / LadderOrderbook aliases.
  */
-class Orderbook
+template <typename Traits>
+class BasicOrderbook
 {
 private:
 
+    using Storage = typename Traits::Storage;
+    using OrderQueue = typename Storage::Queue;
+
     /**
-     * @brief Associates an order with its iterator in the price-level list for quick removal.
+     * @brief Handle to a resting order (shared_ptr + list iterator, or pool slot index).
      */
-    struct OrderEntry
-    {
-        OrderPointer order_{ nullptr };
-        OrderPointers::iterator location_;
-    };
+    using OrderEntry = typename Storage::Entry;
 
     /**
      * @brief Aggregated quantity and order count at a price level (used for Fill‑Or‑Kill checks).
@@ -35,26 +75,50 @@ private:
     {
         Quantity quantity_{ }; // Total remaining quantity at this price
         Quantity count_{ };    // Number of orders at this price
+        Quantity hidden_{ };   // Iceberg reserves behind quantity_, which only CanFullyFill looks at
 
         enum class Action
         {
             Add,
             Remove,
             Match,
+            Replenish, // More quantity, same order count
         };
     };
 
-    std::unordered_map<Price, LevelData> data_;
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
-    std::unordered_map<OrderId, OrderEntry> orders_;
-    mutable std::mutex ordersMutex_;
-    std::thread ordersPruneThread_;
-    std::condition_variable shutdownConditionVariable_;
+    /**
+     * @brief One price level: its FIFO of orders and the running aggregates kept beside it.
+     */
+    struct PriceLevel
+    {
+        OrderQueue orders_;
+        LevelData data_;
+    };
+
+    Storage storage_;
+    typename Traits::template Levels<PriceLevel, Side::Buy> bids_;
+    typename Traits::template Levels<PriceLevel, Side::Sell> asks_;
+    FlatOrderIndex<OrderEntry> orders_;
+    ExpiryIndex expiries_;
+    StopIndex stops_;
+    std::optional<Price> lastTradePrice_; // Price of the last trade, at the resting order's price
+    AccountRisk accounts_;
+    mutable typename Traits::Mutex ordersMutex_;
+    [[no_unique_address]] typename Traits::Instrumentation instrumentation_;
+    SeqLock<DepthSnapshot<Traits::DepthLevels>> depth_;
+    bool depthDirty_{ false }; // Levels changed since depth_ was last published
+    SeqLock<PublishedTopOfBook> topOfBook_; // Aligned and padded to its own cache line by SeqLock
+    PublishedTopOfBook lastTopOfBook_;      // Writer's copy of the last value stored in topOfBook_
+    SpscRing<LevelUpdate> levelUpdates_{ Traits::LevelUpdateCapacity > 0 ? Traits::LevelUpdateCapacity : 1 };
+    std::uint64_t levelUpdateSequence_{ }; // Sequence of the last update emitted
+    std::condition_variable_any shutdownConditionVariable_;
     std::atomic<bool> shutdown_{ false };
+    std::chrono::system_clock::time_point pruneWakeup_{ }; // When the prune thread next wakes (under the lock)
+    std::thread ordersPruneThread_;
 
     /**
-     * @brief Background task that cancels all Good‑For‑Day orders at 16:00.
+     * @brief Background task that cancels all Good‑For‑Day orders at 16:00 and
+     *        Good‑Till‑Date orders as they expire.
      */
     void PruneGoodForDayOrders();
 
@@ -63,78 +127,2086 @@ private:
      */
     void CancelOrders(OrderIds orderIds);
 
+    /**
+     * @brief Acquires ordersMutex_, recording the wait when instrumented.
+     */
+    std::unique_lock<typename Traits::Mutex> LockOrders();
+
+    /**
+     * @brief The levels of side S; Opposite<S> is the side its orders trade against.
+     */
+    template <Side S>
+    auto& LevelsOf() { if constexpr (S == Side::Buy) return bids_; else return asks_; }
+
+    template <Side S>
+    const auto& LevelsOf() const { if constexpr (S == Side::Buy) return bids_; else return asks_; }
+
+    template <Side S>
+    static constexpr Side Opposite = S == Side::Buy ? Side::Sell : Side::Buy;
+
+    /**
+     * @return True if an order of side S limited at price trades with an opposite order resting at restingPrice.
+     */
+    template <Side S>
+    static constexpr bool Reaches(Price price, Price restingPrice)
+    {
+        if constexpr (S == Side::Buy)
+            return price >= restingPrice;
+        else
+            return price <= restingPrice;
+    }
+
     /**
      * @brief Internal order cancellation (assumes ordersMutex_ is held).
      */
     void CancelOrderInternal(OrderId orderId);
 
+    /**
+     * @brief Takes an order already extracted from orders_ off its level on side S.
+     */
+    template <Side S>
+    void RemoveOrder(const OrderEntry& entry);
+
+    /**
+     * @brief Internal Good‑For‑Day expiry (assumes ordersMutex_ is held).
+     *
+     * Seals the resting Good‑For‑Day orders unless an expiry is already in
+     * progress, then cancels up to limit of them (0: every one, sealed or not).
+     */
+    void CancelGoodForDayOrdersInternal(Quantity limit);
+
+    /**
+     * @brief Internal Good‑Till‑Date expiry: cancels up to limit (0: all)
+     *        orders expiring at or before now (assumes ordersMutex_ is held).
+     */
+    void ExpireOrdersInternal(Expiry now, Quantity limit);
+
+    /**
+     * @brief Internal order insertion and matching (assumes ordersMutex_ is held).
+     *
+     * Dispatches once on the order's side and type to AddOrderOfType, so each
+     * combination runs its own straight-line path.
+     * @param order Order to add; market orders are converted in place.
+     * @param source What the storage inserts: the caller's OrderPointer or the order value.
+     * @param sink Receives each resulting trade.
+     */
+    template <typename OrderSource, TradeSink Sink>
+    void AddOrderInternal(Order& order, const OrderSource& source, Sink& sink);
+
+    template <Side S, typename OrderSource, TradeSink Sink>
+    void AddOrderOnSide(Order& order, const OrderSource& source, Sink& sink);
+
+    /**
+     * @brief Adds an order known to be of side S and type Type (assumes ordersMutex_ is held).
+     */
+    template <Side S, OrderType Type, typename OrderSource, TradeSink Sink>
+    void AddOrderOfType(Order& order, const OrderSource& source, Sink& sink);
+
+    /**
+     * @brief Enters every pending stop the last trade price has reached (assumes ordersMutex_ is held).
+     */
+    template <TradeSink Sink>
+    void TriggerStops(Sink& sink);
+
+    /**
+     * @brief Internal modify (assumes ordersMutex_ is held).
+     *
+     * Quantity-down amends at the same side and price are applied in place and
+     * keep time priority; anything else is a cancel + add that loses it, and
+     * is risk-checked before the original is cancelled.
+     */
+    template <TradeSink Sink>
+    void ModifyOrderInternal(const OrderModify& order, Sink& sink);
+
+    /**
+     * @brief Moves a resting expiring order to the back of its expiry list, or
+     *        of the sealed Good‑For‑Day list (assumes ordersMutex_ is held).
+     * @return False if no such order rests, it does not expire, or it is sealed but not Good‑For‑Day.
+     */
+    bool RequeueExpiry(OrderId orderId, bool sealed);
+
+    /**
+     * @brief Internal SetAccountLimits (assumes ordersMutex_ is held and account is not Constants::NoAccount).
+     */
+    void SetAccountLimitsInternal(AccountId account, const AccountLimits& limits);
+
+    /**
+     * @brief Applies one command (assumes ordersMutex_ is held).
+     */
+    template <TradeSink Sink>
+    void ProcessCommandInternal(const Command& command, Sink& sink);
+
     // Callbacks to update level data on order events
-    void OnOrderCancelled(OrderPointer order);
-    void OnOrderAdded(OrderPointer order);
-    void OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled);
+    void OnOrderCancelled(PriceLevel& level, const Order& order);
+    void OnOrderAdded(PriceLevel& level, const Order& order);
+    void OnOrderMatched(PriceLevel& level, const Order& order, Quantity quantity, bool isFullyFilled);
+    void OnOrderReduced(PriceLevel& level, const Order& order, Quantity quantity);
+
+    /**
+     * @brief Emits the new state of a level to the level-update ring (assumes ordersMutex_ is held).
+     */
+    void EmitLevelUpdate(Side side, Price price, const LevelData& data);
+
+    /**
+     * @brief Republishes the top of book and the depth if any level changed (assumes ordersMutex_ is held).
+     */
+    void PublishDepth();
+
+    /**
+     * @brief Reads the best level of each side from its running aggregates (assumes ordersMutex_ is held).
+     */
+    TopOfBook ReadTopOfBook() const;
+
+    /**
+     * @brief Updates aggregated quantity and order count of a price level.
+     */
+    void UpdateLevelData(LevelData& data, Quantity quantity, typename LevelData::Action action);
+
+    /**
+     * @brief Checks whether a Fill‑Or‑Kill order of side S can be fully filled.
+     *
+     * Walks the opposite side from the touch and stops at the limit price or
+     * once enough quantity is found, so cost is O(levels crossed). An order
+     * with an account walks the orders of those levels instead, O(orders
+     * crossed): its own orders yield nothing under self-trade prevention, and
+     * unless its mode cancels them, meeting one stops the fill.
+     */
+    template <Side S>
+    bool CanFullyFill(Price price, Quantity quantity, AccountId account) const;
+
+    /**
+     * @brief Checks whether an order of side S at the given price can match at all.
+     */
+    template <Side S>
+    bool CanMatch(Price price) const;
+
+    /**
+     * @brief Unlinks an order from its level after a trade filled it.
+     */
+    void RemoveFilled(PriceLevel& level, const OrderEntry& entry, const Order& order);
 
     /**
-     * @brief Updates aggregated quantity and order count at a price level.
+     * @brief Cancels an order during matching, leaving its level for MatchOrders to erase.
      */
-    void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action);
+    void CancelFromLevel(PriceLevel& level, const OrderEntry& entry, const Order& order);
 
     /**
-     * @brief Checks whether a Fill‑Or‑Kill order can be fully filled.
+     * @brief Shows the next slice of a filled iceberg and requeues it at the back of its level.
      */
-    bool CanFullyFill(Side side, Price price, Quantity quantity) const;
+    void Replenish(PriceLevel& level, const OrderEntry& entry, Order& order);
 
     /**
-     * @brief Checks whether any match is possible at the given price.
+     * @brief Resolves a cross between two orders of one account as the aggressor's
+     *        account asks (see SelfTradePrevention) instead of trading them.
      */
-    bool CanMatch(Side side, Price price) const;
+    void PreventSelfTrade(PriceLevel& aggressorLevel, const OrderEntry& aggressorEntry, Order& aggressor,
+        PriceLevel& restingLevel, const OrderEntry& restingEntry, Order& resting);
 
     /**
      * @brief Matches orders at the current best bid/ask until no further matches.
+     *
+     * Called right after an order of side S was added; that order is the only
+     * one at its side's best level, so it is the aggressor in any self-trade.
+     * @param sink Receives each generated trade.
      */
-    Trades MatchOrders();
+    template <Side S, TradeSink Sink>
+    void MatchOrders(Sink& sink);
 
 public:
 
     /**
-     * @brief Constructor – starts the background pruning thread.
+     * @brief Fixed-size top-of-book view published after every change (see GetDepth).
      */
-    Orderbook();
+    using Depth = DepthSnapshot<Traits::DepthLevels>;
+
+    /**
+     * @brief Default number of orders a book reserves room for at construction.
+     */
+    static constexpr std::size_t DefaultOrderCapacity = 1 << 16;
+
+    /**
+     * @brief Constructor – starts the background pruning thread (if the traits enable it).
+     * @param orderCapacity Orders to reserve room for (pool slots, index buckets).
+     */
+    explicit BasicOrderbook(std::size_t orderCapacity = DefaultOrderCapacity);
 
     // Disable copying and moving (book is a unique resource)
-    Orderbook(const Orderbook&) = delete;
-    void operator=(const Orderbook&) = delete;
-    Orderbook(Orderbook&&) = delete;
-    void operator=(Orderbook&&) = delete;
+    BasicOrderbook(const BasicOrderbook&) = delete;
+    void operator=(const BasicOrderbook&) = delete;
+    BasicOrderbook(BasicOrderbook&&) = delete;
+    void operator=(BasicOrderbook&&) = delete;
 
     /**
      * @brief Destructor – signals shutdown and joins pruning thread.
      */
-    ~Orderbook();
+    ~BasicOrderbook();
 
     /**
      * @brief Adds an order to the book, performs market‑order conversion, and triggers matching.
+     *
+     * Stop and StopLimit orders are held off the book until a trade reaches
+     * their stop price; the trades of the stops a call triggers are returned with its own.
      * @return Trades generated by this addition.
      */
     Trades AddOrder(OrderPointer order);
 
+    /**
+     * @brief Adds an order given by value; pool-backed books copy it into a slot without allocating.
+     * @return Trades generated by this addition.
+     */
+    Trades AddOrder(const Order& order);
+
+    /**
+     * @brief Adds an order, appending its trades to a reusable buffer (not cleared).
+     */
+    void AddOrder(OrderPointer order, Trades& trades);
+    void AddOrder(const Order& order, Trades& trades);
+
+    /**
+     * @brief Adds an order, passing each trade to sink as it is generated.
+     *
+     * The sink is called under the book's lock and must not call back into the book.
+     */
+    template <TradeSink Sink>
+    void AddOrder(OrderPointer order, Sink&& sink);
+    template <TradeSink Sink>
+    void AddOrder(const Order& order, Sink&& sink);
+
     /**
      * @brief Cancels an order by ID.
      */
     void CancelOrder(OrderId orderId);
 
     /**
-     * @brief Modifies an existing order (cancel + add new).
+     * @brief Modifies an existing order under a single lock acquisition.
+     *
+     * Lowering the quantity at the same side and price amends the order in place
+     * and keeps its queue position; other changes cancel it and add the new one.
+     * Pending stop orders are not found: cancel and re-add them.
      * @return Trades resulting from the modified order.
      */
     Trades ModifyOrder(OrderModify order);
 
     /**
-     * @brief Returns the total number of orders currently in the book.
+     * @brief Modifies an order, appending its trades to a reusable buffer (not cleared).
+     */
+    void ModifyOrder(const OrderModify& order, Trades& trades);
+
+    /**
+     * @brief Modifies an order, passing each trade to sink (under the lock) as it is generated.
+     */
+    template <TradeSink Sink>
+    void ModifyOrder(const OrderModify& order, Sink&& sink);
+
+    /**
+     * @brief Applies a batch of commands in order under a single lock acquisition.
+     *
+     * Each command keeps the semantics of the corresponding AddOrder / CancelOrder /
+     * ModifyOrder / CancelGoodForDayOrders call. Command::instrumentId_ is ignored.
+     * @param commands Commands to apply, oldest first.
+     * @param trades Buffer all resulting trades are appended to (it is not cleared).
+     */
+    void ProcessBatch(std::span<const Command> commands, Trades& trades);
+
+    /**
+     * @brief Applies a batch of commands, passing each trade to sink (under the lock).
+     */
+    template <TradeSink Sink>
+    void ProcessBatch(std::span<const Command> commands, Sink&& sink);
+
+    /**
+     * @brief Cancels every Good‑For‑Day order resting when it is called.
+     *
+     * Runs in slices of Traits::ExpirySlice orders, taking the lock once per
+     * slice, so other calls interleave with a large expiry; orders added
+     * meanwhile are not cancelled. Called by the prune thread at 16:00; books
+     * without one (Traits::PruneThread is false) rely on their owner to call
+     * it or to apply PruneGoodForDay commands.
+     */
+    void CancelGoodForDayOrders();
+
+    /**
+     * @brief Cancels every Good‑Till‑Date order expiring at or before now,
+     *        in slices like CancelGoodForDayOrders.
+     */
+    void ExpireOrders(Expiry now);
+
+    /**
+     * @return Earliest expiry of a resting Good‑Till‑Date order, or Constants::NoExpiry.
+     */
+    Expiry NextExpiry() const;
+
+    /**
+     * @return True while a Good‑For‑Day expiry started by a sliced
+     *         PruneGoodForDay command has orders left to cancel.
+     */
+    bool IsExpiringGoodForDay() const;
+
+    /**
+     * @brief Invokes visitor with every resting order under the lock: bids best
+     *        first, then asks best first, oldest first within a level, then
+     *        the pending stop orders in trigger order.
+     *
+     * Restoring the visited orders in the same sequence with RestoreOrder
+     * rebuilds an identical book, time priority included (see Snapshot.h).
+     */
+    template <typename Visitor>
+    void ForEachOrder(Visitor&& visitor) const;
+
+    /**
+     * @brief Invokes function(data, size) for the book object and every array
+     *        it preallocates: the id index, the pool slab, ladder windows, the expiry links and
+     *        the level-update ring. Memory allocated per order or per level
+     *        (Shared storage, map levels, ladder overflow) is not visited.
+     *
+     * Lets the owning thread place, pre-fault and lock the book's memory
+     * before trading (see MemoryPlacement.h). Does not lock; call it before
+     * the book is shared.
+     */
+    template <typename Function>
+    void ForEachMemoryRegion(Function&& function) const;
+
+    /**
+     * @brief Rests an order at the back of its level without matching, keeping
+     *        its filled quantity (and an iceberg its reserve), or queues a
+     *        stop order as pending. Used to load snapshots.
+     * @throws std::logic_error if the id is in use, the order is filled, a
+     *         market order or a Good‑Till‑Date order without expiry, or it
+     *         would cross the book.
+     */
+    void RestoreOrder(const Order& order);
+
+    /**
+     * @return Price of the last trade, which pending stops trigger against, if any traded yet.
+     */
+    std::optional<Price> GetLastTradePrice() const;
+
+    /**
+     * @brief Sets the last trade price without triggering anything; stops
+     *        added afterwards are checked against it. Used to load snapshots.
+     */
+    void RestoreLastTradePrice(std::optional<Price> price);
+
+    /**
+     * @brief Invokes function(orderId, sealed) under the lock for every
+     *        resting Good‑For‑Day and Good‑Till‑Date order, in the order
+     *        expiry takes them; sealed marks those of a Good‑For‑Day expiry
+     *        in progress, which come first.
+     */
+    template <typename Function>
+    void ForEachExpiringOrder(Function&& function) const;
+
+    /**
+     * @brief Moves a resting order to the back of its expiry list, or of the
+     *        sealed Good‑For‑Day list if sealed. Used to load snapshots:
+     *        doing so for every order ForEachExpiringOrder visited, in the same
+     *        sequence, restores expiry order and an expiry in progress.
+     * @throws std::logic_error if no such order rests, it does not expire,
+     *         or it is sealed but not Good‑For‑Day.
+     */
+    void RestoreExpiryPosition(OrderId orderId, bool sealed);
+
+    /**
+     * @brief Writes the pool slab, level FIFOs and aggregates to a flat file
+     *        (see BookImage.h). Pool-backed books only.
+     * @param sequence Stored with the image, e.g. the journal sequence it reflects.
+     * @throws std::logic_error if stop orders are pending (they live outside the slab).
+     * @throws std::runtime_error on I/O failure.
+     */
+    void WriteImage(const std::string& path, std::uint64_t sequence = 0) const
+        requires std::same_as<typename Traits::Storage, PooledOrderStorage>;
+
+    /**
+     * @brief Maps an image written by WriteImage and adopts it: the slab is
+     *        copied in bulk and only levels are reinserted, no order is re-added
+     *        or matched. The image may come from a book with other level traits.
+     * @return The sequence stored with the image.
+     * @throws std::logic_error if the book is not empty.
+     * @throws std::runtime_error if the file is not a valid image (the book is left empty).
+     */
+    std::uint64_t AdoptImage(const std::string& path)
+        requires std::same_as<typename Traits::Storage, PooledOrderStorage>;
+
+    /**
+     * @return Slab slot of a resting order, or OrderPool::InvalidSlot if none
+     *         rests with that id. Pool-backed books only. Does not lock: for the
+     *         book's owner thread, or a trade sink while the order is matched.
+     *         A slot is reused once its order leaves, so a side table indexed by
+     *         slot needs no cleanup (see MatchingEngine).
+     */
+    OrderSlot SlotOf(OrderId orderId) const
+        requires std::same_as<typename Traits::Storage, PooledOrderStorage>;
+
+    /**
+     * @brief Returns the total number of orders currently in the book, pending stops included.
      */
     std::size_t Size() const;
 
+    /**
+     * @brief Sets the pre-trade limits and self-trade prevention mode of an account.
+     *
+     * Orders that would take the account past a limit are rejected on entry.
+     * The first call for an account starts tracking it (and any lower id not
+     * yet tracked) from its resting orders, at a position of zero. Send
+     * Command::SetAccountLimits instead where commands are journaled.
+     * @throws std::logic_error for Constants::NoAccount.
+     */
+    void SetAccountLimits(AccountId account, const AccountLimits& limits);
+
+    /**
+     * @brief Invokes function(account, limits, exposure) under the lock for
+     *        every account id the limits table covers, lowest first.
+     */
+    template <typename Function>
+    void ForEachAccount(Function&& function) const;
+
+    /**
+     * @brief Sets an account's limits as SetAccountLimits does, then its
+     *        position. Used to load snapshots; restoring accounts before the
+     *        orders leaves their working quantities to be counted as they rest.
+     * @throws std::logic_error for Constants::NoAccount.
+     */
+    void RestoreAccount(AccountId account, const AccountLimits& limits, std::int64_t position);
+
+    /**
+     * @return The account's working quantities, notional and position since it was first limited.
+     */
+    AccountExposure GetAccountExposure(AccountId account) const;
+
+    /**
+     * @brief Returns the best bid and ask with their quantities and order counts.
+     *
+     * Takes the lock and costs O(1): the level aggregates are kept as orders
+     * change, so no order or deeper level is touched. Threads polling the top
+     * should use GetPublishedTopOfBook, which does not contend with matching.
+     */
+    TopOfBook GetTopOfBook() const;
+
     /**
      * @brief Returns a snapshot of the current order book (price levels with aggregated quantities).
+     *
+     * Takes the lock and costs O(levels); prefer GetDepth for frequent top-of-book reads.
      */
     OrderbookLevelInfos GetOrderInfos() const;
+
+    /**
+     * @brief Returns a full snapshot together with the sequence of the last level update it includes.
+     *
+     * A level-update consumer that detects a gap resynchronises from this
+     * snapshot and then applies only updates with a higher sequence.
+     */
+    OrderbookLevelInfos GetOrderInfos(std::uint64_t& lastSequence) const;
+
+    /**
+     * @brief Takes the oldest pending level update. Only one thread may poll.
+     * @return False if no update is waiting.
+     */
+    bool PollLevelUpdate(LevelUpdate& update) { return levelUpdates_.TryPop(update); }
+
+    /**
+     * @brief Returns the best Traits::DepthLevels levels of each side without taking the lock.
+     *
+     * The view is republished through a seqlock at the end of every call that
+     * changes the book (once per ProcessBatch), so readers on other threads get
+     * a consistent copy and never block the matcher. A side with more levels
+     * than that is marked truncated (see DepthSnapshot::Truncated).
+     */
+    Depth GetDepth() const { return depth_.Load(); }
+
+    /**
+     * @brief Quantity within the published depth that an order of side limited
+     *        at price could trade with (see DepthKernels.h). Lock-free, like GetDepth.
+     *
+     * Only the best Traits::DepthLevels opposite levels count: when the
+     * opposite side is truncated (GetDepth().Truncated) and price reaches past
+     * the last published level, the book holds more than this returns.
+     */
+    Quantity GetQuantityUpTo(Side side, Price price) const { return GetDepth().QuantityUpTo(side, price); }
+
+    /**
+     * @brief Fill quantity, worst price and VWAP of an order of side for quantity
+     *        sweeping the published depth. Lock-free, like GetDepth.
+     *
+     * Only the best Traits::DepthLevels opposite levels are swept: a result
+     * short of quantity with truncated_ set ran out of published levels, not
+     * of liquidity, and the true cost lies beyond worstPrice_.
+     */
+    SweepCost GetSweepCost(Side side, Quantity quantity) const { return GetDepth().Sweep(side, quantity); }
+
+    /**
+     * @brief Returns the best bid and ask as last published, without taking the lock.
+     *
+     * The value is republished with the depth, but only when the top itself
+     * changed, into a seqlock on a cache line of its own: any number of
+     * threads can poll it without touching the matcher's lines, and a reader
+     * retries only while a 32-byte store is in progress.
+     */
+    PublishedTopOfBook GetPublishedTopOfBook() const { return topOfBook_.Load(); }
+
+    /**
+     * @brief The book's instrumentation (Traits::Instrumentation), e.g. for
+     *        OrderbookInstrumentation::Snapshot from a monitoring thread.
+     */
+    const typename Traits::Instrumentation& GetInstrumentation() const { return instrumentation_; }
 };
+
+/**
+ * @brief Original book: shared_ptr orders held in std::list price levels.
+ */
+using Orderbook = BasicOrderbook<SharedOrderbookTraits>;
+
+/**
+ * @brief Pool-backed book: orders live in a preallocated slab, levels are intrusive FIFOs.
+ */
+using PooledOrderbook = BasicOrderbook<PooledOrderbookTraits>;
+
+/**
+ * @brief Pool-backed book with tick-indexed ladder levels instead of std::map.
+ */
+using LadderOrderbook = BasicOrderbook<LadderOrderbookTraits>;
+
+/**
+ * @brief Background thread routine that expires orders: Good‑For‑Day at 16:00
+ *        each day, Good‑Till‑Date when the earliest of them is due.
+ *
+ * Sleeps until whichever comes first; adding an earlier Good‑Till‑Date order
+ * wakes it to sleep for less (see AddOrderInternal).
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::PruneGoodForDayOrders()
+{
+	using namespace std::chrono;
+
+	while (true)
+	{
+		const auto cutoff = NextGoodForDayCutoff(system_clock::now()) + milliseconds(100);
+
+		{
+			std::unique_lock ordersLock{ ordersMutex_ };
+
+			const Expiry nextExpiry = expiries_.NextExpiry();
+			pruneWakeup_ = nextExpiry == Constants::NoExpiry ? cutoff : std::min(cutoff, FromExpiry(nextExpiry));
+
+			shutdownConditionVariable_.wait_until(ordersLock, pruneWakeup_, [this]
+				{
+					const Expiry next = expiries_.NextExpiry();
+					return shutdown_.load(std::memory_order_acquire)
+						|| (next != Constants::NoExpiry && FromExpiry(next) < pruneWakeup_);
+				});
+
+			if (shutdown_.load(std::memory_order_acquire))
+				return;
+		}
+
+		const auto now = system_clock::now();
+		if (now >= cutoff)
+			CancelGoodForDayOrders();
+
+		ExpireOrders(ToExpiry(now));
+	}
+}
+
+/**
+ * @brief Seals the resting Good‑For‑Day orders and cancels them a slice per lock.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::CancelGoodForDayOrders()
+{
+	bool expiring;
+	do
+	{
+		[[maybe_unused]] const auto ordersLock = LockOrders();
+
+		CancelGoodForDayOrdersInternal(Traits::ExpirySlice);
+		PublishDepth();
+		expiring = expiries_.IsExpiringGoodForDay();
+	} while (expiring);
+}
+
+/**
+ * @brief Cancels sealed Good‑For‑Day orders, oldest first (assumes ordersMutex_ is held).
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::CancelGoodForDayOrdersInternal(Quantity limit)
+{
+	if (!expiries_.IsExpiringGoodForDay())
+		expiries_.SealGoodForDay();
+
+	OrderId orderId;
+	for (Quantity cancelled = 0; (limit == 0 || cancelled < limit) && expiries_.PopGoodForDay(orderId); ++cancelled)
+		CancelOrderInternal(orderId);
+
+	// An unlimited prune also takes orders added since an earlier slice sealed
+	if (limit == 0)
+	{
+		expiries_.SealGoodForDay();
+		while (expiries_.PopGoodForDay(orderId))
+			CancelOrderInternal(orderId);
+	}
+}
+
+/**
+ * @brief Cancels Good‑Till‑Date orders due by now a slice per lock.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::ExpireOrders(Expiry now)
+{
+	while (true)
+	{
+		[[maybe_unused]] const auto ordersLock = LockOrders();
+
+		ExpireOrdersInternal(now, Traits::ExpirySlice);
+		PublishDepth();
+
+		const Expiry next = expiries_.NextExpiry();
+		if (next == Constants::NoExpiry || next > now)
+			return;
+	}
+}
+
+/**
+ * @brief Cancels Good‑Till‑Date orders due by now, earliest first (assumes ordersMutex_ is held).
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::ExpireOrdersInternal(Expiry now, Quantity limit)
+{
+	OrderId orderId;
+	for (Quantity cancelled = 0; (limit == 0 || cancelled < limit) && expiries_.PopExpired(now, orderId); ++cancelled)
+		CancelOrderInternal(orderId);
+}
+
+template <typename Traits>
+Expiry BasicOrderbook<Traits>::NextExpiry() const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	return expiries_.NextExpiry();
+}
+
+template <typename Traits>
+bool BasicOrderbook<Traits>::IsExpiringGoodForDay() const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	return expiries_.IsExpiringGoodForDay();
+}
+
+/**
+ * @brief Locks the book for a public call; the wait is recorded as OrderbookTimer::LockWait.
+ */
+template <typename Traits>
+std::unique_lock<typename Traits::Mutex> BasicOrderbook<Traits>::LockOrders()
+{
+	const auto requested = instrumentation_.Start();
+	std::unique_lock ordersLock{ ordersMutex_ };
+	instrumentation_.Stop(OrderbookTimer::LockWait, requested);
+	return ordersLock;
+}
+
+/**
+ * @brief Cancels a list of orders by ID.
+ * @param orderIds Collection of order IDs to cancel.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::CancelOrders(OrderIds orderIds)
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	for (const auto& orderId : orderIds)
+		CancelOrderInternal(orderId);
+
+	PublishDepth();
+}
+
+/**
+ * @brief Internal cancellation logic (assumes ordersMutex_ is held).
+ * @param orderId ID of the order to cancel.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::CancelOrderInternal(OrderId orderId)
+{
+	OrderEntry entry;
+	if (!orders_.Extract(orderId, entry))
+	{
+		if (!stops_.Empty() && stops_.Cancel(orderId)) [[unlikely]]
+			instrumentation_.Count(OrderbookCounter::OrdersCancelled);
+		return;
+	}
+
+	instrumentation_.Count(OrderbookCounter::OrdersCancelled);
+
+	if (storage_.Get(entry).GetSide() == Side::Buy)
+		RemoveOrder<Side::Buy>(entry);
+	else
+		RemoveOrder<Side::Sell>(entry);
+}
+
+/**
+ * @brief Unlinks a cancelled order from its level on side S, erasing the level once empty.
+ */
+template <typename Traits>
+template <Side S>
+void BasicOrderbook<Traits>::RemoveOrder(const OrderEntry& entry)
+{
+	auto& levels = LevelsOf<S>();
+	const auto& order = storage_.Get(entry);
+	const auto price = order.GetPrice();
+	expiries_.Remove(order);
+
+	auto& level = *levels.Find(price);
+	OnOrderCancelled(level, order);
+	storage_.Erase(level.orders_, entry);
+	if (storage_.Empty(level.orders_))
+		levels.Erase(price);
+}
+
+/**
+ * @brief Callback when an order is cancelled; updates level data.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::OnOrderCancelled(PriceLevel& level, const Order& order)
+{
+	UpdateLevelData(level.data_, order.GetRemainingQuantity(), LevelData::Action::Remove);
+	level.data_.hidden_ -= order.GetHiddenQuantity();
+	EmitLevelUpdate(order.GetSide(), order.GetPrice(), level.data_);
+	accounts_.OnRemoved(order, order.GetOpenQuantity());
+}
+
+/**
+ * @brief Callback when an order is added; updates level data.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::OnOrderAdded(PriceLevel& level, const Order& order)
+{
+	UpdateLevelData(level.data_, order.GetRemainingQuantity(), LevelData::Action::Add);
+	level.data_.hidden_ += order.GetHiddenQuantity();
+	EmitLevelUpdate(order.GetSide(), order.GetPrice(), level.data_);
+	accounts_.OnAdded(order);
+}
+
+/**
+ * @brief Callback when an order is matched (partially or fully).
+ * @param level Price level where match occurred.
+ * @param order The resting order that traded.
+ * @param quantity Quantity matched.
+ * @param isFullyFilled True if the order was completely filled.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::OnOrderMatched(PriceLevel& level, const Order& order, Quantity quantity, bool isFullyFilled)
+{
+	UpdateLevelData(level.data_, quantity, isFullyFilled ? LevelData::Action::Remove : LevelData::Action::Match);
+	EmitLevelUpdate(order.GetSide(), order.GetPrice(), level.data_);
+	accounts_.OnFilled(order, quantity);
+}
+
+/**
+ * @brief Callback when a resting order's quantity is amended down in place.
+ * @param level Price level of the order.
+ * @param order The amended order.
+ * @param quantity Quantity removed from the order.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::OnOrderReduced(PriceLevel& level, const Order& order, Quantity quantity)
+{
+	// Same bookkeeping as a partial fill: less quantity, same order count
+	UpdateLevelData(level.data_, quantity, LevelData::Action::Match);
+	EmitLevelUpdate(order.GetSide(), order.GetPrice(), level.data_);
+	accounts_.OnRemoved(order, quantity);
+}
+
+/**
+ * @brief Pushes a level's new aggregates to the level-update ring.
+ *
+ * The sequence advances even when the ring is full and the update is dropped,
+ * so the consumer sees the gap rather than the matcher waiting for it.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::EmitLevelUpdate(Side side, Price price, const LevelData& data)
+{
+	if constexpr (Traits::LevelUpdateCapacity > 0)
+		levelUpdates_.TryPush(LevelUpdate{ ++levelUpdateSequence_, side, price, data.quantity_, data.count_ });
+}
+
+/**
+ * @brief Updates aggregated quantity and order count for a price level.
+ * @param data Aggregates of the level.
+ * @param quantity Quantity change.
+ * @param action Type of action (Add, Remove, Match, Replenish).
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::UpdateLevelData(LevelData& data, Quantity quantity, typename LevelData::Action action)
+{
+	depthDirty_ = true;
+
+	data.count_ += action == LevelData::Action::Remove ? -1 : action == LevelData::Action::Add ? 1 : 0;
+	if (action == LevelData::Action::Remove || action == LevelData::Action::Match)
+	{
+		data.quantity_ -= quantity;
+	}
+	else
+	{
+		data.quantity_ += quantity;
+	}
+}
+
+/**
+ * @brief Stores the top of book into topOfBook_ if it changed and copies the
+ *        best Traits::DepthLevels levels of each side into depth_.
+ *
+ * Uses the running level quantities, so the cost is O(DepthLevels) and no
+ * order is touched. Does nothing if no level changed since the last call.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::PublishDepth()
+{
+	if (!depthDirty_)
+		return;
+
+	depthDirty_ = false;
+
+	if (const TopOfBook top = ReadTopOfBook(); !(top == lastTopOfBook_.top_))
+	{
+		lastTopOfBook_.top_ = top;
+		++lastTopOfBook_.sequence_;
+		topOfBook_.Store(lastTopOfBook_);
+	}
+
+	if constexpr (Traits::DepthLevels > 0)
+	{
+		// A level found past the last slot only marks the side as truncated
+		Depth depth;
+		bids_.ForEachLevel([&depth](Price price, const PriceLevel& level)
+			{
+				depth.bidsTruncated_ = depth.bidCount_ == Traits::DepthLevels;
+				if (!depth.bidsTruncated_)
+					depth.bids_[depth.bidCount_++] = LevelInfo{ price, level.data_.quantity_ };
+				return !depth.bidsTruncated_;
+			});
+		asks_.ForEachLevel([&depth](Price price, const PriceLevel& level)
+			{
+				depth.asksTruncated_ = depth.askCount_ == Traits::DepthLevels;
+				if (!depth.asksTruncated_)
+					depth.asks_[depth.askCount_++] = LevelInfo{ price, level.data_.quantity_ };
+				return !depth.asksTruncated_;
+			});
+
+		depth_.Store(depth);
+	}
+}
+
+/**
+ * @brief Checks whether a Fill‑Or‑Kill order of side S can be fully filled.
+ * @param price Limit price.
+ * @param quantity Order quantity.
+ * @return True if the total quantity across all matching levels is sufficient.
+ */
+template <typename Traits>
+template <Side S>
+bool BasicOrderbook<Traits>::CanFullyFill(Price price, Quantity quantity, AccountId account) const
+{
+	if (!CanMatch<S>(price))
+		return false;
+
+	bool canFill = false;
+
+	if (account != Constants::NoAccount)
+	{
+		// The order meets resting orders in FIFO order (see PreventSelfTrade)
+		const bool ownOrdersStop = accounts_.SelfTradePreventionOf(account) != SelfTradePrevention::CancelResting;
+		bool stopped = false;
+
+		auto Take = [&quantity, &canFill](Quantity available)
+			{
+				if (quantity <= available)
+					canFill = true;
+				else
+					quantity -= available;
+			};
+
+		LevelsOf<Opposite<S>>().ForEachLevel([&](Price levelPrice, const PriceLevel& level)
+			{
+				if (!Reaches<S>(price, levelPrice))
+					return false;
+
+				// Reserves show again behind the level, so after any own order ahead of them
+				Quantity hidden = 0;
+				storage_.ForEach(level.orders_, [&](const Order& resting)
+					{
+						if (canFill || stopped)
+							return;
+
+						if (resting.GetAccount() == account)
+							stopped = ownOrdersStop;
+						else
+						{
+							hidden += resting.GetHiddenQuantity();
+							Take(resting.GetRemainingQuantity());
+						}
+					});
+
+				if (!canFill && !stopped)
+					Take(hidden);
+
+				return !canFill && !stopped;
+			});
+
+		return canFill;
+	}
+
+	LevelsOf<Opposite<S>>().ForEachLevel([&](Price levelPrice, const PriceLevel& level)
+		{
+			if (!Reaches<S>(price, levelPrice))
+				return false;
+
+			// Reserves count too: MatchOrders sweeps them through Replenish
+			const std::uint64_t available = std::uint64_t{ level.data_.quantity_ } + level.data_.hidden_;
+			if (quantity <= available)
+			{
+				canFill = true;
+				return false;
+			}
+
+			quantity -= static_cast<Quantity>(available);
+			return true;
+		});
+
+	return canFill;
+}
+
+/**
+ * @brief Checks whether an order of side S can be matched at all at the given price.
+ * @param price Limit price.
+ * @return True if there is an opposing order at a matching price.
+ */
+template <typename Traits>
+template <Side S>
+bool BasicOrderbook<Traits>::CanMatch(Price price) const
+{
+	const auto& opposite = LevelsOf<Opposite<S>>();
+	return !opposite.Empty() && Reaches<S>(price, opposite.BestPrice());
+}
+
+/**
+ * @brief Drops a filled order from the index and its level (the level stays for MatchOrders to erase).
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::RemoveFilled(PriceLevel& level, const OrderEntry& entry, const Order& order)
+{
+	// Storage may recycle the order once erased, so read it first
+	orders_.Erase(order.GetOrderId());
+	expiries_.Remove(order);
+	storage_.Erase(level.orders_, entry);
+}
+
+/**
+ * @brief Cancels an order in the middle of matching: unlike RemoveOrder it never
+ *        erases the level, which MatchOrders is still holding.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::CancelFromLevel(PriceLevel& level, const OrderEntry& entry, const Order& order)
+{
+	instrumentation_.Count(OrderbookCounter::OrdersCancelled);
+	OnOrderCancelled(level, order);
+	RemoveFilled(level, entry, order);
+}
+
+/**
+ * @brief Refills a filled iceberg from its reserve in place.
+ *
+ * The order keeps its slot (or list node) and id index entry; storage only
+ * relinks it behind the level's other orders, so it loses time priority as
+ * a new order would, without being reallocated or re-entered through
+ * AddOrder. The level gains the shown quantity at the same order count and
+ * stays the one MatchOrders is working on.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::Replenish(PriceLevel& level, const OrderEntry& entry, Order& order)
+{
+	order.Replenish();
+	storage_.MoveToBack(level.orders_, entry);
+	UpdateLevelData(level.data_, order.GetRemainingQuantity(), LevelData::Action::Replenish);
+	level.data_.hidden_ -= order.GetRemainingQuantity();
+	EmitLevelUpdate(order.GetSide(), order.GetPrice(), level.data_);
+}
+
+/**
+ * @brief Cancels or decrements the two orders of a would-be self-trade; at least
+ *        one of them leaves the book or shows its next slice, so matching
+ *        always makes progress.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::PreventSelfTrade(PriceLevel& aggressorLevel, const OrderEntry& aggressorEntry, Order& aggressor,
+	PriceLevel& restingLevel, const OrderEntry& restingEntry, Order& resting)
+{
+	instrumentation_.Count(OrderbookCounter::SelfTradesPrevented);
+
+	switch (accounts_.SelfTradePreventionOf(aggressor.GetAccount()))
+	{
+	case SelfTradePrevention::CancelResting:
+		CancelFromLevel(restingLevel, restingEntry, resting);
+		break;
+	case SelfTradePrevention::CancelAggressor:
+		CancelFromLevel(aggressorLevel, aggressorEntry, aggressor);
+		break;
+	case SelfTradePrevention::DecrementBoth:
+	{
+		const Quantity quantity = std::min(aggressor.GetRemainingQuantity(), resting.GetRemainingQuantity());
+		for (auto [level, entry, order] : { std::tie(aggressorLevel, aggressorEntry, aggressor), std::tie(restingLevel, restingEntry, resting) })
+		{
+			// An iceberg whose slice runs out keeps its reserve, as if the slice had traded
+			if (order.GetOpenQuantity() == quantity)
+				CancelFromLevel(level, entry, order);
+			else
+			{
+				OnOrderReduced(level, order, quantity);
+				order.ReduceQuantity(order.GetRemainingQuantity() - quantity);
+				if (order.IsFilled())
+					Replenish(level, entry, order);
+			}
+		}
+		break;
+	}
+	}
+}
+
+/**
+ * @brief Matches orders at the current best bid/ask until no further matches are possible.
+ * @param sink Receives each generated trade.
+ */
+template <typename Traits>
+template <Side S, TradeSink Sink>
+void BasicOrderbook<Traits>::MatchOrders(Sink& sink)
+{
+	std::uint64_t levelsCrossed = 0;
+
+	while (true)
+	{
+		if (bids_.Empty() || asks_.Empty())
+			break;
+
+		const Price bidPrice = bids_.BestPrice();
+		const Price askPrice = asks_.BestPrice();
+
+		if (bidPrice < askPrice)
+			break;
+
+		++levelsCrossed;
+
+		auto& bids = bids_.Best();
+		auto& asks = asks_.Best();
+
+		while (!storage_.Empty(bids.orders_) && !storage_.Empty(asks.orders_))
+		{
+			const auto bidEntry = storage_.Front(bids.orders_);
+			const auto askEntry = storage_.Front(asks.orders_);
+			auto& bid = storage_.Get(bidEntry);
+			auto& ask = storage_.Get(askEntry);
+
+			if (bid.GetAccount() == ask.GetAccount() && bid.GetAccount() != Constants::NoAccount) [[unlikely]]
+			{
+				if constexpr (S == Side::Buy)
+					PreventSelfTrade(bids, bidEntry, bid, asks, askEntry, ask);
+				else
+					PreventSelfTrade(asks, askEntry, ask, bids, bidEntry, bid);
+				continue;
+			}
+
+			Quantity quantity = std::min(bid.GetRemainingQuantity(), ask.GetRemainingQuantity());
+
+			bid.Fill(quantity);
+			ask.Fill(quantity);
+
+			sink(Trade{
+				TradeInfo{ bid.GetOrderId(), bid.GetPrice(), quantity },
+				TradeInfo{ ask.GetOrderId(), ask.GetPrice(), quantity }
+				});
+			instrumentation_.Count(OrderbookCounter::Trades);
+			lastTradePrice_ = S == Side::Buy ? askPrice : bidPrice;
+
+			// A filled iceberg with a reserve left stays at its level (see Replenish)
+			const bool bidLeaves = bid.IsFilled() && bid.GetHiddenQuantity() == 0;
+			const bool askLeaves = ask.IsFilled() && ask.GetHiddenQuantity() == 0;
+
+			OnOrderMatched(bids, bid, quantity, bidLeaves);
+			OnOrderMatched(asks, ask, quantity, askLeaves);
+
+			if (bidLeaves)
+				RemoveFilled(bids, bidEntry, bid);
+			else if (bid.IsFilled()) [[unlikely]]
+				Replenish(bids, bidEntry, bid);
+
+			if (askLeaves)
+				RemoveFilled(asks, askEntry, ask);
+			else if (ask.IsFilled()) [[unlikely]]
+				Replenish(asks, askEntry, ask);
+		}
+
+		if (storage_.Empty(bids.orders_))
+			bids_.EraseBest();
+
+		if (storage_.Empty(asks.orders_))
+			asks_.EraseBest();
+	}
+
+	if (levelsCrossed > 0)
+	{
+		instrumentation_.Count(OrderbookCounter::LevelsCrossed, levelsCrossed);
+		instrumentation_.Sample(OrderbookDistribution::LevelsCrossed, levelsCrossed);
+	}
+}
+
+/**
+ * @brief Constructor – starts the background pruning thread (if the traits enable it).
+ */
+template <typename Traits>
+BasicOrderbook<Traits>::BasicOrderbook(std::size_t orderCapacity)
+	: storage_{ orderCapacity }
+{
+	orders_.Reserve(orderCapacity);
+
+	if constexpr (Traits::PruneThread)
+		ordersPruneThread_ = std::thread{ [this] { PruneGoodForDayOrders(); } };
+}
+
+/**
+ * @brief Destructor – signals shutdown and joins the pruning thread.
+ */
+template <typename Traits>
+BasicOrderbook<Traits>::~BasicOrderbook()
+{
+	{
+		// Publish under the lock so the prune thread cannot miss the wakeup
+		// between checking shutdown_ and starting to wait.
+		std::scoped_lock ordersLock{ ordersMutex_ };
+		shutdown_.store(true, std::memory_order_release);
+	}
+	shutdownConditionVariable_.notify_one();
+
+	if (ordersPruneThread_.joinable())
+		ordersPruneThread_.join();
+}
+
+/**
+ * @brief Adds an order to the book, performs necessary conversions, and attempts to match.
+ * @param order The order to add.
+ * @return List of trades resulting from this addition.
+ */
+template <typename Traits>
+Trades BasicOrderbook<Traits>::AddOrder(OrderPointer order)
+{
+	Trades trades;
+	AddOrder(std::move(order), TradeAppender{ trades });
+	return trades;
+}
+
+/**
+ * @brief Adds an order given by value (copied by the storage on insertion).
+ * @param order The order to add.
+ * @return List of trades resulting from this addition.
+ */
+template <typename Traits>
+Trades BasicOrderbook<Traits>::AddOrder(const Order& order)
+{
+	Trades trades;
+	AddOrder(order, TradeAppender{ trades });
+	return trades;
+}
+
+/**
+ * @brief Adds an order, appending the resulting trades to trades.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::AddOrder(OrderPointer order, Trades& trades)
+{
+	AddOrder(std::move(order), TradeAppender{ trades });
+}
+
+/**
+ * @brief Adds an order given by value, appending the resulting trades to trades.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::AddOrder(const Order& order, Trades& trades)
+{
+	AddOrder(order, TradeAppender{ trades });
+}
+
+/**
+ * @brief Adds an order, handing each resulting trade to sink.
+ */
+template <typename Traits>
+template <TradeSink Sink>
+void BasicOrderbook<Traits>::AddOrder(OrderPointer order, Sink&& sink)
+{
+	[[maybe_unused]] const auto timer = instrumentation_.Time(OrderbookTimer::AddOrder);
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	AddOrderInternal(*order, order, sink);
+	PublishDepth();
+}
+
+/**
+ * @brief Adds an order given by value, handing each resulting trade to sink.
+ */
+template <typename Traits>
+template <TradeSink Sink>
+void BasicOrderbook<Traits>::AddOrder(const Order& order, Sink&& sink)
+{
+	[[maybe_unused]] const auto timer = instrumentation_.Time(OrderbookTimer::AddOrder);
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	Order incoming{ order };
+	AddOrderInternal(incoming, incoming, sink);
+	PublishDepth();
+}
+
+/**
+ * @brief Rejects duplicate ids, then dispatches on side (assumes ordersMutex_ is held).
+ *
+ * Stops are triggered once the order is done, so a triggered stop never
+ * trades with what is left of the order whose trade triggered it.
+ */
+template <typename Traits>
+template <typename OrderSource, TradeSink Sink>
+void BasicOrderbook<Traits>::AddOrderInternal(Order& order, const OrderSource& source, Sink& sink)
+{
+	if (orders_.Contains(order.GetOrderId()) || (!stops_.Empty() && stops_.Contains(order.GetOrderId())))
+		return;
+
+	if (order.GetSide() == Side::Buy)
+		AddOrderOnSide<Side::Buy>(order, source, sink);
+	else
+		AddOrderOnSide<Side::Sell>(order, source, sink);
+
+	if (!stops_.Empty() && lastTradePrice_ && stops_.IsDue(*lastTradePrice_)) [[unlikely]]
+		TriggerStops(sink);
+}
+
+/**
+ * @brief Pops and enters due stops until none is left.
+ *
+ * Each triggered order trades like a new one and may move the last trade
+ * price on to further stops, which the next round picks up; they enter
+ * through AddOrderOnSide, so this never recurses.
+ */
+template <typename Traits>
+template <TradeSink Sink>
+void BasicOrderbook<Traits>::TriggerStops(Sink& sink)
+{
+	while (auto order = stops_.PopDue(*lastTradePrice_))
+	{
+		order->Trigger();
+
+		if (order->GetSide() == Side::Buy)
+			AddOrderOnSide<Side::Buy>(*order, *order, sink);
+		else
+			AddOrderOnSide<Side::Sell>(*order, *order, sink);
+	}
+}
+
+/**
+ * @brief Dispatches an order of side S on its type.
+ */
+template <typename Traits>
+template <Side S, typename OrderSource, TradeSink Sink>
+void BasicOrderbook<Traits>::AddOrderOnSide(Order& order, const OrderSource& source, Sink& sink)
+{
+	switch (order.GetOrderType())
+	{
+	case OrderType::GoodTillCancel:
+		return AddOrderOfType<S, OrderType::GoodTillCancel>(order, source, sink);
+	case OrderType::FillAndKill:
+		return AddOrderOfType<S, OrderType::FillAndKill>(order, source, sink);
+	case OrderType::FillOrKill:
+		return AddOrderOfType<S, OrderType::FillOrKill>(order, source, sink);
+	case OrderType::GoodForDay:
+		return AddOrderOfType<S, OrderType::GoodForDay>(order, source, sink);
+	case OrderType::Market:
+		return AddOrderOfType<S, OrderType::Market>(order, source, sink);
+	case OrderType::GoodTillDate:
+		return AddOrderOfType<S, OrderType::GoodTillDate>(order, source, sink);
+	case OrderType::Stop:
+		return AddOrderOfType<S, OrderType::Stop>(order, source, sink);
+	case OrderType::StopLimit:
+		return AddOrderOfType<S, OrderType::StopLimit>(order, source, sink);
+	case OrderType::Iceberg:
+		return AddOrderOfType<S, OrderType::Iceberg>(order, source, sink);
+	}
+}
+
+/**
+ * @brief Validates, converts and inserts an order of side S and type Type, then matches.
+ *
+ * Only the checks Type needs are compiled in, and matching runs only when
+ * the order reaches the opposite touch.
+ */
+template <typename Traits>
+template <Side S, OrderType Type, typename OrderSource, TradeSink Sink>
+void BasicOrderbook<Traits>::AddOrderOfType(Order& order, const OrderSource& source, Sink& sink)
+{
+	// Stops wait off the book until a trade reaches them (see TriggerStops)
+	if constexpr (StopIndex::Holds(Type))
+	{
+		stops_.Add(order);
+		return;
+	}
+
+	// Convert market orders to Good‑Till‑Cancel with the worst opposite price
+	if constexpr (Type == OrderType::Market)
+	{
+		const auto& opposite = LevelsOf<Opposite<S>>();
+		if (opposite.Empty())
+			return;
+
+		order.ToGoodTillCancel(opposite.WorstPrice());
+	}
+
+	// Immediate‑or‑cancel checks
+	if constexpr (Type == OrderType::FillAndKill)
+		if (!CanMatch<S>(order.GetPrice()))
+			return;
+
+	if constexpr (Type == OrderType::FillOrKill)
+		if (!CanFullyFill<S>(order.GetPrice(), order.GetInitialQuantity(), order.GetAccount()))
+			return;
+
+	if constexpr (Type == OrderType::GoodTillDate)
+		if (order.GetExpiry() == Constants::NoExpiry)
+			return;
+
+	// Show the display quantity; the risk check still sees the whole order
+	if constexpr (Type == OrderType::Iceberg)
+	{
+		if (order.GetDisplayQuantity() == 0)
+			return;
+
+		order.HideReserve();
+	}
+
+	if (!accounts_.Allows<S>(order))
+	{
+		instrumentation_.Count(OrderbookCounter::RiskRejections);
+		return;
+	}
+
+	// Insert order into its side's price level
+	auto& level = LevelsOf<S>().FindOrInsert(order.GetPrice());
+	orders_.Insert(order.GetOrderId(), storage_.Insert(level.orders_, source));
+
+	if constexpr (ExpiryIndex::Expires(Type))
+		expiries_.Add(order);
+
+	// Wake the prune thread if it sleeps past this order's expiry
+	if constexpr (Traits::PruneThread && Type == OrderType::GoodTillDate)
+		if (FromExpiry(order.GetExpiry()) < pruneWakeup_)
+			shutdownConditionVariable_.notify_one();
+
+	OnOrderAdded(level, order);
+	instrumentation_.Count(OrderbookCounter::OrdersAdded);
+
+	if (!CanMatch<S>(order.GetPrice()))
+		return;
+
+	{
+		[[maybe_unused]] const auto timer = instrumentation_.Time(OrderbookTimer::MatchOrders);
+		MatchOrders<S>(sink);
+	}
+
+	// A Fill‑And‑Kill order never rests: cancel what did not fill. A Fill‑Or‑Kill
+	// order has filled by now (CanFullyFill allowed for self-trade prevention).
+	if constexpr (Type == OrderType::FillAndKill || Type == OrderType::FillOrKill)
+		CancelOrderInternal(order.GetOrderId());
+}
+
+/**
+ * @brief Cancels a single order by ID.
+ * @param orderId ID of the order to cancel.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::CancelOrder(OrderId orderId)
+{
+	[[maybe_unused]] const auto timer = instrumentation_.Time(OrderbookTimer::CancelOrder);
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	CancelOrderInternal(orderId);
+	PublishDepth();
+}
+
+/**
+ * @brief Modifies an existing order (cancel + add new).
+ * @param order Modification details.
+ * @return Trades resulting from the modified order.
+ */
+template <typename Traits>
+Trades BasicOrderbook<Traits>::ModifyOrder(OrderModify order)
+{
+	Trades trades;
+	ModifyOrder(order, TradeAppender{ trades });
+	return trades;
+}
+
+/**
+ * @brief Modifies an order, appending the resulting trades to trades.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::ModifyOrder(const OrderModify& order, Trades& trades)
+{
+	ModifyOrder(order, TradeAppender{ trades });
+}
+
+/**
+ * @brief Modifies an order, handing each resulting trade to sink.
+ */
+template <typename Traits>
+template <TradeSink Sink>
+void BasicOrderbook<Traits>::ModifyOrder(const OrderModify& order, Sink&& sink)
+{
+	[[maybe_unused]] const auto timer = instrumentation_.Time(OrderbookTimer::ModifyOrder);
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	ModifyOrderInternal(order, sink);
+	PublishDepth();
+}
+
+/**
+ * @brief Amends an order in place or replaces it, keeping its order type (assumes ordersMutex_ is held).
+ * @param order Modification details.
+ * @param sink Receives each resulting trade.
+ */
+template <typename Traits>
+template <TradeSink Sink>
+void BasicOrderbook<Traits>::ModifyOrderInternal(const OrderModify& order, Sink& sink)
+{
+	OrderEntry* found = orders_.Find(order.GetOrderId());
+	if (found == nullptr)
+		return;
+
+	auto& existing = storage_.Get(*found);
+	const OrderType orderType = existing.GetOrderType();
+	const AccountId account = existing.GetAccount();
+
+	// An iceberg's reserve is sized again from the new quantity when it enters
+	const Expiry expiry = orderType == OrderType::Iceberg ? Expiry{ existing.GetDisplayQuantity() } : existing.GetExpiry();
+
+	// A smaller order at the same price cannot cross, so no matching is needed.
+	// Icebergs are always replaced, which sizes their reserve from the new quantity.
+	if (order.GetSide() == existing.GetSide() && order.GetPrice() == existing.GetPrice() && orderType != OrderType::Iceberg
+		&& order.GetQuantity() != 0 && order.GetQuantity() <= existing.GetRemainingQuantity())
+	{
+		auto& level = existing.GetSide() == Side::Buy
+			? *bids_.Find(existing.GetPrice())
+			: *asks_.Find(existing.GetPrice());
+
+		OnOrderReduced(level, existing, existing.GetRemainingQuantity() - order.GetQuantity());
+		existing.ReduceQuantity(order.GetQuantity());
+		return;
+	}
+
+	// A replacement past the account's limits leaves the original resting
+	Order replacement = order.ToOrder(orderType, expiry, account);
+	const bool allowed = order.GetSide() == Side::Buy
+		? accounts_.Allows<Side::Buy>(replacement, existing)
+		: accounts_.Allows<Side::Sell>(replacement, existing);
+
+	if (!allowed)
+	{
+		instrumentation_.Count(OrderbookCounter::RiskRejections);
+		return;
+	}
+
+	CancelOrderInternal(order.GetOrderId());
+	AddOrderInternal(replacement, replacement, sink);
+}
+
+/**
+ * @brief Applies a batch of commands in order, taking the lock once.
+ * @param commands Commands to apply.
+ * @param trades Buffer all resulting trades are appended to.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::ProcessBatch(std::span<const Command> commands, Trades& trades)
+{
+	ProcessBatch(commands, TradeAppender{ trades });
+}
+
+/**
+ * @brief Applies a batch of commands in order, taking the lock once.
+ * @param commands Commands to apply.
+ * @param sink Receives every resulting trade.
+ */
+template <typename Traits>
+template <TradeSink Sink>
+void BasicOrderbook<Traits>::ProcessBatch(std::span<const Command> commands, Sink&& sink)
+{
+	[[maybe_unused]] const auto timer = instrumentation_.Time(OrderbookTimer::ProcessBatch);
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	for (const auto& command : commands)
+		ProcessCommandInternal(command, sink);
+
+	// Readers see the book once per batch, not once per command
+	PublishDepth();
+}
+
+/**
+ * @brief Dispatches one command to the matching internal operation (assumes ordersMutex_ is held).
+ */
+template <typename Traits>
+template <TradeSink Sink>
+void BasicOrderbook<Traits>::ProcessCommandInternal(const Command& command, Sink& sink)
+{
+	switch (command.type_)
+	{
+	case CommandType::Add:
+	{
+		Order order = command.ToOrder();
+		AddOrderInternal(order, order, sink);
+	}
+	break;
+	case CommandType::Cancel:
+		CancelOrderInternal(command.orderId_);
+		break;
+	case CommandType::Modify:
+		ModifyOrderInternal(command.ToOrderModify(), sink);
+		break;
+	case CommandType::PruneGoodForDay:
+		CancelGoodForDayOrdersInternal(command.quantity_);
+		break;
+	case CommandType::ExpireGoodTillDate:
+		ExpireOrdersInternal(command.expiry_, command.quantity_);
+		break;
+	case CommandType::SetAccountLimits:
+		// Like a rejected order, an unusable command is dropped
+		if (command.account_ != Constants::NoAccount && command.quantity_ <= static_cast<Quantity>(SelfTradePrevention::DecrementBoth))
+			SetAccountLimitsInternal(command.account_, command.ToAccountLimits());
+		break;
+	}
+}
+
+/**
+ * @brief Visits resting orders in price-time priority, bids then asks, then pending stops.
+ */
+template <typename Traits>
+template <typename Visitor>
+void BasicOrderbook<Traits>::ForEachOrder(Visitor&& visitor) const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	auto VisitLevel = [this, &visitor](Price, const PriceLevel& level)
+		{ storage_.ForEach(level.orders_, visitor); return true; };
+
+	bids_.ForEachLevel(VisitLevel);
+	asks_.ForEachLevel(VisitLevel);
+	stops_.ForEach(visitor);
+}
+
+/**
+ * @brief Visits the preallocated arrays of every component of the book.
+ */
+template <typename Traits>
+template <typename Function>
+void BasicOrderbook<Traits>::ForEachMemoryRegion(Function&& function) const
+{
+	function(static_cast<const void*>(this), sizeof(*this));
+	orders_.ForEachMemoryRegion(function);
+	storage_.ForEachMemoryRegion(function);
+	bids_.ForEachMemoryRegion(function);
+	asks_.ForEachMemoryRegion(function);
+	expiries_.ForEachMemoryRegion(function);
+	levelUpdates_.ForEachMemoryRegion(function);
+}
+
+/**
+ * @brief Inserts a resting order as-is, without market conversion or matching.
+ * @param order Order to rest; its remaining quantity is what the level gains.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::RestoreOrder(const Order& order)
+{
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	const bool inUse = orders_.Contains(order.GetOrderId()) || stops_.Contains(order.GetOrderId());
+
+	if (StopIndex::Holds(order.GetOrderType()))
+	{
+		if (inUse || order.IsFilled())
+		{
+			std::stringstream ss;
+			ss << "Stop order (" << order.GetOrderId() << ") cannot be restored: duplicate or filled.";
+			throw std::logic_error(ss.str());
+		}
+
+		stops_.Add(order);
+		return;
+	}
+
+	const bool crosses = order.GetSide() == Side::Buy
+		? CanMatch<Side::Buy>(order.GetPrice())
+		: CanMatch<Side::Sell>(order.GetPrice());
+
+	const bool undated = order.GetOrderType() == OrderType::GoodTillDate && order.GetExpiry() == Constants::NoExpiry;
+
+	if (inUse || order.IsFilled() || order.GetOrderType() == OrderType::Market || undated || crosses)
+	{
+		std::stringstream ss;
+		ss << "Order (" << order.GetOrderId() << ") cannot be restored: duplicate, filled, market, undated or crossing.";
+		throw std::logic_error(ss.str());
+	}
+
+	auto& level = order.GetSide() == Side::Buy
+		? bids_.FindOrInsert(order.GetPrice())
+		: asks_.FindOrInsert(order.GetPrice());
+
+	orders_.Insert(order.GetOrderId(), storage_.Insert(level.orders_, order));
+	expiries_.Add(order);
+
+	OnOrderAdded(level, order);
+	PublishDepth();
+}
+
+template <typename Traits>
+std::optional<Price> BasicOrderbook<Traits>::GetLastTradePrice() const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	return lastTradePrice_;
+}
+
+template <typename Traits>
+void BasicOrderbook<Traits>::RestoreLastTradePrice(std::optional<Price> price)
+{
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+	lastTradePrice_ = price;
+}
+
+template <typename Traits>
+template <typename Function>
+void BasicOrderbook<Traits>::ForEachExpiringOrder(Function&& function) const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	expiries_.ForEach(function);
+}
+
+template <typename Traits>
+void BasicOrderbook<Traits>::RestoreExpiryPosition(OrderId orderId, bool sealed)
+{
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	if (!RequeueExpiry(orderId, sealed))
+	{
+		std::stringstream ss;
+		ss << "Order (" << orderId << ") has no expiry position to restore: missing, not expiring or not Good‑For‑Day.";
+		throw std::logic_error(ss.str());
+	}
+}
+
+template <typename Traits>
+bool BasicOrderbook<Traits>::RequeueExpiry(OrderId orderId, bool sealed)
+{
+	const OrderEntry* found = orders_.Find(orderId);
+	if (found == nullptr)
+		return false;
+
+	const Order& order = storage_.Get(*found);
+	if (!ExpiryIndex::Expires(order.GetOrderType()) || (sealed && order.GetOrderType() != OrderType::GoodForDay))
+		return false;
+
+	expiries_.Requeue(order, sealed);
+	return true;
+}
+
+/**
+ * @brief Writes the book's image: header, slab verbatim, bid and ask level records, accounts, then expiry order.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::WriteImage(const std::string& path, std::uint64_t sequence) const
+	requires std::same_as<typename Traits::Storage, PooledOrderStorage>
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	if (!stops_.Empty())
+		throw std::logic_error("A book image holds no pending stop orders; take a snapshot instead.");
+
+	const auto slots = storage_.Pool().Slots();
+
+	std::vector<BookImageLevel> levels;
+	auto AppendLevel = [&levels](Price price, const PriceLevel& level)
+		{
+			levels.push_back(BookImageLevel{ price, level.orders_.head_, level.orders_.tail_, level.data_.quantity_, level.data_.count_, level.data_.hidden_ });
+			return true;
+		};
+
+	bids_.ForEachLevel(AppendLevel);
+	const std::size_t bidLevelCount = levels.size();
+	asks_.ForEachLevel(AppendLevel);
+
+	std::vector<BookImageAccount> accounts;
+	accounts_.ForEach([&accounts](AccountId account, const AccountLimits& limits, const AccountExposure& exposure)
+		{ accounts.push_back(BookImageAccount{ limits.maxPosition_, limits.maxNotional_, exposure.position_, account, limits.selfTradePrevention_, { } }); });
+
+	std::vector<OrderId> expiring;
+	std::uint64_t sealedCount = 0;
+	expiries_.ForEach([&expiring, &sealedCount](OrderId orderId, bool sealed)
+		{
+			expiring.push_back(orderId);
+			sealedCount += sealed;
+		});
+
+	BookImageHeader header;
+	std::memset(&header, 0, sizeof(header));
+	BookImageHeader::Magic.copy(header.magic_, sizeof(header.magic_));
+	header.byteOrder_ = BookImageHeader::ByteOrderMark;
+	header.slotSize_ = sizeof(OrderPool::Slot);
+	header.levelSize_ = sizeof(BookImageLevel);
+	header.freeHead_ = storage_.Pool().FreeHead();
+	header.slotCount_ = slots.size();
+	header.orderCount_ = orders_.Size();
+	header.bidLevelCount_ = bidLevelCount;
+	header.askLevelCount_ = levels.size() - bidLevelCount;
+	header.sequence_ = sequence;
+	header.levelUpdateSequence_ = levelUpdateSequence_;
+	header.hasLastTradePrice_ = lastTradePrice_.has_value();
+	header.lastTradePrice_ = lastTradePrice_.value_or(0);
+	header.accountCount_ = accounts.size();
+	header.accountSize_ = sizeof(BookImageAccount);
+	header.expiringCount_ = expiring.size();
+	header.sealedCount_ = sealedCount;
+
+	const std::span<const unsigned char> parts[] = {
+		BookImage::Bytes(std::span<const BookImageHeader>{ &header, 1 }),
+		BookImage::Padding(),
+		BookImage::Bytes(slots),
+		BookImage::Bytes(std::span<const BookImageLevel>{ levels }),
+		BookImage::Bytes(std::span<const BookImageAccount>{ accounts }),
+		BookImage::Bytes(std::span<const OrderId>{ expiring }) };
+	header.crc_ = BookImage::Checksum(parts);
+
+	WriteFileDurably(path, parts);
+}
+
+/**
+ * @brief Adopts a mapped image: bulk slab copy, one insert per level, and the
+ *        id index rebuilt from the occupied slots.
+ *
+ * The whole image is checked before the book changes: a corrupt one is
+ * rejected with the book still empty, so adopting another image works.
+ */
+template <typename Traits>
+std::uint64_t BasicOrderbook<Traits>::AdoptImage(const std::string& path)
+	requires std::same_as<typename Traits::Storage, PooledOrderStorage>
+{
+	const MappedFile file{ path };
+	const BookImageHeader header = BookImage::ReadHeader(file, path);
+	const auto Corrupt = [&path] { return std::runtime_error("Corrupt book image: " + path); };
+
+	const auto* slots = reinterpret_cast<const OrderPool::Slot*>(file.Data() + BookImage::SlotsOffset);
+	const auto* levels = reinterpret_cast<const BookImageLevel*>(file.Data() + BookImage::LevelsOffset(header.slotCount_));
+	const auto* accounts = reinterpret_cast<const BookImageAccount*>(file.Data() + BookImage::AccountsOffset(header));
+	const auto* expiring = reinterpret_cast<const OrderId*>(file.Data() + BookImage::ExpiriesOffset(header));
+	const std::uint64_t levelCount = header.bidLevelCount_ + header.askLevelCount_;
+
+	[[maybe_unused]] const auto ordersLock = LockOrders();
+
+	if (!orders_.Empty() || !stops_.Empty())
+		throw std::logic_error("A book image can only be adopted by an empty book.");
+
+	if (header.slotCount_ >= OrderPool::InvalidSlot)
+		throw Corrupt();
+
+	std::vector<bool> isFree(header.slotCount_);
+	for (OrderSlot slot = header.freeHead_; slot != OrderPool::InvalidSlot; slot = slots[slot].next_)
+	{
+		if (slot >= header.slotCount_ || isFree[slot])
+			throw Corrupt();
+		isFree[slot] = true;
+	}
+
+	const auto IsOrder = [&](OrderSlot slot) { return slot < header.slotCount_ && !isFree[slot]; };
+
+	// Index every slot not on the free list, checking its links both ways and
+	// that it holds an order that can rest
+	FlatOrderIndex<OrderEntry> index{ std::max<std::size_t>(orders_.Capacity(), header.orderCount_) };
+	std::uint64_t expiringCount = 0;
+	for (OrderSlot slot = 0; slot < header.slotCount_; ++slot)
+	{
+		if (isFree[slot])
+			continue;
+
+		const OrderPool::Slot& image = slots[slot];
+		const Order& order = image.order_;
+		const OrderType type = order.GetOrderType();
+		const bool rests = type == OrderType::GoodTillCancel || type == OrderType::GoodForDay
+			|| type == OrderType::GoodTillDate || type == OrderType::Iceberg;
+
+		if ((image.prev_ != OrderPool::InvalidSlot && (!IsOrder(image.prev_) || slots[image.prev_].next_ != slot))
+			|| (image.next_ != OrderPool::InvalidSlot && (!IsOrder(image.next_) || slots[image.next_].prev_ != slot))
+			|| !rests || (order.GetSide() != Side::Buy && order.GetSide() != Side::Sell) || order.IsFilled()
+			|| index.Contains(order.GetOrderId()))
+			throw Corrupt();
+
+		index.Insert(order.GetOrderId(), OrderEntry{ slot });
+		expiringCount += ExpiryIndex::Expires(type);
+	}
+
+	if (index.Size() != header.orderCount_ || header.expiringCount_ != expiringCount)
+		throw Corrupt();
+
+	// Walk each level's FIFO from head to tail, best level first: every order
+	// of the level's side and price, none in two FIFOs, and the level's totals
+	// those of its orders. Once every level is walked, no order is left outside one.
+	std::vector<bool> isListed(header.slotCount_);
+	std::uint64_t listedCount = 0;
+	for (std::uint64_t position = 0; position < levelCount; ++position)
+	{
+		const BookImageLevel& image = levels[position];
+		const bool isBid = position < header.bidLevelCount_;
+		const bool isFirst = position == 0 || position == header.bidLevelCount_;
+
+		if (!IsOrder(image.head_) || slots[image.head_].prev_ != OrderPool::InvalidSlot
+			|| (!isFirst && (isBid ? image.price_ >= levels[position - 1].price_ : image.price_ <= levels[position - 1].price_)))
+			throw Corrupt();
+
+		std::uint64_t quantity = 0, count = 0, hidden = 0;
+		for (OrderSlot slot = image.head_; ; slot = slots[slot].next_)
+		{
+			if (!IsOrder(slot) || isListed[slot])
+				throw Corrupt();
+
+			const Order& order = slots[slot].order_;
+			if (order.GetSide() != (isBid ? Side::Buy : Side::Sell) || order.GetPrice() != image.price_)
+				throw Corrupt();
+
+			isListed[slot] = true;
+			quantity += order.GetRemainingQuantity();
+			hidden += order.GetHiddenQuantity();
+			++count;
+
+			if (slot == image.tail_)
+				break;
+		}
+
+		if (slots[image.tail_].next_ != OrderPool::InvalidSlot
+			|| quantity != image.quantity_ || count != image.count_ || hidden != image.hidden_)
+			throw Corrupt();
+		listedCount += count;
+	}
+
+	if (listedCount != index.Size())
+		throw Corrupt();
+
+	for (std::uint64_t position = 0; position < header.accountCount_; ++position)
+		if (accounts[position].selfTradePrevention_ > SelfTradePrevention::DecrementBoth)
+			throw Corrupt();
+
+	// Every expiring order once, sealed ones Good‑For‑Day
+	std::vector<bool> isQueued(header.slotCount_);
+	for (std::uint64_t position = 0; position < header.expiringCount_; ++position)
+	{
+		const OrderEntry* entry = index.Find(expiring[position]);
+		if (entry == nullptr || isQueued[entry->slot_])
+			throw Corrupt();
+
+		const OrderType type = slots[entry->slot_].order_.GetOrderType();
+		if (!ExpiryIndex::Expires(type) || (position < header.sealedCount_ && type != OrderType::GoodForDay))
+			throw Corrupt();
+		isQueued[entry->slot_] = true;
+	}
+
+	// Valid: only now does the book change
+	auto& pool = storage_.Pool();
+	pool.Adopt(std::span<const OrderPool::Slot>{ slots, header.slotCount_ }, header.freeHead_);
+
+	for (std::uint64_t position = 0; position < levelCount; ++position)
+	{
+		const BookImageLevel& image = levels[position];
+		auto& level = position < header.bidLevelCount_
+			? bids_.FindOrInsert(image.price_)
+			: asks_.FindOrInsert(image.price_);
+
+		level.orders_ = OrderQueue{ image.head_, image.tail_ };
+		level.data_ = LevelData{ image.quantity_, image.count_, image.hidden_ };
+	}
+
+	// Limits before the orders are indexed, so each counts towards its account
+	for (std::uint64_t position = 0; position < header.accountCount_; ++position)
+	{
+		const BookImageAccount& image = accounts[position];
+		if (image.account_ == Constants::NoAccount)
+			continue;
+
+		accounts_.Cover(image.account_);
+		accounts_.SetLimits(image.account_, AccountLimits{ image.maxPosition_, image.maxNotional_, image.selfTradePrevention_ });
+		accounts_.RestorePosition(image.account_, image.position_);
+	}
+
+	orders_ = std::move(index);
+	for (OrderSlot slot = 0; slot < header.slotCount_; ++slot)
+		if (!isFree[slot])
+		{
+			expiries_.Add(pool.Get(slot));
+			accounts_.OnAdded(pool.Get(slot));
+		}
+
+	// Slot order is not expiry order: requeue in the order the image recorded
+	for (std::uint64_t position = 0; position < header.expiringCount_; ++position)
+		RequeueExpiry(expiring[position], position < header.sealedCount_);
+
+	levelUpdateSequence_ = header.levelUpdateSequence_;
+	if (header.hasLastTradePrice_)
+		lastTradePrice_ = header.lastTradePrice_;
+	depthDirty_ = true;
+	PublishDepth();
+
+	return header.sequence_;
+}
+
+template <typename Traits>
+OrderSlot BasicOrderbook<Traits>::SlotOf(OrderId orderId) const
+	requires std::same_as<typename Traits::Storage, PooledOrderStorage>
+{
+	const OrderEntry* entry = orders_.Find(orderId);
+	return entry != nullptr ? entry->slot_ : OrderPool::InvalidSlot;
+}
+
+/**
+ * @brief Returns the total number of orders currently in the book.
+ */
+template <typename Traits>
+std::size_t BasicOrderbook<Traits>::Size() const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	return orders_.Size() + stops_.Size();
+}
+
+template <typename Traits>
+void BasicOrderbook<Traits>::SetAccountLimits(AccountId account, const AccountLimits& limits)
+{
+	if (account == Constants::NoAccount)
+		throw std::logic_error("Orders without an account cannot be limited");
+
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	SetAccountLimitsInternal(account, limits);
+}
+
+template <typename Traits>
+template <typename Function>
+void BasicOrderbook<Traits>::ForEachAccount(Function&& function) const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	accounts_.ForEach(function);
+}
+
+template <typename Traits>
+void BasicOrderbook<Traits>::RestoreAccount(AccountId account, const AccountLimits& limits, std::int64_t position)
+{
+	if (account == Constants::NoAccount)
+		throw std::logic_error("Orders without an account cannot be limited");
+
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	SetAccountLimitsInternal(account, limits);
+	accounts_.RestorePosition(account, position);
+}
+
+/**
+ * @brief Sets an account's limits, first seeding any newly tracked account from the resting orders.
+ */
+template <typename Traits>
+void BasicOrderbook<Traits>::SetAccountLimitsInternal(AccountId account, const AccountLimits& limits)
+{
+	// Accounts the table did not cover yet have resting orders it never saw
+	if (const std::size_t firstNew = accounts_.Cover(account); firstNew <= account)
+	{
+		auto SeedLevel = [this, firstNew](Price, const PriceLevel& level)
+			{
+				storage_.ForEach(level.orders_, [this, firstNew](const Order& order)
+					{
+						if (order.GetAccount() >= firstNew)
+							accounts_.OnAdded(order);
+					});
+				return true;
+			};
+
+		bids_.ForEachLevel(SeedLevel);
+		asks_.ForEachLevel(SeedLevel);
+	}
+
+	accounts_.SetLimits(account, limits);
+}
+
+/**
+ * @brief Returns an account's exposure (zero if it was never limited).
+ */
+template <typename Traits>
+AccountExposure BasicOrderbook<Traits>::GetAccountExposure(AccountId account) const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	return accounts_.Exposure(account);
+}
+
+/**
+ * @brief Reads the best level of each side from its running aggregates.
+ */
+template <typename Traits>
+TopOfBook BasicOrderbook<Traits>::GetTopOfBook() const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+	return ReadTopOfBook();
+}
+
+/**
+ * @brief Builds a TopOfBook from the best level of each side.
+ */
+template <typename Traits>
+TopOfBook BasicOrderbook<Traits>::ReadTopOfBook() const
+{
+	TopOfBook top;
+	if (!bids_.Empty())
+	{
+		const auto& data = bids_.Best().data_;
+		top.bidPrice_ = bids_.BestPrice();
+		top.bidQuantity_ = data.quantity_;
+		top.bidCount_ = data.count_;
+	}
+	if (!asks_.Empty())
+	{
+		const auto& data = asks_.Best().data_;
+		top.askPrice_ = asks_.BestPrice();
+		top.askQuantity_ = data.quantity_;
+		top.askCount_ = data.count_;
+	}
+	return top;
+}
+
+/**
+ * @brief Constructs a snapshot of the current order book (bids and asks with aggregated quantities).
+ * @return OrderbookLevelInfos containing bid and ask levels.
+ */
+template <typename Traits>
+OrderbookLevelInfos BasicOrderbook<Traits>::GetOrderInfos() const
+{
+	std::uint64_t lastSequence;
+	return GetOrderInfos(lastSequence);
+}
+
+/**
+ * @brief Constructs a snapshot and reports the last level-update sequence it reflects.
+ * @param lastSequence Set to the sequence of the most recent level update emitted.
+ */
+template <typename Traits>
+OrderbookLevelInfos BasicOrderbook<Traits>::GetOrderInfos(std::uint64_t& lastSequence) const
+{
+	std::scoped_lock ordersLock{ ordersMutex_ };
+
+	lastSequence = levelUpdateSequence_;
+
+	LevelInfos bidInfos, askInfos;
+
+	bids_.ForEachLevel([&bidInfos](Price price, const PriceLevel& level)
+		{ bidInfos.push_back(LevelInfo{ price, level.data_.quantity_ }); return true; });
+
+	asks_.ForEachLevel([&askInfos](Price price, const PriceLevel& level)
+		{ askInfos.push_back(LevelInfo{ price, level.data_.quantity_ }); return true; });
+
+	return OrderbookLevelInfos{ bidInfos, askInfos };
+}
+
+extern template class BasicOrderbook<SharedOrderbookTraits>;
+extern template class BasicOrderbook<PooledOrderbookTraits>;
+extern template class BasicOrderbook<LadderOrderbookTraits>;
+extern template class BasicOrderbook<SingleWriterTraits<LadderOrderbookTraits>>;
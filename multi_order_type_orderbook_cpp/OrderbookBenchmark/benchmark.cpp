@@ -0,0 +1,772 @@
+/**
+ * @file benchmark.cpp
+ * @brief Google Benchmark suite for the order book's hot paths.
+ *
+ * Every scenario runs against each storage/level configuration and is
+ * parameterised by book depth (levels per side). Besides Google Benchmark's
+ * own timing, each reports items_per_second and the p50/p99/p99.9 latency of
+ * the measured call in nanoseconds, taken from a LatencyHistogram.
+ *
+ * BM_ContendedOrderFlow and BM_EngineOrderFlow are the scaling report: each
+ * runs with 1 to 8 producer threads sending the same seeded RandomOrderFlow,
+ * either straight into one locked book or through the single-writer engine's
+ * rings, and items_per_second is the total across threads. Where it stops
+ * growing with the thread count is where that design stops scaling.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++20 -O2 -DNDEBUG benchmark.cpp -o benchmark -lbenchmark -pthread
+ * Add -mavx2 (or -march=native) to use the vector depth kernels (DepthKernels.h).
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Orderbook.cpp"
+#include "../CrossVenueArbitrage.h"
+#include "../TriangularArbitrage.h"
+#include "../LatencyHistogram.h"
+#include "../MarketByPriceBook.h"
+#include "../MatchingEngine.h"
+#include "../RandomOrderFlow.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr Price MidPrice = 10'000;
+    constexpr Quantity LevelQuantity = 10;
+
+    /**
+     * @brief Times one call and records it in nanoseconds.
+     */
+    template <typename Function>
+    void Measure(LatencyHistogram& histogram, Function&& function)
+    {
+        const auto start = Clock::now();
+        function();
+        const auto end = Clock::now();
+        histogram.Record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+
+    /**
+     * @brief Publishes throughput and tail latency as benchmark counters.
+     */
+    void Report(benchmark::State& state, const LatencyHistogram& histogram)
+    {
+        state.SetItemsProcessed(static_cast<std::int64_t>(histogram.Count()));
+        state.counters["p50_ns"] = static_cast<double>(histogram.Percentile(50.0));
+        state.counters["p99_ns"] = static_cast<double>(histogram.Percentile(99.0));
+        state.counters["p99.9_ns"] = static_cast<double>(histogram.Percentile(99.9));
+    }
+
+    /**
+     * @brief Rests one order of LevelQuantity on each of depth levels per side around MidPrice.
+     * @return Next unused order id.
+     */
+    template <typename Book>
+    OrderId FillBook(Book& book, std::int64_t depth, OrderId orderId = 1)
+    {
+        for (std::int64_t level = 1; level <= depth; ++level)
+        {
+            book.AddOrder(Order{ OrderType::GoodTillCancel, orderId++, Side::Buy, static_cast<Price>(MidPrice - level), LevelQuantity });
+            book.AddOrder(Order{ OrderType::GoodTillCancel, orderId++, Side::Sell, static_cast<Price>(MidPrice + level), LevelQuantity });
+        }
+
+        return orderId;
+    }
+
+    /**
+     * @brief Rests count orders spread over WarmStartLevels levels per side.
+     */
+    constexpr std::int64_t WarmStartLevels = 1000;
+
+    template <typename Book>
+    void FillBookWithOrders(Book& book, std::int64_t count)
+    {
+        for (std::int64_t index = 0; index < count; ++index)
+        {
+            const bool isBid = index % 2 == 0;
+            const auto offset = static_cast<Price>(1 + index / 2 % WarmStartLevels);
+            book.AddOrder(Order{ OrderType::GoodTillCancel, static_cast<OrderId>(index + 1), isBid ? Side::Buy : Side::Sell,
+                isBid ? MidPrice - offset : MidPrice + offset, LevelQuantity });
+        }
+    }
+}
+
+/**
+ * @brief Adding a non-crossing order behind a deep passive book (then cancelling it untimed).
+ */
+template <typename Book>
+void BM_AddPassive(benchmark::State& state)
+{
+    const auto depth = state.range(0);
+    Book book;
+    OrderId orderId = FillBook(book, depth);
+    LatencyHistogram histogram;
+    std::int64_t level = 0;
+
+    for (auto _ : state)
+    {
+        const auto price = static_cast<Price>(MidPrice - 1 - level);
+        level = (level + 1) % depth;
+
+        const OrderId id = orderId++;
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.AddOrder(Order{ OrderType::GoodTillCancel, id, Side::Buy, price, 1 })); });
+        book.CancelOrder(id);
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief BM_AddPassive with orders spread over state.range(0) limited accounts,
+ *        so each add runs the pre-trade check and every event updates exposure.
+ */
+template <typename Book>
+void BM_AddPassiveWithAccountLimits(benchmark::State& state)
+{
+    constexpr std::int64_t Depth = 1000;
+    const auto accounts = state.range(0);
+    Book book;
+    OrderId orderId = FillBook(book, Depth);
+    for (std::int64_t account = 1; account <= accounts; ++account)
+        book.SetAccountLimits(static_cast<AccountId>(account), AccountLimits{ .maxPosition_ = 1'000'000, .maxNotional_ = 1'000'000'000 });
+    LatencyHistogram histogram;
+    std::int64_t level = 0;
+
+    for (auto _ : state)
+    {
+        const auto price = static_cast<Price>(MidPrice - 1 - level);
+        level = (level + 1) % Depth;
+
+        const OrderId id = orderId++;
+        const auto account = static_cast<AccountId>(1 + id % accounts);
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.AddOrder(Order{ OrderType::GoodTillCancel, id, Side::Buy, price, 1, Constants::NoExpiry, account })); });
+        book.CancelOrder(id);
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief One-lot trade at the touch with state.range(0) stops pending far from
+ *        it, half on each side (the traded lot is restored untimed). Stays flat
+ *        in the number of stops: a trade compares one trigger price per side.
+ */
+template <typename Book>
+void BM_TradeWithPendingStops(benchmark::State& state)
+{
+    constexpr std::int64_t Depth = 100;
+    const auto stops = state.range(0);
+    Book book;
+    OrderId orderId = FillBook(book, Depth);
+    for (std::int64_t stop = 0; stop < stops; ++stop)
+    {
+        const auto offset = static_cast<Price>(2 * Depth + stop / 2);
+        book.AddOrder(stop % 2 == 0
+            ? Order::Stop(orderId++, Side::Buy, MidPrice + offset, 1)
+            : Order::Stop(orderId++, Side::Sell, MidPrice - offset, 1));
+    }
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+    {
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.AddOrder(Order{ OrderType::FillAndKill, orderId++, Side::Buy, MidPrice + 1, 1 })); });
+        book.AddOrder(Order{ OrderType::GoodTillCancel, orderId++, Side::Sell, MidPrice + 1, 1 });
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Fill‑And‑Kill order of state.range(0) lots against an iceberg at the
+ *        touch that shows one lot: every lot is a fill and a replenish in place.
+ */
+template <typename Book>
+void BM_IcebergReplenish(benchmark::State& state)
+{
+    constexpr std::int64_t Depth = 100;
+    const auto lots = static_cast<Quantity>(state.range(0));
+    Book book;
+    OrderId orderId = FillBook(book, Depth);
+    book.AddOrder(Order::Iceberg(orderId++, Side::Sell, MidPrice, std::numeric_limits<Quantity>::max(), 1));
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.AddOrder(Order{ OrderType::FillAndKill, orderId++, Side::Buy, MidPrice, lots })); });
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief An aggressive order sweeping state.range(1) levels, then the swept levels are restored untimed.
+ */
+template <typename Book>
+void BM_AggressiveSweep(benchmark::State& state)
+{
+    const auto depth = state.range(0);
+    const auto sweep = std::min(state.range(1), depth);
+    Book book;
+    OrderId orderId = FillBook(book, depth);
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+    {
+        const auto limit = static_cast<Price>(MidPrice + sweep);
+        const auto quantity = static_cast<Quantity>(sweep) * LevelQuantity;
+
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.AddOrder(Order{ OrderType::FillAndKill, orderId++, Side::Buy, limit, quantity })); });
+
+        for (std::int64_t level = 1; level <= sweep; ++level)
+            book.AddOrder(Order{ OrderType::GoodTillCancel, orderId++, Side::Sell, static_cast<Price>(MidPrice + level), LevelQuantity });
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Fill‑Or‑Kill flow against a deep book: mostly rejected after walking many levels.
+ */
+template <typename Book>
+void BM_FillOrKill(benchmark::State& state)
+{
+    const auto depth = state.range(0);
+    Book book;
+    OrderId orderId = FillBook(book, depth);
+    LatencyHistogram histogram;
+
+    // Asks for one lot more than the whole side holds up to the limit, so it is killed
+    const auto limit = static_cast<Price>(MidPrice + depth);
+    const auto quantity = static_cast<Quantity>(depth) * LevelQuantity + 1;
+
+    for (auto _ : state)
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.AddOrder(Order{ OrderType::FillOrKill, orderId++, Side::Buy, limit, quantity })); });
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Cancelling every resting order of a deep book, refilled untimed between storms.
+ */
+template <typename Book>
+void BM_CancelStorm(benchmark::State& state)
+{
+    const auto depth = state.range(0);
+    Book book;
+    LatencyHistogram histogram;
+    std::vector<OrderId> resting;
+    OrderId orderId = 1;
+    std::size_t next = 0;
+
+    for (auto _ : state)
+    {
+        if (next == resting.size())
+        {
+            state.PauseTiming();
+            const OrderId first = orderId;
+            orderId = FillBook(book, depth, orderId);
+            resting.clear();
+            for (OrderId id = first; id < orderId; ++id)
+                resting.push_back(id);
+            next = 0;
+            state.ResumeTiming();
+        }
+
+        const OrderId id = resting[next++];
+        Measure(histogram, [&] { book.CancelOrder(id); });
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Modify churn: alternating in-place quantity cuts and price moves on resting orders.
+ */
+template <typename Book>
+void BM_ModifyChurn(benchmark::State& state)
+{
+    const auto depth = state.range(0);
+    Book book;
+    FillBook(book, depth);
+    LatencyHistogram histogram;
+    std::int64_t level = 0;
+    bool reprice = false;
+
+    for (auto _ : state)
+    {
+        // Bid of the level: ids alternate bid/ask starting at 1
+        const OrderId id = static_cast<OrderId>(2 * level + 1);
+        const auto home = static_cast<Price>(MidPrice - 1 - level);
+        const auto price = reprice ? static_cast<Price>(home - depth) : home;
+        const auto quantity = reprice ? LevelQuantity : static_cast<Quantity>(LevelQuantity / 2);
+
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.ModifyOrder(OrderModify{ id, Side::Buy, price, quantity })); });
+
+        // Put the order back where it started, untimed
+        book.ModifyOrder(OrderModify{ id, Side::Buy, home, LevelQuantity });
+
+        level = (level + 1) % depth;
+        reprice = !reprice;
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief A batch of BatchSize adds of random side and type, as a live feed
+ *        mixes them: passive Good‑Till‑Cancel and Good‑For‑Day orders,
+ *        Fill‑And‑Kill orders taking a lot at the touch and Fill‑Or‑Kill
+ *        orders one lot too large for it. The book is restored untimed.
+ *        Latencies are per batch.
+ */
+template <typename Book>
+void BM_MixedOrderFlow(benchmark::State& state)
+{
+    constexpr std::size_t BatchSize = 16;
+    const auto depth = state.range(0);
+    Book book;
+    OrderId orderId = FillBook(book, depth);
+    LatencyHistogram histogram;
+    std::mt19937 random{ 42 };
+    std::vector<Command> batch;
+    std::vector<Command> restore;
+    Trades trades;
+
+    for (auto _ : state)
+    {
+        batch.clear();
+        restore.clear();
+
+        for (std::size_t index = 0; index < BatchSize; ++index)
+        {
+            const auto draw = random();
+            const bool isBuy = (draw & 1) != 0;
+            const Side side = isBuy ? Side::Buy : Side::Sell;
+            const auto offset = static_cast<Price>(1 + (draw >> 3) % depth);
+            const Price passive = isBuy ? MidPrice - offset : MidPrice + offset;
+            const Price touch = isBuy ? MidPrice + 1 : MidPrice - 1;
+            const OrderId id = orderId++;
+
+            switch (draw >> 1 & 3)
+            {
+            case 0:
+                batch.push_back(Command::Add(Order{ OrderType::GoodTillCancel, id, side, passive, 1 }));
+                restore.push_back(Command::Cancel(id));
+                break;
+            case 1:
+                batch.push_back(Command::Add(Order{ OrderType::GoodForDay, id, side, passive, 1 }));
+                restore.push_back(Command::Cancel(id));
+                break;
+            case 2:
+                batch.push_back(Command::Add(Order{ OrderType::FillAndKill, id, side, touch, 1 }));
+                restore.push_back(Command::Add(Order{ OrderType::GoodTillCancel, orderId++, isBuy ? Side::Sell : Side::Buy, touch, 1 }));
+                break;
+            default:
+                batch.push_back(Command::Add(Order{ OrderType::FillOrKill, id, side, touch, LevelQuantity + 1 }));
+                break;
+            }
+        }
+
+        trades.clear();
+        Measure(histogram, [&] { book.ProcessBatch(batch, trades); });
+        book.ProcessBatch(restore, trades);
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Full snapshot of a deep book.
+ */
+template <typename Book>
+void BM_GetOrderInfos(benchmark::State& state)
+{
+    Book book;
+    FillBook(book, state.range(0));
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.GetOrderInfos()); });
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Lock-free top-of-book depth read.
+ */
+template <typename Book>
+void BM_GetDepth(benchmark::State& state)
+{
+    Book book;
+    FillBook(book, state.range(0));
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.GetDepth()); });
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Locked top-of-book read.
+ */
+template <typename Book>
+void BM_GetTopOfBook(benchmark::State& state)
+{
+    Book book;
+    FillBook(book, state.range(0));
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.GetTopOfBook()); });
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Lock-free read of the published top of book.
+ */
+template <typename Book>
+void BM_GetPublishedTopOfBook(benchmark::State& state)
+{
+    Book book;
+    FillBook(book, state.range(0));
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+        Measure(histogram, [&] { benchmark::DoNotOptimize(book.GetPublishedTopOfBook()); });
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Producer threads sending random flow straight into one shared book
+ *        through AddOrder / CancelOrder / ModifyOrder, all behind its mutex.
+ */
+template <typename Book>
+void BM_ContendedOrderFlow(benchmark::State& state)
+{
+    // Thread 0 replaces the book before the loop's start barrier releases the others
+    static std::unique_ptr<Book> book;
+    if (state.thread_index() == 0)
+        book = std::make_unique<Book>();
+
+    RandomOrderFlow flow{ static_cast<std::uint64_t>(state.thread_index()) + 1, (OrderId(state.thread_index()) + 1) << 40, MidPrice };
+    Trades trades;
+
+    for (auto _ : state)
+    {
+        const Command command = flow.Next();
+        if (command.type_ == CommandType::Add)
+            book->AddOrder(command.ToOrder(), trades);
+        else if (command.type_ == CommandType::Cancel)
+            book->CancelOrder(command.orderId_);
+        else
+            book->ModifyOrder(command.ToOrderModify(), trades);
+        trades.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief The same flow through MatchingEngine: one SPSC ring per producer
+ *        thread and a single matcher owning a lock-free book.
+ *
+ * Rings are small, so producers are held to the matcher's pace and at most a
+ * ring's worth of commands is still queued when the loop ends.
+ */
+void BM_EngineOrderFlow(benchmark::State& state)
+{
+    static std::unique_ptr<MatchingEngine<>> engine;
+    if (state.thread_index() == 0)
+    {
+        engine = std::make_unique<MatchingEngine<>>(static_cast<std::size_t>(state.threads()), -1, 1024);
+        engine->Start();
+    }
+
+    const auto producer = static_cast<std::size_t>(state.thread_index());
+    RandomOrderFlow flow{ producer + 1, (OrderId{ producer } + 1) << 40, MidPrice };
+    Trade trade;
+
+    for (auto _ : state)
+    {
+        const Command command = flow.Next();
+        while (!engine->Submit(producer, command))
+            while (engine->PollTrade(producer, trade)) { }
+        while (engine->PollTrade(producer, trade)) { }
+    }
+
+    // The matcher drops rather than waits for trade-ring space, so it stops without the producers
+    if (state.thread_index() == 0)
+        engine->Stop();
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Session-open rebuild by re-adding state.range(0) resting orders.
+ */
+template <typename Book>
+void BM_WarmStartByAdding(benchmark::State& state)
+{
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+        Measure(histogram, [&]
+        {
+            Book book{ static_cast<std::size_t>(state.range(0)) };
+            FillBookWithOrders(book, state.range(0));
+            benchmark::DoNotOptimize(book.Size());
+        });
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Session-open rebuild by adopting an image of a state.range(0)-order book.
+ */
+template <typename Book>
+void BM_WarmStartByAdoptingImage(benchmark::State& state)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "orderbook_benchmark.image").string();
+    {
+        Book book{ static_cast<std::size_t>(state.range(0)) };
+        FillBookWithOrders(book, state.range(0));
+        book.WriteImage(path);
+    }
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+        Measure(histogram, [&]
+        {
+            Book book{ static_cast<std::size_t>(state.range(0)) };
+            book.AdoptImage(path);
+            benchmark::DoNotOptimize(book.Size());
+        });
+
+    Report(state, histogram);
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Update-to-signal latency of a CrossVenueMonitor with state.range(0) venues.
+ *
+ * Each venue's book holds 100 levels per side, one tick either side of mid.
+ * Venues take turns improving their bid to mid and withdrawing it, so every
+ * update moves a top of book; the minimum edge of -1 makes every improvement
+ * a signal, so the timed call covers book update, detection and emission.
+ */
+void BM_CrossVenueDetection(benchmark::State& state)
+{
+    const auto venues = static_cast<std::size_t>(state.range(0));
+    CrossVenueMonitor<> monitor{ -1 };
+    const std::size_t pair = monitor.AddPair(1);
+    for (std::size_t venue = 0; venue < venues; ++venue)
+        monitor.AddVenue(static_cast<VenueId>(venue), 0);
+
+    std::vector<Command> fill;
+    for (OrderId orderId = 1; orderId <= 100; ++orderId)
+    {
+        fill.push_back(Command::Add(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, static_cast<Price>(MidPrice - orderId), LevelQuantity }));
+        fill.push_back(Command::Add(Order{ OrderType::GoodTillCancel, 1000 + orderId, Side::Sell, static_cast<Price>(MidPrice + orderId), LevelQuantity }));
+    }
+
+    std::uint64_t signals = 0;
+    auto sink = [&signals](const CrossVenueSignal& signal) { signals += signal.quantity_; };
+    for (std::size_t venue = 0; venue < venues; ++venue)
+        monitor.Apply(pair, venue, fill, 0, sink);
+
+    const Command improve[] = { Command::Add(Order{ OrderType::GoodTillCancel, 5000, Side::Buy, MidPrice, LevelQuantity }) };
+    const Command withdraw[] = { Command::Cancel(5000) };
+    LatencyHistogram histogram;
+    std::uint64_t timestamp = 0;
+    std::size_t venue = 0;
+
+    for (auto _ : state)
+    {
+        Measure(histogram, [&] { monitor.Apply(pair, venue, improve, ++timestamp, sink); });
+        Measure(histogram, [&] { monitor.Apply(pair, venue, withdraw, ++timestamp, sink); });
+        venue = venue + 1 == venues ? 0 : venue + 1;
+    }
+
+    benchmark::DoNotOptimize(signals);
+    Report(state, histogram);
+}
+
+/**
+ * @brief Top-of-book update latency of a TriangularDetector over state.range(0)
+ *        currencies with a pair between every two of them.
+ *
+ * Each pair closes a triangle with every other currency, so an update
+ * re-evaluates 2 * (currencies - 2) cycles. Tops are consistent (every rate
+ * is 1), so nothing is signalled and the timed call is pure evaluation.
+ */
+void BM_TriangularUpdate(benchmark::State& state)
+{
+    const auto currencies = static_cast<CurrencyId>(state.range(0));
+    TriangularDetector detector{ 0.0001 };
+    for (CurrencyId base = 0; base < currencies; ++base)
+        for (CurrencyId quote = base + 1; quote < currencies; ++quote)
+            detector.AddPair(static_cast<InstrumentId>(detector.PairCount()), base, quote, MidPrice);
+
+    std::uint64_t signals = 0;
+    auto sink = [&signals](const TriangularSignal&) { ++signals; };
+    for (std::size_t pair = 0; pair < detector.PairCount(); ++pair)
+        detector.OnTopOfBook(pair, TopOfBook{ MidPrice - 1, LevelQuantity, 1, MidPrice + 1, LevelQuantity, 1 }, 0, sink);
+
+    LatencyHistogram histogram;
+    std::uint64_t timestamp = 0;
+    std::size_t pair = 0;
+
+    for (auto _ : state)
+    {
+        const Quantity quantity = LevelQuantity + static_cast<Quantity>(timestamp & 1);
+        Measure(histogram, [&] { detector.OnTopOfBook(pair, TopOfBook{ MidPrice - 1, quantity, 1, MidPrice + 1, quantity, 1 }, ++timestamp, sink); });
+        pair = pair + 1 == detector.PairCount() ? 0 : pair + 1;
+    }
+
+    benchmark::DoNotOptimize(signals);
+    Report(state, histogram);
+}
+
+/**
+ * @brief Level quantity change on a market-by-price book of state.range(0) levels
+ *        per side, the aggregated counterpart of BM_AddPassive.
+ */
+void BM_MarketByPriceSetLevel(benchmark::State& state)
+{
+    const auto depth = state.range(0);
+    MarketByPriceBook book{ static_cast<std::size_t>(depth) };
+    for (std::int64_t level = 1; level <= depth; ++level)
+    {
+        book.SetLevel(Side::Buy, static_cast<Price>(MidPrice - level), LevelQuantity, 1);
+        book.SetLevel(Side::Sell, static_cast<Price>(MidPrice + level), LevelQuantity, 1);
+    }
+    LatencyHistogram histogram;
+    std::int64_t level = 0;
+    Quantity quantity = LevelQuantity;
+
+    for (auto _ : state)
+    {
+        const auto price = static_cast<Price>(MidPrice - 1 - level);
+        level = (level + 1) % depth;
+        quantity = quantity == LevelQuantity ? LevelQuantity + 1 : LevelQuantity;
+
+        Measure(histogram, [&] { book.SetLevel(Side::Buy, price, quantity, 2); });
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief A new best level appears and disappears on a market-by-price book.
+ */
+void BM_MarketByPriceNewBest(benchmark::State& state)
+{
+    const auto depth = state.range(0);
+    MarketByPriceBook book{ static_cast<std::size_t>(depth) + 1 };
+    for (std::int64_t level = 1; level <= depth; ++level)
+    {
+        book.SetLevel(Side::Buy, static_cast<Price>(MidPrice - level), LevelQuantity, 1);
+        book.SetLevel(Side::Sell, static_cast<Price>(MidPrice + level), LevelQuantity, 1);
+    }
+    LatencyHistogram histogram;
+
+    for (auto _ : state)
+    {
+        Measure(histogram, [&] { book.SetLevel(Side::Buy, MidPrice, LevelQuantity, 1); });
+        Measure(histogram, [&] { book.DeleteLevel(Side::Buy, MidPrice); });
+    }
+
+    Report(state, histogram);
+}
+
+/**
+ * @brief Sweep cost over state.range(0) contiguous levels, filling about three quarters of them.
+ *
+ * A call takes a few nanoseconds, below what Measure can resolve, so this
+ * reports Google Benchmark's own per-iteration time only.
+ */
+void BM_SweepKernel(benchmark::State& state)
+{
+    std::vector<LevelInfo> levels;
+    for (std::int64_t level = 1; level <= state.range(0); ++level)
+        levels.push_back(LevelInfo{ static_cast<Price>(MidPrice + level), LevelQuantity });
+    auto quantity = static_cast<Quantity>(state.range(0) * LevelQuantity * 3 / 4);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(quantity);
+        benchmark::DoNotOptimize(DepthKernels::Sweep(levels, quantity));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Quantity up to a price three quarters of the way through state.range(0) contiguous levels.
+ */
+void BM_QuantityUpToKernel(benchmark::State& state)
+{
+    std::vector<LevelInfo> levels;
+    for (std::int64_t level = 1; level <= state.range(0); ++level)
+        levels.push_back(LevelInfo{ static_cast<Price>(MidPrice + level), LevelQuantity });
+    auto price = static_cast<Price>(MidPrice + state.range(0) * 3 / 4);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(price);
+        benchmark::DoNotOptimize(DepthKernels::QuantityUpTo(levels, Side::Sell, price));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define ORDERBOOK_BENCHMARKS(Book) \
+    BENCHMARK_TEMPLATE(BM_AddPassive, Book)->RangeMultiplier(10)->Range(10, 1000); \
+    BENCHMARK_TEMPLATE(BM_AggressiveSweep, Book)->ArgsProduct({ { 100, 1000 }, { 1, 10, 50 } }); \
+    BENCHMARK_TEMPLATE(BM_FillOrKill, Book)->RangeMultiplier(10)->Range(10, 1000); \
+    BENCHMARK_TEMPLATE(BM_CancelStorm, Book)->RangeMultiplier(10)->Range(10, 1000); \
+    BENCHMARK_TEMPLATE(BM_ModifyChurn, Book)->RangeMultiplier(10)->Range(10, 1000); \
+    BENCHMARK_TEMPLATE(BM_MixedOrderFlow, Book)->RangeMultiplier(10)->Range(10, 1000); \
+    BENCHMARK_TEMPLATE(BM_GetOrderInfos, Book)->RangeMultiplier(10)->Range(10, 1000); \
+    BENCHMARK_TEMPLATE(BM_GetDepth, Book)->RangeMultiplier(10)->Range(10, 1000); \
+    BENCHMARK_TEMPLATE(BM_GetTopOfBook, Book)->Arg(1000); \
+    BENCHMARK_TEMPLATE(BM_GetPublishedTopOfBook, Book)->Arg(1000)
+
+ORDERBOOK_BENCHMARKS(Orderbook);
+ORDERBOOK_BENCHMARKS(PooledOrderbook);
+ORDERBOOK_BENCHMARKS(LadderOrderbook);
+
+BENCHMARK_TEMPLATE(BM_AddPassiveWithAccountLimits, PooledOrderbook)->Arg(16)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TradeWithPendingStops, PooledOrderbook)->Arg(0)->Arg(16)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_IcebergReplenish, Orderbook)->Arg(1)->Arg(10);
+BENCHMARK_TEMPLATE(BM_IcebergReplenish, PooledOrderbook)->Arg(1)->Arg(10);
+
+BENCHMARK_TEMPLATE(BM_ContendedOrderFlow, Orderbook)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ContendedOrderFlow, LadderOrderbook)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_EngineOrderFlow)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK(BM_SweepKernel)->Arg(10)->Arg(64);
+BENCHMARK(BM_QuantityUpToKernel)->Arg(10)->Arg(64);
+BENCHMARK(BM_MarketByPriceSetLevel)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK(BM_MarketByPriceNewBest)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK(BM_CrossVenueDetection)->Arg(2)->Arg(8);
+BENCHMARK(BM_TriangularUpdate)->Arg(3)->Arg(8)->Arg(16);
+
+// Images need pool-backed storage
+BENCHMARK_TEMPLATE(BM_WarmStartByAdding, PooledOrderbook)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WarmStartByAdoptingImage, PooledOrderbook)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WarmStartByAdding, LadderOrderbook)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WarmStartByAdoptingImage, LadderOrderbook)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,450 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "Command.h"
+#include "GoodForDayTimer.h"
+#include "MemoryPlacement.h"
+#include "OrderOwners.h"
+#include "Orderbook.h"
+#include "SpscRing.h"
+#include "ThreadAffinity.h"
+
+/**
+ * @brief A trade tagged with the instrument whose book produced it.
+ */
+struct InstrumentTrade
+{
+    InstrumentId instrumentId_{ };
+    Trade trade_;
+};
+
+/**
+ * @brief Multi-instrument engine: books sharded across pinned single-writer workers.
+ *
+ * Instruments are registered before Start() and assigned to shards round robin
+ * (or explicitly). Each shard is one thread that exclusively owns its books and
+ * busy-polls one SPSC command ring per producer; trades go back on one SPSC ring
+ * per (shard, producer), to the producers that own either of the trade's
+ * orders (see OrderOwners.h). Shards share nothing on the hot path, so independent
+ * instruments scale with the number of shards. Each run of consecutive
+ * commands for one book goes to it in one ProcessBatch call, so the book
+ * publishes its depth and top of book once per run.
+ *
+ * A single GoodForDayTimer serves every book: at the cutoff it injects one
+ * PruneGoodForDay command into each shard's control ring, and the shard
+ * starts expiring Good‑For‑Day orders in all of its books. Like every
+ * expiry, it then runs a slice of BookTraits::ExpirySlice orders per book and
+ * poll, between producer commands, until done; Good‑Till‑Date orders are
+ * expired the same way once due. A shard keeps the books that have anything
+ * to expire and their earliest expiry, so a poll with nothing due costs the
+ * same however many books the shard hosts.
+ *
+ * A pinned shard first places its books and rings on its core's NUMA node,
+ * pre-faulted and locked (see MemoryPlacement.h), and Start returns only once
+ * every shard is done, so no shard takes a page fault on its first commands.
+ * Unpinned shards leave memory where it is.
+ *
+ * Producer i must be a single thread and must keep draining its trades: a
+ * shard never waits on a producer, so a trade that finds that producer's
+ * ring full is dropped and counted (see DroppedTrades).
+ */
+template <typename BookTraits = LadderOrderbookTraits>
+class OrderbookEngine {
+    public:
+        using Book = BasicOrderbook<SingleWriterTraits<BookTraits>>;
+
+        static_assert(std::same_as<typename BookTraits::Storage, PooledOrderStorage>,
+            "Trade routing indexes owners by slab slot, so the engine needs pool-backed books.");
+
+        static constexpr std::size_t DefaultRingCapacity = 1 << 12;
+
+        /**
+         * @param producerCount Number of producer threads.
+         * @param cores One entry per shard: the core to pin it to, or negative for unpinned.
+         * @param ringCapacity Capacity of each command and trade ring (power of two).
+         * @param orderCapacity Orders each book reserves room for.
+         */
+        OrderbookEngine (std::size_t producerCount, const std::vector<int>& cores,
+            std::size_t ringCapacity = DefaultRingCapacity,
+            std::size_t orderCapacity = Book::DefaultOrderCapacity)
+            : producerCount_ { producerCount }
+            , orderCapacity_ { orderCapacity }
+        {
+            if (cores.empty())
+                throw std::invalid_argument("OrderbookEngine needs at least one shard.");
+
+            shards_.reserve(cores.size());
+            for (int core : cores)
+                shards_.push_back(std::make_unique<Shard>(core, producerCount, ringCapacity));
+        }
+
+        OrderbookEngine(const OrderbookEngine&) = delete;
+        void operator=(const OrderbookEngine&) = delete;
+
+        ~OrderbookEngine () { Stop(); }
+
+        /**
+         * @brief Registers an instrument on the next shard (round robin). Only before Start().
+         * @return Index of the shard that owns the new book.
+         */
+        std::size_t AddInstrument (InstrumentId instrumentId) {
+            return AddInstrument(instrumentId, routes_.size() % shards_.size());
+        }
+
+        /**
+         * @brief Registers an instrument on a given shard. Only before Start().
+         * @throws std::logic_error if the instrument is already registered or the engine runs.
+         */
+        std::size_t AddInstrument (InstrumentId instrumentId, std::size_t shard) {
+            if (running_.load())
+                throw std::logic_error("Instruments must be added before the engine starts.");
+            if (routes_.contains(instrumentId))
+                throw std::logic_error("Instrument already registered.");
+
+            auto& books = shards_.at(shard)->books_;
+            routes_.insert({ instrumentId, Route{ static_cast<std::uint32_t>(shard), static_cast<std::uint32_t>(books.size()) } });
+            books.push_back(BookSlot{ instrumentId, std::make_unique<Book>(orderCapacity_), OrderOwners<Book>{ orderCapacity_ } });
+            shards_[shard]->expiring_.reserve(books.size());
+            return shard;
+        }
+
+        /**
+         * @brief Starts every shard thread and, once all have pinned themselves
+         *        and placed their memory, the shared Good‑For‑Day timer.
+         */
+        void Start () {
+            if (running_.exchange(true))
+                return;
+
+            readyShards_.store(0);
+            for (auto& shard : shards_)
+                shard->thread_ = std::thread{ [this, shard = shard.get()] { Run(*shard); } };
+            while (readyShards_.load(std::memory_order_acquire) != shards_.size())
+                std::this_thread::yield();
+
+            timer_ = std::make_unique<GoodForDayTimer>([this]
+            {
+                for (auto& shard : shards_)
+                    shard->control_.TryPush(ShardCommand{ AllBooks, Command::PruneGoodForDay({ }, BookTraits::ExpirySlice) });
+            });
+        }
+
+        /**
+         * @brief Stops the timer, lets every shard apply the commands already submitted, and joins them.
+         */
+        void Stop () {
+            timer_.reset();
+
+            if (!running_.exchange(false))
+                return;
+
+            for (auto& shard : shards_)
+                shard->thread_.join();
+        }
+
+        /**
+         * @brief Producer side: routes a command to the shard owning command.instrumentId_.
+         * @return False if the instrument is unknown or that shard's ring is full.
+         */
+        bool Submit (std::size_t producer, const Command& command) {
+            auto found = routes_.find(command.instrumentId_);
+            if (found == routes_.end())
+                return false;
+
+            const Route route = found->second;
+            return shards_[route.shard_]->commands_[producer]->TryPush(ShardCommand{ route.book_, command });
+        }
+
+        /**
+         * @brief Producer side: takes the next trade of an order this producer
+         *        added or modified, whether it was the aggressor or rested, from
+         *        any shard. A trade between two of its own orders comes once.
+         * @return False if no trade is waiting.
+         */
+        bool PollTrade (std::size_t producer, InstrumentTrade& trade) {
+            for (auto& shard : shards_)
+                if (shard->trades_[producer]->TryPop(trade))
+                    return true;
+
+            return false;
+        }
+
+        /**
+         * @return Trades dropped so far, across shards, because the producer's trade ring was full (any thread).
+         */
+        std::uint64_t DroppedTrades (std::size_t producer) const {
+            std::uint64_t dropped = 0;
+            for (const auto& shard : shards_)
+                dropped += shard->droppedTrades_[producer].load(std::memory_order_relaxed);
+            return dropped;
+        }
+
+        std::size_t ShardCount () const { return shards_.size(); }
+
+        /**
+         * @brief Where a shard's memory ended up; set by Start, empty if the shard is unpinned.
+         */
+        const MemoryPlacement& GetMemoryPlacement (std::size_t shard) const { return shards_.at(shard)->placement_; }
+
+        /**
+         * @brief The book of an instrument; only safe to use while the engine is stopped.
+         */
+        const Book& GetBook (InstrumentId instrumentId) const {
+            const Route route = routes_.at(instrumentId);
+            return *shards_[route.shard_]->books_[route.book_].book_;
+        }
+
+    private:
+        static constexpr std::uint32_t AllBooks = static_cast<std::uint32_t>(-1);
+        static constexpr std::size_t ControlRingCapacity = 16;
+        static constexpr std::size_t CommandsPerPoll = 64; // Per producer, keeps polling fair
+
+        using ProducerIndex = typename OrderOwners<Book>::ProducerIndex;
+
+        struct Route {
+            std::uint32_t shard_;
+            std::uint32_t book_;
+        };
+
+        struct ShardCommand {
+            std::uint32_t book_{ };
+            Command command_;
+        };
+
+        struct BookSlot {
+            InstrumentId instrumentId_;
+            std::unique_ptr<Book> book_;
+            OrderOwners<Book> owners_;
+            bool listed_{ false }; // On the shard's expiring_ list
+        };
+
+        struct Shard {
+            Shard (int core, std::size_t producerCount, std::size_t ringCapacity)
+                : droppedTrades_ ( producerCount )
+                , control_ { ControlRingCapacity }
+                , core_ { core }
+            {
+                for (std::size_t producer = 0; producer < producerCount; ++producer)
+                {
+                    commands_.push_back(std::make_unique<SpscRing<ShardCommand>>(ringCapacity));
+                    trades_.push_back(std::make_unique<SpscRing<InstrumentTrade>>(ringCapacity));
+                }
+            }
+
+            std::vector<BookSlot> books_;
+            std::vector<std::uint32_t> expiring_;   // Books with orders to expire, in no particular order
+            Expiry nextExpiry_{ Constants::NoExpiry }; // Earliest Good‑Till‑Date expiry among them, or earlier
+            bool expiringGoodForDay_{ false };      // Some of them may have a Good‑For‑Day expiry in progress
+            std::array<ShardCommand, CommandsPerPoll> drained_; // Shard thread only
+            std::array<Command, CommandsPerPoll> batch_;
+            std::vector<std::unique_ptr<SpscRing<ShardCommand>>> commands_; // One per producer
+            std::vector<std::unique_ptr<SpscRing<InstrumentTrade>>> trades_; // One per producer
+            std::vector<std::atomic<std::uint64_t>> droppedTrades_;          // One per producer
+            SpscRing<ShardCommand> control_; // Single producer: the timer thread
+            MemoryPlacement placement_;
+            int core_;
+            std::thread thread_;
+        };
+
+        void Run (Shard& shard) {
+            if (PinThisThread(shard.core_))
+                PlaceMemory(shard);
+            readyShards_.fetch_add(1, std::memory_order_release);
+
+            while (running_.load(std::memory_order_acquire))
+            {
+                if (!Poll(shard))
+                    CpuRelax();
+            }
+
+            // Apply whatever was submitted before Stop()
+            while (Poll(shard)) { }
+        }
+
+        /**
+         * @brief Moves the shard's books and rings to its node and makes them resident.
+         */
+        static void PlaceMemory (Shard& shard) {
+            const int node = NumaNodeOfCore(shard.core_);
+            for (const auto& slot : shard.books_)
+                PlaceMemoryOf(*slot.book_, node, shard.placement_);
+            PlaceMemoryOf(shard.control_, node, shard.placement_);
+            for (std::size_t producer = 0; producer < shard.commands_.size(); ++producer)
+            {
+                PlaceMemoryOf(*shard.commands_[producer], node, shard.placement_);
+                PlaceMemoryOf(*shard.trades_[producer], node, shard.placement_);
+            }
+        }
+
+        /** @return True if any command was applied. */
+        bool Poll (Shard& shard) {
+            bool worked = false;
+            ShardCommand command;
+
+            while (shard.control_.TryPop(command))
+            {
+                for (std::uint32_t book = 0; book < shard.books_.size(); ++book)
+                {
+                    Expire(shard.books_[book], command.command_);
+                    Track(shard, book);
+                }
+                worked = true;
+            }
+
+            for (std::size_t producer = 0; producer < producerCount_; ++producer)
+            {
+                auto& commands = *shard.commands_[producer];
+                std::size_t count = 0;
+                while (count < CommandsPerPoll && commands.TryPop(shard.drained_[count]))
+                    ++count;
+
+                Execute(shard, producer, count);
+                worked |= count != 0;
+            }
+
+            worked |= ExpireOrders(shard);
+            return worked;
+        }
+
+        /**
+         * @brief Applies the next slice of every expiry in progress or due in the shard's books.
+         * @return True if there was anything to expire.
+         */
+        bool ExpireOrders (Shard& shard) {
+            if (shard.expiring_.empty())
+                return false;
+
+            const Expiry now = ToExpiry(std::chrono::system_clock::now());
+            if (!shard.expiringGoodForDay_ && !IsDue(shard.nextExpiry_, now))
+                return false;
+
+            // Something is due: visit the listed books, dropping those left with nothing to expire
+            bool worked = false;
+            shard.nextExpiry_ = Constants::NoExpiry;
+            shard.expiringGoodForDay_ = false;
+
+            for (std::size_t index = 0; index < shard.expiring_.size(); )
+            {
+                auto& slot = shard.books_[shard.expiring_[index]];
+                if (slot.book_->IsExpiringGoodForDay())
+                {
+                    Expire(slot, Command::PruneGoodForDay({ }, BookTraits::ExpirySlice));
+                    worked = true;
+                }
+
+                if (IsDue(slot.book_->NextExpiry(), now))
+                {
+                    Expire(slot, Command::ExpireGoodTillDate(now, { }, BookTraits::ExpirySlice));
+                    worked = true;
+                }
+
+                const Expiry next = slot.book_->NextExpiry();
+                const bool expiringGoodForDay = slot.book_->IsExpiringGoodForDay();
+                if (next == Constants::NoExpiry && !expiringGoodForDay)
+                {
+                    slot.listed_ = false;
+                    shard.expiring_[index] = shard.expiring_.back();
+                    shard.expiring_.pop_back();
+                    continue;
+                }
+
+                shard.nextExpiry_ = Earlier(shard.nextExpiry_, next);
+                shard.expiringGoodForDay_ |= expiringGoodForDay;
+                ++index;
+            }
+
+            return worked;
+        }
+
+        /**
+         * @brief Lists a book that a command may have given orders to expire.
+         */
+        static void Track (Shard& shard, std::uint32_t book) {
+            auto& slot = shard.books_[book];
+            const Expiry next = slot.book_->NextExpiry();
+            const bool expiringGoodForDay = slot.book_->IsExpiringGoodForDay();
+            if (next == Constants::NoExpiry && !expiringGoodForDay)
+                return;
+
+            shard.nextExpiry_ = Earlier(shard.nextExpiry_, next);
+            shard.expiringGoodForDay_ |= expiringGoodForDay;
+            if (!std::exchange(slot.listed_, true))
+                shard.expiring_.push_back(book);
+        }
+
+        static bool IsDue (Expiry expiry, Expiry now) { return expiry != Constants::NoExpiry && expiry <= now; }
+
+        static Expiry Earlier (Expiry first, Expiry second) {
+            if (first == Constants::NoExpiry)
+                return second;
+            if (second == Constants::NoExpiry)
+                return first;
+            return std::min(first, second);
+        }
+
+        /** @brief Applies an expiry command (which never trades) to one book. */
+        void Expire (BookSlot& slot, const Command& command) {
+            slot.book_->ProcessBatch(std::span<const Command>{ &command, 1 }, [](const Trade&) { });
+        }
+
+        /**
+         * @brief Applies a producer's drained commands, each run of consecutive
+         *        commands for the same book in one ProcessBatch call.
+         */
+        void Execute (Shard& shard, std::size_t producer, std::size_t count) {
+            for (std::size_t first = 0; first < count; )
+            {
+                const std::uint32_t book = shard.drained_[first].book_;
+                std::size_t size = 0;
+                for (; first + size < count && shard.drained_[first + size].book_ == book; ++size)
+                    shard.batch_[size] = shard.drained_[first + size].command_;
+
+                auto& slot = shard.books_[book];
+                const std::span<const Command> commands{ shard.batch_.data(), size };
+                slot.owners_.Claim(*slot.book_, static_cast<ProducerIndex>(producer), commands);
+
+                slot.book_->ProcessBatch(commands, [&shard, &slot](const Trade& trade)
+                {
+                    const ProducerIndex bidOwner = slot.owners_.OwnerOf(*slot.book_, trade.GetBidTrade().orderId_);
+                    const ProducerIndex askOwner = slot.owners_.OwnerOf(*slot.book_, trade.GetAskTrade().orderId_);
+
+                    Deliver(shard, bidOwner, InstrumentTrade{ slot.instrumentId_, trade });
+                    if (askOwner != bidOwner)
+                        Deliver(shard, askOwner, InstrumentTrade{ slot.instrumentId_, trade });
+                });
+
+                slot.owners_.Place(*slot.book_, commands);
+                Track(shard, book);
+                first += size;
+            }
+        }
+
+        static void Deliver (Shard& shard, ProducerIndex producer, const InstrumentTrade& trade) {
+            if (producer == OrderOwners<Book>::NoProducer)
+                return;
+
+            if (!shard.trades_[producer]->TryPush(trade))
+                shard.droppedTrades_[producer].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::size_t producerCount_;
+        std::size_t orderCapacity_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+        std::unordered_map<InstrumentId, Route> routes_; // Read-only once started
+        std::unique_ptr<GoodForDayTimer> timer_;
+        std::atomic<bool> running_ { false };
+        std::atomic<std::size_t> readyShards_ { 0 };
+};
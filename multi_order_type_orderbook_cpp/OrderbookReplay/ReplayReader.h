@@ -0,0 +1,292 @@
+#pragma once
+
+/**
+ * @file ReplayReader.h
+ * @brief Allocation-free readers for replay files in the test script format or its binary variant.
+ *
+ * Text format: the A/M/C action lines of OrderbookTest/TestFiles, plus an
+ * optional "T <nanoseconds>" line that timestamps the actions after it, and
+ * an "X <nanoseconds>" line that expires Good-Till-Date orders due by then.
+ * GoodTillDate adds carry their expiry (nanoseconds) as a sixth field,
+ * Stop and StopLimit adds their stop price (a Stop ignores its price) and
+ * Iceberg adds their display quantity.
+ * R lines and blank lines are skipped, so test scripts replay unchanged.
+ *
+ *   T 1700000000000000000
+ *   A B GoodTillCancel 100 10 1
+ *   M 1 S 100 10
+ *   C 1
+ *   A S GoodTillDate 101 5 2 1700000060000000000
+ *   X 1700000060000000000
+ *
+ * Binary format: the 8-byte magic "OBREPLAY", then fixed 40-byte records
+ * (see ReplayRecord). Both readers work on a memory-mapped view and
+ * produce Commands directly.
+ */
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../Command.h"
+#include "../WireFormat.h"
+
+/**
+ * @brief One replayed instruction and the time it was recorded at (0 if untimed).
+ */
+struct ReplayAction
+{
+    std::uint64_t timestamp_{ };
+    Command command_;
+};
+
+/**
+ * @brief Layout of one binary replay record: an 8-byte little-endian timestamp
+ *        in nanoseconds followed by the command in WireCommand encoding.
+ */
+struct ReplayRecord
+{
+    static constexpr std::string_view Magic{ "OBREPLAY" };
+    static constexpr std::size_t Size = 8 + WireCommand::Size;
+
+    using Bytes = std::array<unsigned char, Size>;
+
+    /** @brief Serialises an action into one record. */
+    static Bytes Encode(const ReplayAction& action)
+    {
+        Bytes bytes{ };
+        LittleEndian::Store(bytes.data(), action.timestamp_);
+        WireCommand::Encode(action.command_, bytes.data() + 8);
+        return bytes;
+    }
+
+    /** @brief Deserialises one record without validation; use TryDecode for untrusted input. */
+    static ReplayAction Decode(const unsigned char* bytes)
+    {
+        return ReplayAction{ LittleEndian::Load<std::uint64_t>(bytes), WireCommand::Decode(bytes + 8) };
+    }
+
+    /**
+     * @brief Deserialises one record after checking its command's enum fields.
+     * @return False (action untouched) if the command is invalid.
+     */
+    static bool TryDecode(const unsigned char* bytes, ReplayAction& action)
+    {
+        Command command;
+        if (!WireCommand::TryDecode(std::span<const unsigned char>{ bytes + 8, WireCommand::Size }, command))
+            return false;
+
+        action = ReplayAction{ LittleEndian::Load<std::uint64_t>(bytes), command };
+        return true;
+    }
+};
+
+/**
+ * @brief Streams actions out of a text replay file without allocating.
+ */
+class TextReplayReader {
+    public:
+        explicit TextReplayReader (std::string_view text)
+            : text_ { text }
+        { }
+
+        /**
+         * @brief Parses the next action.
+         * @return False at the end of the input.
+         * @throws std::runtime_error on a malformed line (the message names the line).
+         */
+        bool Next (ReplayAction& action) {
+            while (position_ < text_.size())
+            {
+                auto end = text_.find('\n', position_);
+                if (end == std::string_view::npos)
+                    end = text_.size();
+
+                std::string_view line = text_.substr(position_, end - position_);
+                position_ = end + 1;
+                ++lineNumber_;
+
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+
+                if (line.empty() || line.front() == 'R')
+                    continue;
+
+                if (line.front() == 'T')
+                {
+                    line.remove_prefix(1);
+                    timestamp_ = ParseNumber<std::uint64_t>(line);
+                    continue;
+                }
+
+                action.timestamp_ = timestamp_;
+                ParseCommand(line, action.command_);
+                return true;
+            }
+
+            return false;
+        }
+
+        /** @return Number of lines consumed so far. */
+        std::size_t LineNumber () const { return lineNumber_; }
+
+    private:
+        void ParseCommand (std::string_view line, Command& command) const {
+            const char type = line.front();
+            line.remove_prefix(1);
+
+            if (type == 'A')
+            {
+                const Side side = ParseSide(NextField(line));
+                const OrderType orderType = ParseOrderType(NextField(line));
+                const auto price = ParseNumber<Price>(line);
+                const auto quantity = ParseNumber<Quantity>(line);
+                const auto orderId = ParseNumber<OrderId>(line);
+                switch (orderType)
+                {
+                case OrderType::GoodTillDate:
+                    command = Command::Add(Order{ orderType, orderId, side, price, quantity, ParseNumber<Expiry>(line) });
+                    break;
+                case OrderType::Stop:
+                    command = Command::Add(Order::Stop(orderId, side, ParseNumber<Price>(line), quantity));
+                    break;
+                case OrderType::StopLimit:
+                    command = Command::Add(Order::StopLimit(orderId, side, ParseNumber<Price>(line), price, quantity));
+                    break;
+                case OrderType::Iceberg:
+                    command = Command::Add(Order::Iceberg(orderId, side, price, quantity, ParseNumber<Quantity>(line)));
+                    break;
+                default:
+                    command = Command::Add(Order{ orderType, orderId, side, price, quantity });
+                    break;
+                }
+            }
+            else if (type == 'M')
+            {
+                const auto orderId = ParseNumber<OrderId>(line);
+                const Side side = ParseSide(NextField(line));
+                const auto price = ParseNumber<Price>(line);
+                const auto quantity = ParseNumber<Quantity>(line);
+                command = Command::Modify(OrderModify{ orderId, side, price, quantity });
+            }
+            else if (type == 'C')
+            {
+                command = Command::Cancel(ParseNumber<OrderId>(line));
+            }
+            else if (type == 'X')
+            {
+                command = Command::ExpireGoodTillDate(ParseNumber<Expiry>(line));
+            }
+            else Fail("unknown action");
+        }
+
+        /** @brief Splits the next space-separated field off the front of line. */
+        std::string_view NextField (std::string_view& line) const {
+            const auto begin = line.find_first_not_of(' ');
+            if (begin == std::string_view::npos)
+                Fail("missing field");
+
+            line.remove_prefix(begin);
+            const auto end = std::min(line.find(' '), line.size());
+            const auto field = line.substr(0, end);
+            line.remove_prefix(end);
+            return field;
+        }
+
+        template <typename Number>
+        Number ParseNumber (std::string_view& line) const {
+            const auto field = NextField(line);
+            Number value{ };
+            const auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+            if (error != std::errc{ } || end != field.data() + field.size())
+                Fail("bad number");
+            return value;
+        }
+
+        Side ParseSide (std::string_view field) const {
+            if (field == "B")
+                return Side::Buy;
+            if (field == "S")
+                return Side::Sell;
+            Fail("unknown side");
+        }
+
+        OrderType ParseOrderType (std::string_view field) const {
+            if (field == "GoodTillCancel")
+                return OrderType::GoodTillCancel;
+            if (field == "FillAndKill")
+                return OrderType::FillAndKill;
+            if (field == "FillOrKill")
+                return OrderType::FillOrKill;
+            if (field == "GoodForDay")
+                return OrderType::GoodForDay;
+            if (field == "Market")
+                return OrderType::Market;
+            if (field == "GoodTillDate")
+                return OrderType::GoodTillDate;
+            if (field == "Stop")
+                return OrderType::Stop;
+            if (field == "StopLimit")
+                return OrderType::StopLimit;
+            if (field == "Iceberg")
+                return OrderType::Iceberg;
+            Fail("unknown order type");
+        }
+
+        [[noreturn]] void Fail (const char* reason) const {
+            throw std::runtime_error("Replay line " + std::to_string(lineNumber_) + ": " + reason);
+        }
+
+        std::string_view text_;
+        std::size_t position_ { 0 };
+        std::size_t lineNumber_ { 0 };
+        std::uint64_t timestamp_ { 0 };
+};
+
+/**
+ * @brief Streams actions out of a binary replay file (magic included).
+ */
+class BinaryReplayReader {
+    public:
+        /**
+         * @throws std::runtime_error if the magic is missing or the size is not whole records.
+         */
+        explicit BinaryReplayReader (std::string_view bytes)
+            : bytes_ { bytes }
+        {
+            if (!IsBinary(bytes) || (bytes.size() - ReplayRecord::Magic.size()) % ReplayRecord::Size != 0)
+                throw std::runtime_error("Not a binary replay file.");
+
+            position_ = ReplayRecord::Magic.size();
+        }
+
+        /** @return True if bytes starts with the binary replay magic. */
+        static bool IsBinary (std::string_view bytes) {
+            return bytes.substr(0, ReplayRecord::Magic.size()) == ReplayRecord::Magic;
+        }
+
+        /**
+         * @return False at the end of the input.
+         * @throws std::runtime_error naming the record (counting from 0) if its command is invalid.
+         */
+        bool Next (ReplayAction& action) {
+            if (position_ == bytes_.size())
+                return false;
+
+            if (!ReplayRecord::TryDecode(reinterpret_cast<const unsigned char*>(bytes_.data() + position_), action))
+                throw std::runtime_error("Replay record " + std::to_string((position_ - ReplayRecord::Magic.size()) / ReplayRecord::Size)
+                    + ": invalid command");
+
+            position_ += ReplayRecord::Size;
+            return true;
+        }
+
+    private:
+        std::string_view bytes_;
+        std::size_t position_ { 0 };
+};
@@ -0,0 +1,225 @@
+/**
+ * @file replay.cpp
+ * @brief Standalone replay driver: feeds a recorded action file through a book and
+ *        reports throughput, trade count and per-command latency.
+ *
+ * Usage:
+ *   replay <file> [--book shared|pooled|ladder] [--paced [--speed X]]
+ *   replay <file.txt> --convert <file.bin>
+ *
+ * The input is memory-mapped and parsed in place (see ReplayReader.h); the
+ * binary variant is recognised by its magic. By default commands are applied
+ * back to back; --paced waits for each action's recorded timestamp (scaled by
+ * --speed) instead, counting from the first timed action. Untimed actions and
+ * timestamps that go backwards are applied without waiting. --convert writes the binary variant of a text file.
+ *
+ * Build (from this directory):
+ *   g++ -std=c++20 -O2 -DNDEBUG replay.cpp -o replay -pthread
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../Orderbook.cpp"
+#include "../LatencyHistogram.h"
+#include "../MappedFile.h"
+#include "../ThreadAffinity.h"
+#include "ReplayReader.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::string input_;
+        std::string book_{ "ladder" };
+        std::string convert_;
+        bool paced_{ false };
+        double speed_{ 1.0 };
+    };
+
+    struct Summary
+    {
+        std::uint64_t commands_{ };
+        std::uint64_t trades_{ };
+        std::uint64_t tradedQuantity_{ };
+        std::size_t restingOrders_{ };
+        Clock::duration elapsed_{ };
+        LatencyHistogram latency_;
+    };
+
+    /**
+     * @brief Applies every action of reader to a fresh book of the given type.
+     */
+    template <typename Book, typename Reader>
+    void Replay(Reader& reader, const Options& options, Summary& summary)
+    {
+        Book book;
+        ReplayAction action;
+
+        auto sink = [&summary](const Trade& trade)
+        {
+            ++summary.trades_;
+            summary.tradedQuantity_ += trade.GetBidTrade().quantity_;
+        };
+
+        std::uint64_t firstTimestamp = 0;  // Of the first timed action
+        std::uint64_t latestTimestamp = 0; // Latest reached so far
+        const auto start = Clock::now();
+
+        while (reader.Next(action))
+        {
+            // Untimed actions run at once; an earlier timestamp than one already reached does not turn the clock back
+            if (options.paced_ && action.timestamp_ != 0)
+            {
+                if (firstTimestamp == 0)
+                    firstTimestamp = action.timestamp_;
+                latestTimestamp = std::max(latestTimestamp, action.timestamp_);
+
+                const auto offset = std::chrono::nanoseconds(
+                    static_cast<std::int64_t>(static_cast<double>(latestTimestamp - firstTimestamp) / options.speed_));
+                while (Clock::now() - start < offset)
+                    CpuRelax();
+            }
+
+            const auto before = Clock::now();
+            book.ProcessBatch(std::span<const Command>{ &action.command_, 1 }, sink);
+            const auto after = Clock::now();
+
+            summary.latency_.Record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count()));
+            ++summary.commands_;
+        }
+
+        summary.elapsed_ = Clock::now() - start;
+        summary.restingOrders_ = book.Size();
+    }
+
+    template <typename Reader>
+    void ReplayWith(Reader& reader, const Options& options, Summary& summary)
+    {
+        if (options.book_ == "shared")
+            Replay<BasicOrderbook<SingleWriterTraits<SharedOrderbookTraits>>>(reader, options, summary);
+        else if (options.book_ == "pooled")
+            Replay<BasicOrderbook<SingleWriterTraits<PooledOrderbookTraits>>>(reader, options, summary);
+        else if (options.book_ == "ladder")
+            Replay<BasicOrderbook<SingleWriterTraits<LadderOrderbookTraits>>>(reader, options, summary);
+        else
+            throw std::runtime_error("Unknown book type " + options.book_);
+    }
+
+    void Convert(std::string_view text, const std::string& output)
+    {
+        std::ofstream file{ output, std::ios::binary };
+        file.write(ReplayRecord::Magic.data(), static_cast<std::streamsize>(ReplayRecord::Magic.size()));
+
+        TextReplayReader reader{ text };
+        ReplayAction action;
+        std::uint64_t records = 0;
+        while (reader.Next(action))
+        {
+            const auto bytes = ReplayRecord::Encode(action);
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            ++records;
+        }
+
+        if (!file)
+            throw std::runtime_error("Cannot write " + output);
+
+        std::printf("wrote %llu records to %s\n", static_cast<unsigned long long>(records), output.c_str());
+    }
+
+    void Print(const Summary& summary)
+    {
+        const double seconds = std::chrono::duration<double>(summary.elapsed_).count();
+        const auto& latency = summary.latency_;
+
+        std::printf("commands        %llu\n", static_cast<unsigned long long>(summary.commands_));
+        std::printf("elapsed         %.3f s\n", seconds);
+        std::printf("throughput      %.0f commands/s\n", seconds > 0 ? static_cast<double>(summary.commands_) / seconds : 0.0);
+        std::printf("trades          %llu (quantity %llu)\n",
+            static_cast<unsigned long long>(summary.trades_), static_cast<unsigned long long>(summary.tradedQuantity_));
+        std::printf("resting orders  %zu\n", summary.restingOrders_);
+        std::printf("latency ns      min %llu  p50 %llu  p99 %llu  p99.9 %llu  p99.99 %llu  max %llu\n",
+            static_cast<unsigned long long>(latency.Min()),
+            static_cast<unsigned long long>(latency.Percentile(50.0)),
+            static_cast<unsigned long long>(latency.Percentile(99.0)),
+            static_cast<unsigned long long>(latency.Percentile(99.9)),
+            static_cast<unsigned long long>(latency.Percentile(99.99)),
+            static_cast<unsigned long long>(latency.Max()));
+    }
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        if (argc < 2)
+            throw std::runtime_error("usage: replay <file> [--book shared|pooled|ladder] [--paced [--speed X]] [--convert <file.bin>]");
+
+        Options options;
+        options.input_ = argv[1];
+
+        for (int index = 2; index < argc; ++index)
+        {
+            const std::string_view argument{ argv[index] };
+            const bool hasValue = index + 1 < argc;
+
+            if (argument == "--book" && hasValue)
+                options.book_ = argv[++index];
+            else if (argument == "--convert" && hasValue)
+                options.convert_ = argv[++index];
+            else if (argument == "--speed" && hasValue)
+                options.speed_ = std::stod(argv[++index]);
+            else if (argument == "--paced")
+                options.paced_ = true;
+            else
+                throw std::runtime_error("Unknown argument " + std::string{ argument });
+        }
+
+        if (options.speed_ <= 0)
+            throw std::runtime_error("--speed must be positive");
+
+        return options;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = ParseOptions(argc, argv);
+        const MappedFile file{ options.input_ };
+
+        if (!options.convert_.empty())
+        {
+            Convert(file.View(), options.convert_);
+            return 0;
+        }
+
+        Summary summary;
+        if (BinaryReplayReader::IsBinary(file.View()))
+        {
+            BinaryReplayReader reader{ file.View() };
+            ReplayWith(reader, options, summary);
+        }
+        else
+        {
+            TextReplayReader reader{ file.View() };
+            ReplayWith(reader, options, summary);
+        }
+
+        Print(summary);
+        return 0;
+    }
+    catch (const std::exception& exception)
+    {
+        std::fprintf(stderr, "%s\n", exception.what());
+        return 1;
+    }
+}
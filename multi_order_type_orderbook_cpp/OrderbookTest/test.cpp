@@ -9,7 +9,22 @@
 
 #include "pch.h"
 
+#include <functional>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "../Orderbook.cpp"
+#include "../CrossVenueArbitrage.h"
+#include "../TriangularArbitrage.h"
+#include "../MatchingEngine.h"
+#include "../Journal.h"
+#include "../MarketByPriceBook.h"
+#include "../MarketDataFeed.h"
+#include "../OrderbookEngine.h"
+#include "../RandomOrderFlow.h"
+#include "../OrderbookReplay/ReplayReader.h"
+#include "../WireFormat.h"
 
 namespace googletest = ::testing;
 
@@ -266,18 +281,17 @@ public:
 };
 
 /**
- * @brief Parameterized test case that runs one test file.
+ * @brief Runs one test file against a book configuration.
  * 
  * For each test file, it:
  * 1. Parses actions and expected result.
- * 2. Executes actions on an Orderbook.
+ * 2. Executes actions on a book of type OrderbookType.
  * 3. Asserts final state matches expected counts.
  */
-TEST_P(OrderbookTestsFixture, OrderbookTestSuite)
+template <typename OrderbookType>
+void RunTestFile(const std::filesystem::path& file)
 {
     // Arrange
-    const auto file = OrderbookTestsFixture::TestFolderPath / GetParam();
-
     InputHandler handler;
     const auto [actions, result] = handler.GetInformations(file);
 
@@ -303,7 +317,7 @@ TEST_P(OrderbookTestsFixture, OrderbookTestSuite)
     };
 
     // Act
-    Orderbook orderbook;
+    OrderbookType orderbook;
     for (const auto& action : actions)
     {
         switch (action.type_)
@@ -335,6 +349,30 @@ TEST_P(OrderbookTestsFixture, OrderbookTestSuite)
     ASSERT_EQ(orderbookInfos.GetAsks().size(), result.askCount_);
 }
 
+/**
+ * @brief Parameterized test case that runs one test file on the original book.
+ */
+TEST_P(OrderbookTestsFixture, OrderbookTestSuite)
+{
+    RunTestFile<Orderbook>(OrderbookTestsFixture::TestFolderPath / GetParam());
+}
+
+/**
+ * @brief Parameterized test case that runs one test file on the pool-backed book.
+ */
+TEST_P(OrderbookTestsFixture, PooledOrderbookTestSuite)
+{
+    RunTestFile<PooledOrderbook>(OrderbookTestsFixture::TestFolderPath / GetParam());
+}
+
+/**
+ * @brief Parameterized test case that runs one test file on the price-ladder book.
+ */
+TEST_P(OrderbookTestsFixture, LadderOrderbookTestSuite)
+{
+    RunTestFile<LadderOrderbook>(OrderbookTestsFixture::TestFolderPath / GetParam());
+}
+
 /**
  * @brief List of test input files to run.
  * 
@@ -343,9 +381,2449 @@ TEST_P(OrderbookTestsFixture, OrderbookTestSuite)
 INSTANTIATE_TEST_CASE_P(Tests, OrderbookTestsFixture, googletest::ValuesIn({
     "Match_GoodTillCancel.txt",
     "Match_FillAndKill.txt",
+    "Match_FillAndKill_Partial.txt",
     "Match_FillOrKill_Hit.txt",
     "Match_FillOrKill_Miss.txt",
+    "Match_FillOrKill_Levels.txt",
     "Cancel_Success.txt",
     "Modify_Side.txt",
-    "Match_Market.txt"
-}));
\ No newline at end of file
+    "Modify_QuantityDown.txt",
+    "Match_Market.txt",
+    "Match_Market_WidePrices.txt"
+}));
+
+/**
+ * @brief The published depth holds the best levels with running quantities and tracks every change.
+ */
+TEST(OrderbookDepthTests, DepthTracksBestLevels)
+{
+    // Arrange
+    LadderOrderbook orderbook;
+    constexpr auto Depth = LadderOrderbookTraits::DepthLevels;
+
+    // Act
+    for (OrderId orderId = 1; orderId <= Depth + 5; ++orderId)
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, static_cast<Price>(100 + orderId), 10 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 100, Side::Buy, 100 + Depth + 5, 7 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 101, Side::Sell, 100 + Depth + 5, 12 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 102, Side::Sell, 200, 3 });
+    const auto depth = orderbook.GetDepth();
+
+    // Assert
+    ASSERT_EQ(depth.bidCount_, Depth);
+    ASSERT_EQ(depth.bids_[0].price_, static_cast<Price>(100 + Depth + 5));
+    ASSERT_EQ(depth.bids_[0].quantity_, 5u);
+    ASSERT_EQ(depth.bids_[1].price_, static_cast<Price>(100 + Depth + 4));
+    ASSERT_EQ(depth.bids_[Depth - 1].price_, 106);
+    ASSERT_EQ(depth.askCount_, 1u);
+    ASSERT_EQ(depth.asks_[0].price_, 200);
+    ASSERT_EQ(depth.asks_[0].quantity_, 3u);
+    ASSERT_TRUE(depth.Truncated(Side::Buy));
+    ASSERT_FALSE(depth.Truncated(Side::Sell));
+}
+
+/**
+ * @brief Depth queries sum, sweep and average the published levels.
+ */
+TEST(OrderbookDepthTests, SweepCostAndQuantityUpToPrice)
+{
+    // Arrange
+    LadderOrderbook orderbook;
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 101, 10 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 102, 20 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 104, 30 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Buy, 99, 5 });
+
+    // Act
+    const auto sweep = orderbook.GetSweepCost(Side::Buy, 35);
+    const auto shortSweep = orderbook.GetSweepCost(Side::Sell, 8);
+
+    // Assert
+    ASSERT_EQ(orderbook.GetQuantityUpTo(Side::Buy, 103), 30u);
+    ASSERT_EQ(orderbook.GetQuantityUpTo(Side::Buy, 100), 0u);
+    ASSERT_EQ(orderbook.GetQuantityUpTo(Side::Sell, 99), 5u);
+    ASSERT_EQ(sweep.quantity_, 35u);
+    ASSERT_EQ(sweep.worstPrice_, 104);
+    ASSERT_EQ(sweep.notional_, 10 * 101 + 20 * 102 + 5 * 104);
+    ASSERT_DOUBLE_EQ(sweep.Vwap(), (10.0 * 101 + 20.0 * 102 + 5.0 * 104) / 35);
+    ASSERT_EQ(shortSweep.quantity_, 5u);
+    ASSERT_EQ(shortSweep.worstPrice_, 99);
+    ASSERT_FALSE(sweep.truncated_);
+    ASSERT_FALSE(shortSweep.truncated_);
+}
+
+/**
+ * @brief A sweep that runs out of published levels while more rest past them says so.
+ */
+TEST(OrderbookDepthTests, SweepPastPublishedDepthIsTruncated)
+{
+    // Arrange
+    LadderOrderbook full, deeper;
+    constexpr auto Depth = LadderOrderbookTraits::DepthLevels;
+    for (OrderId orderId = 1; orderId <= Depth; ++orderId)
+    {
+        full.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Sell, static_cast<Price>(100 + orderId), 10 });
+        deeper.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Sell, static_cast<Price>(100 + orderId), 10 });
+    }
+    deeper.AddOrder(Order{ OrderType::GoodTillCancel, Depth + 1, Side::Sell, static_cast<Price>(100 + Depth + 1), 10 });
+
+    // Act
+    const auto fullSweep = full.GetSweepCost(Side::Buy, 10 * (Depth + 1));
+    const auto deeperSweep = deeper.GetSweepCost(Side::Buy, 10 * (Depth + 1));
+    const auto withinSweep = deeper.GetSweepCost(Side::Buy, 10 * Depth);
+
+    // Assert
+    ASSERT_EQ(fullSweep.quantity_, 10 * Depth);
+    ASSERT_FALSE(fullSweep.truncated_);
+    ASSERT_EQ(deeperSweep.quantity_, 10 * Depth);
+    ASSERT_EQ(deeperSweep.worstPrice_, static_cast<Price>(100 + Depth));
+    ASSERT_TRUE(deeperSweep.truncated_);
+    ASSERT_EQ(withinSweep.quantity_, 10 * Depth);
+    ASSERT_FALSE(withinSweep.truncated_);
+    ASSERT_EQ(deeper.GetQuantityUpTo(Side::Buy, static_cast<Price>(100 + Depth + 1)), 10 * Depth);
+    ASSERT_TRUE(deeper.GetDepth().Truncated(Side::Sell));
+}
+
+/**
+ * @brief Whichever kernels the target selects agree with the scalar reference.
+ */
+TEST(OrderbookDepthTests, KernelsMatchScalarReference)
+{
+    std::mt19937 random{ 7 };
+    std::vector<LevelInfo> levels;
+
+    for (int round = 0; round < 2000; ++round)
+    {
+        // Arrange
+        const auto side = round % 2 == 0 ? Side::Buy : Side::Sell;
+        levels.resize(random() % 24);
+        Price price = 1000;
+        for (auto& level : levels)
+        {
+            price += (side == Side::Buy ? -1 : 1) * static_cast<Price>(1 + random() % 3);
+            const auto quantity = random() % 8 == 0 ? 0x8000'0000u + random() % 100 : 1 + random() % 100;
+            level = LevelInfo{ price, static_cast<Quantity>(quantity) };
+        }
+        const auto limit = static_cast<Price>(1000 + (side == Side::Buy ? -1 : 1) * static_cast<Price>(random() % 80));
+        const auto quantity = static_cast<Quantity>(random() % 2000);
+
+        // Act
+        const auto sweep = DepthKernels::Sweep(levels, quantity);
+        const auto reference = DepthKernels::ScalarSweep(levels, quantity);
+
+        // Assert
+        ASSERT_EQ(DepthKernels::QuantityUpTo(levels, side, limit), DepthKernels::ScalarQuantityUpTo(levels, side, limit));
+        ASSERT_EQ(sweep.quantity_, reference.quantity_);
+        ASSERT_EQ(sweep.notional_, reference.notional_);
+        if (reference.quantity_ != 0)
+        {
+            ASSERT_EQ(sweep.worstPrice_, reference.worstPrice_);
+        }
+    }
+}
+
+/**
+ * @brief The published top of book moves only when the top changes, and
+ *        readers polling it while the book trades always see a consistent value.
+ */
+TEST(OrderbookDepthTests, PublishedTopOfBookIsConsistentUnderConcurrentReads)
+{
+    // Arrange
+    PooledOrderbook orderbook;
+    ASSERT_EQ(orderbook.GetPublishedTopOfBook().sequence_, 0u);
+
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 110, 10 });
+    const auto first = orderbook.GetPublishedTopOfBook();
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 90, 10 });
+    ASSERT_EQ(first.sequence_, 2u);
+    ASSERT_EQ(orderbook.GetPublishedTopOfBook().sequence_, first.sequence_);
+
+    // Every bid rests 10 lots and asks only trade with them, so a torn read would break quantity == 10 * count
+    std::atomic<bool> done{ false };
+    std::atomic<int> inconsistent{ 0 };
+    auto poll = [&]
+        {
+            std::uint64_t lastSequence = 0;
+            while (!done.load(std::memory_order_acquire))
+            {
+                const auto published = orderbook.GetPublishedTopOfBook();
+                const auto& top = published.top_;
+                if (published.sequence_ < lastSequence || top.bidQuantity_ != 10 * top.bidCount_
+                    || (top.HasBid() && (top.bidPrice_ < 100 || top.bidPrice_ > 120)))
+                    inconsistent.fetch_add(1, std::memory_order_relaxed);
+                lastSequence = published.sequence_;
+            }
+        };
+    std::thread readers[]{ std::thread{ poll }, std::thread{ poll } };
+
+    // Act
+    for (OrderId orderId = 10; orderId < 20'010; ++orderId)
+    {
+        const auto price = static_cast<Price>(100 + orderId % 21);
+        if (orderId % 3 == 0)
+            orderbook.AddOrder(Order{ OrderType::FillAndKill, orderId, Side::Sell, price, 10 });
+        else
+            orderbook.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, price, 10 });
+        if (orderId % 5 == 0)
+            orderbook.CancelOrder(orderId - 1);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers)
+        reader.join();
+
+    // Assert
+    ASSERT_EQ(inconsistent.load(), 0);
+    const auto last = orderbook.GetPublishedTopOfBook();
+    ASSERT_EQ(last.top_, orderbook.GetTopOfBook());
+    ASSERT_GT(last.sequence_, first.sequence_);
+}
+
+/**
+ * @brief Applying the level updates in sequence rebuilds exactly the book's levels.
+ */
+TEST(OrderbookLevelUpdateTests, UpdatesRebuildTheBook)
+{
+    // Arrange
+    PooledOrderbook orderbook;
+    std::map<std::pair<Side, Price>, Quantity> levels;
+    std::uint64_t expectedSequence = 1;
+
+    // Act
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 5 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 103, 8 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Sell, 99, 12 });
+    orderbook.ModifyOrder(OrderModify{ 3, Side::Sell, 103, 2 });
+    orderbook.CancelOrder(2);
+
+    LevelUpdate update;
+    while (orderbook.PollLevelUpdate(update))
+    {
+        ASSERT_EQ(update.sequence_, expectedSequence++);
+        if (update.orderCount_ == 0)
+            levels.erase({ update.side_, update.price_ });
+        else
+            levels[{ update.side_, update.price_ }] = update.quantity_;
+    }
+
+    // Assert
+    std::uint64_t lastSequence;
+    const auto infos = orderbook.GetOrderInfos(lastSequence);
+    ASSERT_EQ(lastSequence, expectedSequence - 1);
+    ASSERT_EQ(levels.size(), infos.GetBids().size() + infos.GetAsks().size());
+    for (const auto& level : infos.GetBids())
+        ASSERT_EQ(levels.at({ Side::Buy, level.price_ }), level.quantity_);
+    for (const auto& level : infos.GetAsks())
+        ASSERT_EQ(levels.at({ Side::Sell, level.price_ }), level.quantity_);
+}
+
+/**
+ * @brief A market-by-price book fed an order book's level updates shows the same depth and top.
+ */
+TEST(MarketByPriceBookTests, MirrorsTheOrderBookFromItsLevelUpdates)
+{
+    // Arrange
+    LadderOrderbook orderbook;
+    MarketByPriceBook mirror;
+
+    // Act
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 98, 5 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 100, 7 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Sell, 104, 8 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 5, Side::Sell, 102, 3 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 6, Side::Buy, 99, 1 });
+    orderbook.AddOrder(Order{ OrderType::FillAndKill, 7, Side::Sell, 100, 12 });
+    orderbook.CancelOrder(2);
+
+    LevelUpdate update;
+    while (orderbook.PollLevelUpdate(update))
+    {
+        ASSERT_EQ(update.sequence_, mirror.LastSequence() + 1);
+        mirror.Apply(update);
+    }
+
+    // Assert
+    const auto expected = orderbook.GetOrderInfos();
+    const auto actual = mirror.GetOrderInfos();
+    ASSERT_EQ(actual.GetBids().size(), expected.GetBids().size());
+    ASSERT_EQ(actual.GetAsks().size(), expected.GetAsks().size());
+    for (std::size_t index = 0; index < expected.GetBids().size(); ++index)
+    {
+        ASSERT_EQ(actual.GetBids()[index].price_, expected.GetBids()[index].price_);
+        ASSERT_EQ(actual.GetBids()[index].quantity_, expected.GetBids()[index].quantity_);
+    }
+    for (std::size_t index = 0; index < expected.GetAsks().size(); ++index)
+    {
+        ASSERT_EQ(actual.GetAsks()[index].price_, expected.GetAsks()[index].price_);
+        ASSERT_EQ(actual.GetAsks()[index].quantity_, expected.GetAsks()[index].quantity_);
+    }
+    ASSERT_EQ(mirror.GetTopOfBook(), orderbook.GetTopOfBook());
+    ASSERT_EQ(mirror.Size(), 4u);
+
+    mirror.SetLevel(Side::Sell, 101, 4, 2);
+    mirror.DeleteLevel(Side::Buy, 99);
+    const auto top = mirror.GetTopOfBook();
+    ASSERT_EQ(top.askPrice_, 101);
+    ASSERT_EQ(top.askCount_, 2u);
+    ASSERT_EQ(top.bidPrice_, 100);
+    ASSERT_EQ(top.bidQuantity_, 5u);
+}
+
+/**
+ * @brief A level set without an order count, as feed-only venues publish it,
+ *        shows in both the depth and the top of book.
+ */
+TEST(MarketByPriceBookTests, LevelsWithoutOrderCountCountAsOneOrder)
+{
+    // Arrange
+    MarketByPriceBook book;
+
+    // Act
+    book.SetLevel(Side::Buy, 100, 5, 0);
+    book.SetLevel(Side::Sell, 102, 3, 0);
+    book.SetLevel(Side::Sell, 101, 0, 0);
+
+    // Assert
+    const auto top = book.GetTopOfBook();
+    ASSERT_TRUE(top.HasBid());
+    ASSERT_TRUE(top.HasAsk());
+    ASSERT_EQ(top.bidCount_, 1u);
+    ASSERT_EQ(top.askPrice_, 102);
+    ASSERT_EQ(book.GetOrderInfos().GetBids().size(), 1u);
+    ASSERT_EQ(book.GetOrderInfos().GetAsks().size(), 1u);
+
+    book.Apply(LevelUpdate{ 1, Side::Buy, 100, 5, 0 });
+    ASSERT_FALSE(book.GetTopOfBook().HasBid());
+    ASSERT_EQ(book.Size(), 1u);
+}
+
+/**
+ * @brief Lock-free pooled book with a level-update ring small enough to overflow.
+ */
+struct SmallLevelUpdateRingTraits : SingleWriterTraits<PooledOrderbookTraits>
+{
+    static constexpr std::size_t LevelUpdateCapacity = 4;
+};
+
+/**
+ * @brief Updates that do not fit in the ring are dropped and show up as a sequence gap.
+ */
+TEST(OrderbookLevelUpdateTests, OverflowShowsAsSequenceGap)
+{
+    // Arrange
+    BasicOrderbook<SmallLevelUpdateRingTraits> orderbook;
+
+    // Act
+    for (OrderId orderId = 1; orderId <= 6; ++orderId)
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, static_cast<Price>(orderId), 1 });
+
+    // Assert
+    LevelUpdate update;
+    for (std::uint64_t sequence = 1; sequence <= 4; ++sequence)
+    {
+        ASSERT_TRUE(orderbook.PollLevelUpdate(update));
+        ASSERT_EQ(update.sequence_, sequence);
+    }
+    ASSERT_FALSE(orderbook.PollLevelUpdate(update));
+
+    orderbook.CancelOrder(1);
+    ASSERT_TRUE(orderbook.PollLevelUpdate(update));
+    ASSERT_EQ(update.sequence_, 7u);
+    ASSERT_EQ(update.orderCount_, 0u);
+}
+
+/**
+ * @brief Trades reach a sink or a reusable buffer exactly as the returned vector would hold them.
+ */
+TEST(OrderbookBatchTests, TradeSinkReceivesEveryTrade)
+{
+    // Arrange
+    Orderbook orderbook;
+    Trades buffer;
+    Quantity sunk = 0;
+    auto sink = [&sunk](const Trade& trade) { sunk += trade.GetBidTrade().quantity_; };
+
+    // Act
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 3 }, buffer);
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 101, 4 }, sink);
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 101, 5 }, sink);
+    orderbook.ModifyOrder(OrderModify{ 2, Side::Sell, 99, 4 }, buffer);
+    orderbook.AddOrder(std::make_shared<Order>(OrderType::FillAndKill, 4, Side::Buy, 99, 9), buffer);
+
+    // Assert
+    ASSERT_EQ(sunk, 5u);
+    ASSERT_EQ(buffer.size(), 1u);
+    ASSERT_EQ(buffer.front().GetAskTrade().orderId_, 2u);
+    ASSERT_EQ(buffer.front().GetAskTrade().quantity_, 4u);
+    ASSERT_EQ(orderbook.Size(), 0u);
+}
+
+/**
+ * @brief A batch gives the same result as the equivalent individual calls, with trades appended in order.
+ */
+TEST(OrderbookBatchTests, ProcessBatchMatchesIndividualCalls)
+{
+    // Arrange
+    const std::vector<Command> commands{
+        Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 }),
+        Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 100, 4 }),
+        Command::Add(Order{ OrderType::GoodForDay, 3, Side::Sell, 102, 5 }),
+        Command::Modify(OrderModify{ 1, Side::Buy, 102, 10 }),
+        Command::Add(Order{ OrderType::FillOrKill, 4, Side::Sell, 90, 50 }),
+        Command::Add(Order{ OrderType::GoodTillCancel, 5, Side::Sell, 105, 1 }),
+        Command::Cancel(5),
+        Command::PruneGoodForDay(),
+    };
+    Orderbook batched;
+    Trades trades{ Trade{ } }; // Existing contents are kept
+
+    // Act
+    batched.ProcessBatch(commands, trades);
+
+    // Assert
+    ASSERT_EQ(trades.size(), 3u);
+    ASSERT_EQ(trades[1].GetAskTrade().orderId_, 2u);
+    ASSERT_EQ(trades[2].GetBidTrade().orderId_, 1u);
+    ASSERT_EQ(trades[2].GetAskTrade().orderId_, 3u);
+    ASSERT_EQ(trades[2].GetAskTrade().quantity_, 5u);
+    ASSERT_EQ(batched.Size(), 1u);
+
+    const auto infos = batched.GetOrderInfos();
+    ASSERT_EQ(infos.GetBids().size(), 1u);
+    ASSERT_EQ(infos.GetBids().front().price_, 102);
+    ASSERT_EQ(infos.GetBids().front().quantity_, 5u);
+    ASSERT_TRUE(infos.GetAsks().empty());
+}
+
+/**
+ * @brief Crosses between orders of one account are resolved by the aggressor's
+ *        mode without trading, and matching carries on with other accounts.
+ */
+TEST(AccountRiskTests, SelfTradePreventionResolvesCrossesWithoutTrading)
+{
+    constexpr auto NoExpiry = Constants::NoExpiry;
+    constexpr AccountId Other = 9;
+
+    // Account 1 keeps the default mode: cancel the resting order
+    {
+        PooledOrderbook orderbook;
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, NoExpiry, 1 });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 101, 5, NoExpiry, Other });
+        const auto trades = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 101, 8, NoExpiry, 1 });
+
+        ASSERT_EQ(trades.size(), 1u);
+        ASSERT_EQ(trades[0].GetAskTrade().orderId_, 2u);
+        ASSERT_EQ(trades[0].GetAskTrade().quantity_, 5u);
+        ASSERT_EQ(orderbook.Size(), 1u);
+        ASSERT_EQ(orderbook.GetOrderInfos().GetBids().front().quantity_, 3u);
+    }
+
+    // Cancel the aggressor: what it has left after trading with others is dropped
+    {
+        PooledOrderbook orderbook;
+        orderbook.SetAccountLimits(2, AccountLimits{ .selfTradePrevention_ = SelfTradePrevention::CancelAggressor });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, NoExpiry, Other });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 101, 5, NoExpiry, 2 });
+        const auto trades = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 102, 8, NoExpiry, 2 });
+
+        ASSERT_EQ(trades.size(), 1u);
+        ASSERT_EQ(trades[0].GetAskTrade().orderId_, 1u);
+        ASSERT_EQ(orderbook.Size(), 1u);
+        ASSERT_TRUE(orderbook.GetOrderInfos().GetBids().empty());
+        ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().front().price_, 101);
+    }
+
+    // Decrement both: the smaller order leaves, the larger one loses its quantity
+    {
+        LadderOrderbook orderbook;
+        orderbook.SetAccountLimits(3, AccountLimits{ .selfTradePrevention_ = SelfTradePrevention::DecrementBoth });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, NoExpiry, 3 });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 100, 4, NoExpiry, Other });
+        const auto trades = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 100, 8, NoExpiry, 3 });
+
+        ASSERT_EQ(trades.size(), 1u);
+        ASSERT_EQ(trades[0].GetBidTrade().orderId_, 3u);
+        ASSERT_EQ(trades[0].GetAskTrade().quantity_, 3u);
+        ASSERT_EQ(orderbook.Size(), 1u);
+        ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().front().quantity_, 1u);
+        ASSERT_EQ(orderbook.GetTopOfBook().askCount_, 1u);
+    }
+
+    // A Fill‑Or‑Kill order that prevention would cut short is killed untouched
+    {
+        Orderbook orderbook;
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 5, NoExpiry, 4 });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 100, 5, NoExpiry, Other });
+        const auto trades = orderbook.AddOrder(Order{ OrderType::FillOrKill, 3, Side::Buy, 100, 10, NoExpiry, 4 });
+
+        ASSERT_TRUE(trades.empty());
+        ASSERT_EQ(orderbook.Size(), 2u);
+    }
+}
+
+/**
+ * @brief A Fill‑Or‑Kill order fills completely or not at all under every
+ *        self-trade prevention mode: its own resting orders never count as
+ *        fillable, and unless its mode cancels them they stop the fill.
+ */
+TEST(AccountRiskTests, FillOrKillIsAllOrNothingUnderSelfTradePrevention)
+{
+    constexpr auto NoExpiry = Constants::NoExpiry;
+    constexpr AccountId Account = 7;
+    constexpr AccountId Other = 8;
+
+    struct Case
+    {
+        SelfTradePrevention mode_;
+        Quantity quantity_;
+        std::size_t trades_;
+        std::size_t size_; // Orders resting afterwards
+    };
+
+    // Book: Other 10@100, own 5@100 behind it, Other 10@101
+    for (const Case& test : {
+        Case{ SelfTradePrevention::CancelResting, 15, 2, 1 },   // Fills from both others, cancels its own order
+        Case{ SelfTradePrevention::CancelResting, 25, 0, 3 },   // Only 20 is not its own
+        Case{ SelfTradePrevention::CancelAggressor, 10, 1, 2 }, // Fills before reaching its own order
+        Case{ SelfTradePrevention::CancelAggressor, 15, 0, 3 },
+        Case{ SelfTradePrevention::DecrementBoth, 10, 1, 2 },
+        Case{ SelfTradePrevention::DecrementBoth, 15, 0, 3 } })
+    {
+        PooledOrderbook orderbook;
+        orderbook.SetAccountLimits(Account, AccountLimits{ .selfTradePrevention_ = test.mode_ });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 10, NoExpiry, Other });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 100, 5, NoExpiry, Account });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 101, 10, NoExpiry, Other });
+
+        const auto trades = orderbook.AddOrder(Order{ OrderType::FillOrKill, 4, Side::Buy, 101, test.quantity_, NoExpiry, Account });
+
+        Quantity filled = 0;
+        for (const auto& trade : trades)
+            filled += trade.GetBidTrade().quantity_;
+
+        ASSERT_EQ(trades.size(), test.trades_) << static_cast<int>(test.mode_) << " " << test.quantity_;
+        ASSERT_EQ(filled, test.trades_ == 0 ? 0 : test.quantity_);
+        ASSERT_EQ(orderbook.Size(), test.size_);
+    }
+
+    // Own order at the touch: killed with its own order left resting, in every mode
+    for (const auto mode : { SelfTradePrevention::CancelResting, SelfTradePrevention::CancelAggressor, SelfTradePrevention::DecrementBoth })
+    {
+        LadderOrderbook orderbook;
+        orderbook.SetAccountLimits(Account, AccountLimits{ .selfTradePrevention_ = mode });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 10, NoExpiry, Account });
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 101, 10, NoExpiry, Other });
+
+        const auto trades = orderbook.AddOrder(Order{ OrderType::FillOrKill, 3, Side::Buy, 101, 20, NoExpiry, Account });
+
+        ASSERT_TRUE(trades.empty());
+        ASSERT_EQ(orderbook.Size(), 2u);
+        ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().front().price_, 100);
+    }
+}
+
+/**
+ * @brief Decrementing an iceberg's slice to zero shows its next slice instead
+ *        of cancelling it, whether it rests or is the aggressor.
+ */
+TEST(AccountRiskTests, DecrementBothKeepsAnIcebergsReserve)
+{
+    constexpr auto NoExpiry = Constants::NoExpiry;
+    constexpr AccountId Account = 3;
+    constexpr AccountId Other = 9;
+    const AccountLimits decrementBoth{ .selfTradePrevention_ = SelfTradePrevention::DecrementBoth };
+
+    // Resting iceberg: both its slices are decremented, the reserve stays
+    {
+        PooledOrderbook orderbook;
+        orderbook.SetAccountLimits(Account, decrementBoth);
+        orderbook.AddOrder(Order::Iceberg(1, Side::Sell, 100, 10, 4, Account));
+        const auto prevented = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 6, NoExpiry, Account });
+        const auto exposure = orderbook.GetAccountExposure(Account);
+        const auto asks = orderbook.GetOrderInfos().GetAsks();
+        const auto trades = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 100, 10, NoExpiry, Other });
+
+        ASSERT_TRUE(prevented.empty());
+        ASSERT_EQ(exposure, (AccountExposure{ 0, 0, 4, 400 }));
+        ASSERT_EQ(asks.size(), 1u);
+        ASSERT_EQ(asks.front().quantity_, 2u);
+        ASSERT_EQ(trades.size(), 2u);
+        ASSERT_EQ(trades[0].GetAskTrade().quantity_ + trades[1].GetAskTrade().quantity_, 4u);
+        ASSERT_EQ(orderbook.Size(), 1u);
+    }
+
+    // Aggressing iceberg: the resting order leaves, the iceberg rests with its next slice
+    {
+        LadderOrderbook orderbook;
+        orderbook.SetAccountLimits(Account, decrementBoth);
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 3, NoExpiry, Account });
+        const auto trades = orderbook.AddOrder(Order::Iceberg(2, Side::Buy, 100, 8, 3, Account));
+
+        ASSERT_TRUE(trades.empty());
+        ASSERT_EQ(orderbook.Size(), 1u);
+        ASSERT_EQ(orderbook.GetOrderInfos().GetBids().front().quantity_, 3u);
+        ASSERT_EQ(orderbook.GetAccountExposure(Account), (AccountExposure{ 0, 5, 0, 500 }));
+    }
+}
+
+/**
+ * @brief Position and notional limits count working orders and fills, and
+ *        reject the first order that would go past them.
+ */
+TEST(AccountRiskTests, LimitsRejectOrdersPastPositionOrNotional)
+{
+    // Arrange
+    constexpr auto NoExpiry = Constants::NoExpiry;
+    constexpr AccountId Account = 5;
+    PooledOrderbook orderbook;
+
+    // Resting before the account is limited: picked up when it is
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10, NoExpiry, Account });
+    orderbook.SetAccountLimits(Account, AccountLimits{ .maxPosition_ = 30, .maxNotional_ = 5000 });
+    ASSERT_EQ(orderbook.GetAccountExposure(Account), (AccountExposure{ 0, 10, 0, 1000 }));
+
+    // Act
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 25, NoExpiry, Account });  // Position 35
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 100, 20, NoExpiry, Account });  // Position 30
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Sell, 100, 15, NoExpiry, 6 });
+    const auto filled = orderbook.GetAccountExposure(Account);
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 5, Side::Sell, 200, 30, NoExpiry, Account }); // Notional 7500
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 6, Side::Sell, 200, 10, NoExpiry, Account });
+    orderbook.CancelOrder(3);
+    orderbook.ModifyOrder(OrderModify{ 6, Side::Sell, 201, 10 });
+
+    // Assert
+    ASSERT_EQ(filled, (AccountExposure{ 15, 15, 0, 1500 }));
+    ASSERT_EQ(orderbook.GetAccountExposure(Account), (AccountExposure{ 15, 0, 10, 2010 }));
+    ASSERT_EQ(orderbook.Size(), 1u);
+    ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().front().price_, 201);
+    ASSERT_EQ(orderbook.GetAccountExposure(6), AccountExposure{ });
+    ASSERT_THROW(orderbook.SetAccountLimits(Constants::NoAccount, AccountLimits{ }), std::logic_error);
+}
+
+/**
+ * @brief A modify that replaces an order is checked net of it: past the limit
+ *        the original keeps resting, within it the replacement takes its place.
+ */
+TEST(AccountRiskTests, RejectedModifyKeepsTheOriginal)
+{
+    // Arrange
+    constexpr AccountId Account = 5;
+    PooledOrderbook orderbook;
+    orderbook.SetAccountLimits(Account, AccountLimits{ .maxPosition_ = 10 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 8, Constants::NoExpiry, Account });
+    orderbook.AddOrder(Order::Iceberg(2, Side::Sell, 110, 9, 3, Account));
+
+    // Act
+    orderbook.ModifyOrder(OrderModify{ 1, Side::Buy, 101, 12 });
+    orderbook.ModifyOrder(OrderModify{ 2, Side::Sell, 111, 11 });
+    const auto bidsAfterRejects = orderbook.GetOrderInfos().GetBids();
+    const auto asksAfterRejects = orderbook.GetOrderInfos().GetAsks();
+    const auto exposureAfterRejects = orderbook.GetAccountExposure(Account);
+
+    orderbook.ModifyOrder(OrderModify{ 1, Side::Buy, 101, 10 });
+    orderbook.ModifyOrder(OrderModify{ 2, Side::Sell, 111, 10 });
+
+    // Assert
+    ASSERT_EQ(bidsAfterRejects.size(), 1u);
+    ASSERT_EQ(bidsAfterRejects.front().price_, 100);
+    ASSERT_EQ(bidsAfterRejects.front().quantity_, 8u);
+    ASSERT_EQ(asksAfterRejects.front().price_, 110);
+    ASSERT_EQ(exposureAfterRejects, (AccountExposure{ 0, 8, 9, 1790 }));
+    ASSERT_EQ(orderbook.Size(), 2u);
+    ASSERT_EQ(orderbook.GetOrderInfos().GetBids().front().price_, 101);
+    ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().front().price_, 111);
+    ASSERT_EQ(orderbook.GetAccountExposure(Account), (AccountExposure{ 0, 10, 10, 2120 }));
+}
+
+/**
+ * @brief Journal records and snapshots keep the account of each order.
+ */
+TEST(AccountRiskTests, AccountsSurviveJournalAndSnapshot)
+{
+    // Arrange
+    PooledOrderbook original, restored;
+    original.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10, Constants::NoExpiry, 7 });
+    original.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 101, 10, Constants::NoExpiry, 65535 });
+    std::array<unsigned char, JournalRecord::Size> record{ };
+
+    // Act
+    JournalRecord::Encode(1, Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 99, 1, Constants::NoExpiry, 42 }), record.data());
+    std::uint64_t sequence = 0;
+    Command command;
+    const bool decoded = JournalRecord::TryDecode(record.data(), sequence, command);
+    SnapshotImage::Capture(original, 0).Restore(restored);
+
+    // Assert
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(command.ToOrder().GetAccount(), 42u);
+    std::vector<AccountId> accounts;
+    restored.ForEachOrder([&accounts](const Order& order) { accounts.push_back(order.GetAccount()); });
+    ASSERT_EQ(accounts, (std::vector<AccountId>{ 7, 65535 }));
+}
+
+/**
+ * @brief Stops wait off the book until a trade reaches their stop price, then
+ *        enter and may trigger further stops; one already reached enters at once.
+ */
+TEST(StopOrderTests, TriggerOnlyWhenTheLastTradeReachesThem)
+{
+    // Arrange
+    Orderbook orderbook;
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 101, 5 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 102, 5 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 105, 10 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Buy, 95, 10 });
+    orderbook.AddOrder(Order::Stop(10, Side::Buy, 102, 5));
+    orderbook.AddOrder(Order::StopLimit(11, Side::Buy, 103, 104, 3));
+    orderbook.AddOrder(Order::Stop(12, Side::Sell, 96, 2));
+    const auto sizeWithStops = orderbook.Size();
+    const auto topWithStops = orderbook.GetTopOfBook();
+
+    // Act
+    const auto belowStops = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 5, Side::Buy, 101, 5 });
+    const auto throughStops = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 6, Side::Buy, 102, 1 });
+    const auto topAfterTrigger = orderbook.GetTopOfBook();
+    orderbook.CancelOrder(12);
+    const auto sizeAfterCancel = orderbook.Size();
+    const auto alreadyReached = orderbook.AddOrder(Order::Stop(13, Side::Sell, 110, 1));
+
+    // Assert
+    ASSERT_EQ(sizeWithStops, 7u);
+    ASSERT_EQ(topWithStops.bidPrice_, 95);
+    ASSERT_EQ(topWithStops.askPrice_, 101);
+    ASSERT_EQ(belowStops.size(), 1u);
+
+    // 6 lifts 102, which triggers 10: its market buy sweeps 102 and reaches
+    // 105, which triggers 11, which rests at its limit below the new best ask
+    ASSERT_EQ(throughStops.size(), 3u);
+    ASSERT_EQ(throughStops[1].GetBidTrade().orderId_, 10u);
+    ASSERT_EQ(throughStops[1].GetAskTrade().price_, 102);
+    ASSERT_EQ(throughStops[2].GetAskTrade().price_, 105);
+    ASSERT_EQ(topAfterTrigger.bidPrice_, 104);
+    ASSERT_EQ(topAfterTrigger.bidQuantity_, 3u);
+    ASSERT_EQ(topAfterTrigger.askQuantity_, 9u);
+    ASSERT_EQ(sizeAfterCancel, 3u);
+
+    // The last trade (105) is already at or below 110
+    ASSERT_EQ(alreadyReached.size(), 1u);
+    ASSERT_EQ(alreadyReached[0].GetBidTrade().orderId_, 11u);
+}
+
+/**
+ * @brief A filled iceberg refills from its reserve behind its level without
+ *        leaving it, while its account is charged for the whole order.
+ */
+TEST(IcebergOrderTests, ReplenishInPlaceBehindTheirLevel)
+{
+    const auto Run = []<typename Book>()
+        {
+            // Arrange
+            Book orderbook;
+            orderbook.SetAccountLimits(5, AccountLimits{ });
+            orderbook.AddOrder(Order::Iceberg(1, Side::Sell, 100, 10, 4, 5));
+            orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 100, 3 });
+            const auto topBefore = orderbook.GetTopOfBook();
+            const auto exposureBefore = orderbook.GetAccountExposure(5);
+
+            // Act
+            const auto first = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 100, 4 });
+            const auto topAfterFirst = orderbook.GetTopOfBook();
+            const auto second = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Buy, 100, 5 });
+            const auto rest = orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 5, Side::Buy, 100, 10 });
+            const auto topAfterRest = orderbook.GetTopOfBook();
+
+            // Assert
+            ASSERT_EQ(topBefore.askQuantity_, 7u);
+            ASSERT_EQ(topBefore.askCount_, 2u);
+            ASSERT_EQ(exposureBefore.openSell_, 10);
+
+            ASSERT_EQ(first.size(), 1u);
+            ASSERT_EQ(topAfterFirst.askQuantity_, 7u);
+            ASSERT_EQ(topAfterFirst.askCount_, 2u);
+
+            // The refilled iceberg now queues behind 2
+            ASSERT_EQ(second.size(), 2u);
+            ASSERT_EQ(second[0].GetAskTrade().orderId_, 2u);
+            ASSERT_EQ(second[1].GetAskTrade().orderId_, 1u);
+            ASSERT_EQ(second[1].GetAskTrade().quantity_, 2u);
+
+            ASSERT_EQ(rest.size(), 2u);
+            ASSERT_EQ(rest[0].GetAskTrade().quantity_ + rest[1].GetAskTrade().quantity_, 4u);
+            ASSERT_EQ(topAfterRest.askQuantity_, 0u);
+            ASSERT_EQ(topAfterRest.bidQuantity_, 6u);
+            ASSERT_EQ(orderbook.GetAccountExposure(5), (AccountExposure{ -10, 0, 0, 0 }));
+        };
+
+    Run.template operator()<Orderbook>();
+    Run.template operator()<PooledOrderbook>();
+    Run.template operator()<LadderOrderbook>();
+}
+
+/**
+ * @brief A Fill‑Or‑Kill order counts an iceberg's reserve, which matching
+ *        sweeps through replenishment: it fills from it, or is killed untouched
+ *        when even the reserve falls short. Book images keep the reserve count.
+ */
+TEST(IcebergOrderTests, FillOrKillCountsTheReserve)
+{
+    // Arrange
+    const std::string imagePath = (std::filesystem::temp_directory_path() / ("orderbook_iceberg_" + std::to_string(::getpid()))).string();
+    PooledOrderbook orderbook, adopted;
+    orderbook.AddOrder(Order::Iceberg(1, Side::Sell, 100, 100, 10));
+    const auto Filled = [](const Trades& trades)
+        {
+            Quantity filled = 0;
+            for (const auto& trade : trades)
+                filled += trade.GetBidTrade().quantity_;
+            return filled;
+        };
+
+    // Act
+    const auto fromReserve = orderbook.AddOrder(Order{ OrderType::FillOrKill, 2, Side::Buy, 100, 50 });
+    const auto tooLarge = orderbook.AddOrder(Order{ OrderType::FillOrKill, 3, Side::Buy, 100, 51 });
+    const auto asksAfterKill = orderbook.GetOrderInfos().GetAsks();
+    orderbook.WriteImage(imagePath);
+    adopted.AdoptImage(imagePath);
+    const auto rest = adopted.AddOrder(Order{ OrderType::FillOrKill, 4, Side::Buy, 100, 50 });
+
+    // Assert
+    ASSERT_EQ(fromReserve.size(), 5u);
+    ASSERT_EQ(Filled(fromReserve), 50u);
+    ASSERT_TRUE(tooLarge.empty());
+    ASSERT_EQ(asksAfterKill.size(), 1u);
+    ASSERT_EQ(asksAfterKill.front().quantity_, 10u);
+    ASSERT_EQ(orderbook.Size(), 1u);
+    ASSERT_EQ(Filled(rest), 50u);
+    ASSERT_EQ(adopted.Size(), 0u);
+
+    std::filesystem::remove(imagePath);
+}
+
+/**
+ * @brief Pending stops and part-filled icebergs come back from a snapshot
+ *        as they were; a book image, which holds only resting orders, refuses stops.
+ */
+TEST(StopOrderTests, StopsAndIcebergsSurviveSnapshots)
+{
+    // Arrange
+    PooledOrderbook original, restored;
+    original.AddOrder(Order::Iceberg(1, Side::Sell, 100, 10, 4));
+    original.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 3 });
+    original.AddOrder(Order::StopLimit(3, Side::Buy, 101, 102, 2));
+    const auto Describe = [](const PooledOrderbook& book)
+        {
+            std::vector<std::tuple<OrderId, OrderType, Quantity, Quantity, Quantity>> orders;
+            book.ForEachOrder([&orders](const Order& order)
+                { orders.emplace_back(order.GetOrderId(), order.GetOrderType(), order.GetRemainingQuantity(), order.GetHiddenQuantity(), order.GetFilledQuantity()); });
+            return orders;
+        };
+
+    // Act
+    SnapshotImage::Capture(original, 0).Restore(restored);
+    const auto restoredOrders = Describe(restored);
+    const auto trades = restored.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Buy, 100, 7 });
+
+    // Assert
+    ASSERT_EQ(Describe(original), (std::vector<std::tuple<OrderId, OrderType, Quantity, Quantity, Quantity>>{
+        { 1, OrderType::Iceberg, 1, 6, 3 },
+        { 3, OrderType::StopLimit, 2, 0, 0 } }));
+    ASSERT_EQ(restoredOrders, Describe(original));
+    ASSERT_EQ(restored.Size(), 1u);
+    ASSERT_EQ(trades.size(), 3u);
+    ASSERT_THROW(original.WriteImage("stops.obimage"), std::logic_error);
+}
+
+/**
+ * @brief Snapshots and book images keep the last trade price, so a stop
+ *        placed through it after recovery triggers at once instead of resting.
+ */
+TEST(StopOrderTests, LastTradePriceSurvivesRecovery)
+{
+    // Arrange
+    const auto directory = std::filesystem::temp_directory_path() / ("orderbook_last_trade_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    const std::string snapshotPath = (directory / "book.snapshot").string();
+    const std::string imagePath = (directory / "book.obimage").string();
+
+    PooledOrderbook original, fromSnapshot, fromImage, untraded;
+    original.AddOrder(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 1 });
+    original.AddOrder(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 1 }); // Last trade at 100
+    original.AddOrder(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 105, 5 });
+
+    // Act
+    SnapshotImage::Capture(original, 0).Write(snapshotPath);
+    SnapshotImage::Load(snapshotPath).Restore(fromSnapshot);
+    original.WriteImage(imagePath);
+    fromImage.AdoptImage(imagePath);
+    SnapshotImage::Capture(untraded, 0).Restore(untraded);
+    const auto restoredLastTrade = fromSnapshot.GetLastTradePrice();
+
+    const auto snapshotTrades = fromSnapshot.AddOrder(Order::Stop(10, Side::Buy, 99, 2));
+    const auto imageTrades = fromImage.AddOrder(Order::Stop(10, Side::Buy, 99, 2));
+
+    // Assert
+    ASSERT_EQ(restoredLastTrade, std::optional<Price>{ 100 });
+    ASSERT_EQ(snapshotTrades.size(), 1u);
+    ASSERT_EQ(snapshotTrades[0].GetAskTrade().price_, 105);
+    ASSERT_EQ(fromSnapshot.Size(), 1u);
+    ASSERT_EQ(imageTrades.size(), 1u);
+    ASSERT_EQ(fromImage.Size(), 1u);
+    ASSERT_EQ(untraded.GetLastTradePrice(), std::nullopt);
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * @brief Sliced Good‑For‑Day expiry spares orders added after it began; Good‑Till‑Date orders expire when due.
+ */
+TEST(OrderbookExpiryTests, ExpiresOnlyDueOrdersInSlices)
+{
+    // Arrange
+    BasicOrderbook<SingleWriterTraits<PooledOrderbookTraits>> orderbook;
+    Trades trades;
+    std::vector<Command> commands;
+    for (OrderId orderId = 1; orderId <= 5; ++orderId)
+        commands.push_back(Command::Add(Order{ OrderType::GoodForDay, orderId, Side::Buy, 100, 1 }));
+    commands.push_back(Command::Add(Order{ OrderType::GoodTillCancel, 6, Side::Buy, 99, 1 }));
+    commands.push_back(Command::Add(Order{ OrderType::GoodTillDate, 7, Side::Sell, 105, 1, 1000 }));
+    commands.push_back(Command::Add(Order{ OrderType::GoodTillDate, 8, Side::Sell, 106, 3, 2000 }));
+    commands.push_back(Command::Add(Order{ OrderType::GoodTillDate, 9, Side::Sell, 107, 1 })); // No expiry: rejected
+    orderbook.ProcessBatch(commands, trades);
+    ASSERT_EQ(orderbook.Size(), 8u);
+    ASSERT_EQ(orderbook.NextExpiry(), 1000u);
+
+    const auto Apply = [&orderbook, &trades](const Command& command)
+        { orderbook.ProcessBatch(std::span<const Command>{ &command, 1 }, trades); };
+
+    // Act
+    Apply(Command::PruneGoodForDay({ }, 2));
+    const auto sizeAfterFirstSlice = orderbook.Size();
+    const bool expiringAfterFirstSlice = orderbook.IsExpiringGoodForDay();
+
+    Apply(Command::Add(Order{ OrderType::GoodForDay, 10, Side::Buy, 100, 1 }));
+    Apply(Command::Modify(OrderModify{ 8, Side::Sell, 108, 3 }));
+    Apply(Command::PruneGoodForDay({ }, 2));
+    Apply(Command::PruneGoodForDay({ }, 2));
+    const auto sizeAfterPrune = orderbook.Size();
+    const bool expiringAfterPrune = orderbook.IsExpiringGoodForDay();
+
+    Apply(Command::ExpireGoodTillDate(1500));
+    const auto nextExpiryAfterExpire = orderbook.NextExpiry();
+
+    Apply(Command::Add(Order{ OrderType::GoodTillCancel, 11, Side::Buy, 108, 3 }));
+    orderbook.CancelGoodForDayOrders();
+
+    // Assert
+    ASSERT_EQ(sizeAfterFirstSlice, 6u);
+    ASSERT_TRUE(expiringAfterFirstSlice);
+    ASSERT_EQ(sizeAfterPrune, 4u); // 6, 7, 8 and the later Good‑For‑Day order 10
+    ASSERT_FALSE(expiringAfterPrune);
+    ASSERT_EQ(nextExpiryAfterExpire, 2000u); // The modified order kept its expiry
+    ASSERT_EQ(trades.size(), 1u);
+    ASSERT_EQ(trades.front().GetAskTrade().orderId_, 8u);
+    ASSERT_EQ(orderbook.NextExpiry(), Constants::NoExpiry);
+    ASSERT_EQ(orderbook.Size(), 1u);
+    ASSERT_EQ(orderbook.GetOrderInfos().GetBids().front().price_, 99);
+}
+
+/**
+ * @brief A snapshot or image taken between the slices of a Good‑For‑Day
+ *        expiry continues it once restored, and both kinds of expiry take
+ *        orders in arrival order rather than price-time order.
+ */
+TEST(OrderbookExpiryTests, SnapshotsKeepExpiryOrderAndSlicesInProgress)
+{
+    // Arrange
+    using Book = BasicOrderbook<SingleWriterTraits<PooledOrderbookTraits>>;
+    const std::string imagePath = (std::filesystem::temp_directory_path() / ("orderbook_expiry_" + std::to_string(::getpid()))).string();
+    Book original, fromSnapshot, fromImage;
+    Trades trades;
+
+    const auto Apply = [&trades](Book& book, const Command& command)
+        { book.ProcessBatch(std::span<const Command>{ &command, 1 }, trades); };
+    const auto Ids = [](const Book& book)
+        {
+            std::vector<OrderId> ids;
+            book.ForEachOrder([&ids](const Order& order) { ids.push_back(order.GetOrderId()); });
+            return ids;
+        };
+
+    // Arrival order differs from price-time order on both sides
+    for (const auto& [orderId, price] : { std::pair<OrderId, Price>{ 1, 100 }, { 2, 101 }, { 3, 99 }, { 4, 102 } })
+        Apply(original, Command::Add(Order{ OrderType::GoodForDay, orderId, Side::Buy, price, 1 }));
+    Apply(original, Command::PruneGoodForDay({ }, 2)); // Seals 1-4, expires 1 and 2
+    Apply(original, Command::Add(Order{ OrderType::GoodForDay, 5, Side::Buy, 103, 1 }));
+    Apply(original, Command::Add(Order{ OrderType::GoodTillDate, 6, Side::Sell, 110, 1, 1000 }));
+    Apply(original, Command::Add(Order{ OrderType::GoodTillDate, 7, Side::Sell, 109, 1, 1000 }));
+
+    // Act
+    SnapshotImage::Capture(original, 0).Restore(fromSnapshot);
+    original.WriteImage(imagePath);
+    fromImage.AdoptImage(imagePath);
+
+    std::vector<std::vector<OrderId>> expected, snapshotIds, imageIds;
+    for (const Command& command : { Command::PruneGoodForDay({ }, 1), Command::ExpireGoodTillDate(1000, { }, 1), Command::PruneGoodForDay({ }, 1) })
+    {
+        Apply(original, command);
+        Apply(fromSnapshot, command);
+        Apply(fromImage, command);
+        expected.push_back(Ids(original));
+        snapshotIds.push_back(Ids(fromSnapshot));
+        imageIds.push_back(Ids(fromImage));
+    }
+
+    // Assert
+    ASSERT_EQ(expected, (std::vector<std::vector<OrderId>>{ { 5, 4, 7, 6 }, { 5, 4, 7 }, { 5, 7 } }));
+    ASSERT_EQ(snapshotIds, expected);
+    ASSERT_EQ(imageIds, expected);
+    ASSERT_FALSE(fromSnapshot.IsExpiringGoodForDay());
+    ASSERT_THROW(fromSnapshot.RestoreExpiryPosition(7, true), std::logic_error);
+
+    std::filesystem::remove(imagePath);
+}
+
+/**
+ * @brief Instrumented books count events and time calls; snapshots work from another thread.
+ */
+TEST(InstrumentationTests, RecordsCountersAndTimings)
+{
+    // Arrange
+    BasicOrderbook<InstrumentedTraits<PooledOrderbookTraits>> orderbook;
+    static_assert(sizeof(Orderbook) < sizeof(orderbook), "NullInstrumentation takes no space");
+
+    // Act
+    for (OrderId orderId = 1; orderId <= 3; ++orderId)
+        orderbook.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Sell, static_cast<Price>(100 + orderId), 5 });
+    orderbook.AddOrder(Order{ OrderType::GoodTillCancel, 4, Side::Buy, 102, 11 });
+    orderbook.CancelOrder(3);
+    orderbook.ModifyOrder(OrderModify{ 4, Side::Buy, 100, 1 });
+
+    OrderbookMetrics metrics;
+    std::thread monitor{ [&] { metrics = orderbook.GetInstrumentation().Snapshot(); } };
+    monitor.join();
+
+    // Assert
+    ASSERT_EQ(metrics.Counter(OrderbookCounter::OrdersAdded), 5u);
+    ASSERT_EQ(metrics.Counter(OrderbookCounter::Trades), 2u);
+    ASSERT_EQ(metrics.Counter(OrderbookCounter::OrdersCancelled), 2u);
+    ASSERT_EQ(metrics.Counter(OrderbookCounter::LevelsCrossed), 2u);
+    ASSERT_EQ(metrics.Distribution(OrderbookDistribution::LevelsCrossed).Count(), 1u);
+    ASSERT_EQ(metrics.Distribution(OrderbookDistribution::LevelsCrossed).Max(), 2u);
+    ASSERT_EQ(metrics.Timer(OrderbookTimer::AddOrder).Count(), 4u);
+    ASSERT_EQ(metrics.Timer(OrderbookTimer::CancelOrder).Count(), 1u);
+    ASSERT_EQ(metrics.Timer(OrderbookTimer::ModifyOrder).Count(), 1u);
+    ASSERT_EQ(metrics.Timer(OrderbookTimer::LockWait).Count(), 6u);
+
+    std::ostringstream dump;
+    dump << metrics;
+    ASSERT_NE(dump.str().find("AddOrder: count 4"), std::string::npos);
+}
+
+/**
+ * @brief One thread recording into more books than its cache holds, as an
+ *        engine shard does, while another thread snapshots them: every book
+ *        counts exactly its own operations.
+ */
+TEST(InstrumentationTests, OneThreadRecordsIntoManyBooks)
+{
+    // Arrange
+    using Book = BasicOrderbook<InstrumentedTraits<PooledOrderbookTraits>>;
+    constexpr std::size_t BookCount = 70;
+    constexpr OrderId OrdersPerBook = 20;
+    std::vector<std::unique_ptr<Book>> books;
+    for (std::size_t book = 0; book < BookCount; ++book)
+        books.push_back(std::make_unique<Book>(16));
+    std::atomic<bool> done{ false };
+    std::thread monitor{ [&]
+        {
+            while (!done.load())
+                for (const auto& book : books)
+                    (void)book->GetInstrumentation().Snapshot();
+        } };
+
+    // Act
+    for (OrderId orderId = 1; orderId <= OrdersPerBook; ++orderId)
+        for (const auto& book : books)
+            book->AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, 100, 1 });
+    done.store(true);
+    monitor.join();
+
+    // Assert
+    for (const auto& book : books)
+    {
+        const auto metrics = book->GetInstrumentation().Snapshot();
+        ASSERT_EQ(metrics.Counter(OrderbookCounter::OrdersAdded), OrdersPerBook);
+        ASSERT_EQ(metrics.Timer(OrderbookTimer::AddOrder).Count(), OrdersPerBook);
+    }
+}
+
+/**
+ * @brief Commands decoded straight from a wire buffer drive the book; trades and updates round-trip.
+ */
+TEST(WireFormatTests, DecodeIntoBookAndRoundTripOutputs)
+{
+    // Arrange
+    const Command sent[] = {
+        Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Sell, -5, 10 }, 7),
+        Command::Add(Order{ OrderType::FillAndKill, 2, Side::Buy, -5, 4 }, 7),
+        Command::Modify(OrderModify{ 1, Side::Sell, -5, 3 }, 7),
+    };
+    std::vector<unsigned char> buffer(std::size(sent) * WireCommand::Size + 1);
+    for (std::size_t index = 0; index < std::size(sent); ++index)
+        WireCommand::Encode(sent[index], buffer.data() + index * WireCommand::Size);
+
+    // Act
+    std::array<Command, 8> commands;
+    const auto count = WireCommand::DecodeBatch(buffer, commands);
+    Orderbook orderbook;
+    Trades trades;
+    orderbook.ProcessBatch(std::span<const Command>{ commands.data(), count }, trades);
+
+    // Assert
+    ASSERT_EQ(count, std::size(sent));
+    ASSERT_EQ(commands[0].instrumentId_, 7u);
+    ASSERT_EQ(commands[0].price_, -5);
+    ASSERT_EQ(trades.size(), 1u);
+    ASSERT_EQ(orderbook.GetOrderInfos().GetAsks().front().quantity_, 3u);
+
+    buffer[0] = 0xFF;
+    Command rejected;
+    ASSERT_FALSE(WireCommand::TryDecode(buffer, rejected));
+    ASSERT_FALSE(WireCommand::TryDecode(std::span<const unsigned char>{ buffer.data(), WireCommand::Size - 1 }, rejected));
+
+    std::array<unsigned char, WireTrade::Size> tradeBytes;
+    WireTrade::Encode(trades.front(), 7, tradeBytes.data());
+    InstrumentId instrumentId{ };
+    const Trade trade = WireTrade::Decode(tradeBytes.data(), instrumentId);
+    ASSERT_EQ(instrumentId, 7u);
+    ASSERT_EQ(trade.GetBidTrade().orderId_, 2u);
+    ASSERT_EQ(trade.GetAskTrade().price_, -5);
+    ASSERT_EQ(trade.GetAskTrade().quantity_, 4u);
+
+    std::array<unsigned char, WireLevelUpdate::Size> updateBytes;
+    WireLevelUpdate::Encode(LevelUpdate{ 9, Side::Sell, -5, 3, 1 }, 7, updateBytes.data());
+    const LevelUpdate update = WireLevelUpdate::Decode(updateBytes.data(), instrumentId);
+    ASSERT_EQ(update.sequence_, 9u);
+    ASSERT_EQ(update.side_, Side::Sell);
+    ASSERT_EQ(update.price_, -5);
+    ASSERT_EQ(update.orderCount_, 1u);
+}
+
+/**
+ * @brief Replay text parses like the test scripts, and the binary variant round-trips it.
+ */
+TEST(ReplayReaderTests, TextAndBinaryAgree)
+{
+    // Arrange
+    const std::string_view text{ "T 42\r\nA B GoodTillCancel 100 10 1\n\nM 1 S 101 7\nC 1\nR 0 0 0\n" };
+    TextReplayReader reader{ text };
+    std::string binary{ ReplayRecord::Magic };
+
+    // Act
+    std::vector<ReplayAction> actions;
+    ReplayAction action;
+    while (reader.Next(action))
+    {
+        actions.push_back(action);
+        const auto bytes = ReplayRecord::Encode(action);
+        binary.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    // Assert
+    ASSERT_EQ(actions.size(), 3u);
+    ASSERT_EQ(actions[0].timestamp_, 42u);
+    ASSERT_EQ(actions[0].command_.type_, CommandType::Add);
+    ASSERT_EQ(actions[0].command_.orderType_, OrderType::GoodTillCancel);
+    ASSERT_EQ(actions[0].command_.quantity_, 10u);
+    ASSERT_EQ(actions[1].command_.type_, CommandType::Modify);
+    ASSERT_EQ(actions[1].command_.side_, Side::Sell);
+    ASSERT_EQ(actions[1].command_.price_, 101);
+    ASSERT_EQ(actions[2].command_.type_, CommandType::Cancel);
+
+    BinaryReplayReader binaryReader{ binary };
+    for (const auto& expected : actions)
+    {
+        ASSERT_TRUE(binaryReader.Next(action));
+        ASSERT_EQ(action.timestamp_, expected.timestamp_);
+        ASSERT_EQ(action.command_.type_, expected.command_.type_);
+        ASSERT_EQ(action.command_.price_, expected.command_.price_);
+        ASSERT_EQ(action.command_.orderId_, expected.command_.orderId_);
+    }
+    ASSERT_FALSE(binaryReader.Next(action));
+
+    TextReplayReader bad{ "A B Sometimes 100 10 1\n" };
+    ASSERT_THROW(bad.Next(action), std::runtime_error);
+
+    // A record whose command type is out of range is rejected by its index
+    std::string corrupt = binary;
+    corrupt[ReplayRecord::Magic.size() + ReplayRecord::Size + 8] = static_cast<char>(0x7F);
+    BinaryReplayReader corruptReader{ corrupt };
+    ASSERT_TRUE(corruptReader.Next(action));
+    try
+    {
+        corruptReader.Next(action);
+        FAIL() << "invalid record accepted";
+    }
+    catch (const std::runtime_error& error)
+    {
+        ASSERT_NE(std::string{ error.what() }.find("record 1"), std::string::npos);
+    }
+}
+
+/**
+ * @brief The flat order index agrees with std::unordered_map under random
+ *        inserts and erasures (backward-shift deletion keeps every id reachable).
+ */
+TEST(FlatOrderIndexTests, AgreesWithUnorderedMap)
+{
+    // Arrange
+    FlatOrderIndex<std::uint32_t> index{ 8 };
+    std::unordered_map<OrderId, std::uint32_t> reference;
+    std::mt19937_64 random{ 17 };
+
+    // Act
+    for (std::uint32_t step = 0; step < 200'000; ++step)
+    {
+        // Dense ids, ids with a high-bit prefix, and the reserved largest id
+        const std::uint64_t draw = random() % 4096;
+        const OrderId orderId = draw == 0 ? std::numeric_limits<OrderId>::max()
+            : (random() % 2 == 0 ? draw : (draw << 40) | 7);
+
+        if (random() % 3 != 0 && !reference.contains(orderId))
+        {
+            index.Insert(orderId, step);
+            reference.emplace(orderId, step);
+        }
+        else
+        {
+            std::uint32_t entry = 0;
+            ASSERT_EQ(index.Extract(orderId, entry), reference.contains(orderId));
+            if (reference.contains(orderId))
+            {
+                ASSERT_EQ(entry, reference.at(orderId));
+                reference.erase(orderId);
+            }
+        }
+    }
+
+    // Assert
+    ASSERT_EQ(index.Size(), reference.size());
+    for (const auto& [orderId, entry] : reference)
+    {
+        ASSERT_NE(index.Find(orderId), nullptr);
+        ASSERT_EQ(*index.Find(orderId), entry);
+    }
+
+    std::size_t visited = 0;
+    index.ForEach([&](OrderId orderId, std::uint32_t entry) { ASSERT_EQ(reference.at(orderId), entry); ++visited; });
+    ASSERT_EQ(visited, reference.size());
+}
+
+/**
+ * @brief A book rebuilt from a snapshot plus the journal tail matches the
+ *        original, partial fills and queue priority included, and a torn
+ *        final record is ignored.
+ */
+TEST(JournalTests, RecoversFromSnapshotAndJournalTail)
+{
+    // Arrange
+    using Book = BasicOrderbook<SingleWriterTraits<LadderOrderbookTraits>>;
+    const auto directory = std::filesystem::temp_directory_path() / ("orderbook_journal_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    const std::string journalPath = (directory / "book.journal").string();
+    const std::string snapshotPath = (directory / "book.snapshot").string();
+    std::filesystem::remove(snapshotPath);
+
+    const std::vector<Command> before{
+        Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 }),
+        Command::Add(Order{ OrderType::GoodForDay, 2, Side::Buy, 100, 5 }),
+        Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 102, 8 }),
+        Command::Add(Order{ OrderType::FillAndKill, 4, Side::Sell, 100, 4 }),
+    };
+    const std::vector<Command> after{
+        Command::Add(Order{ OrderType::GoodTillCancel, 5, Side::Buy, 101, 3 }),
+        Command::Modify(OrderModify{ 3, Side::Sell, 102, 6 }),
+        Command::PruneGoodForDay(),
+        Command::Add(Order{ OrderType::GoodTillCancel, 6, Side::Sell, 100, 7 }),
+    };
+
+    // Act
+    Book original;
+    {
+        JournalWriter journal{ journalPath };
+        journal.Append(before);
+        original.ProcessBatch(before, [](const Trade&) { });
+        journal.SubmitSnapshot(SnapshotImage::Capture(original, journal.LastSequence()), snapshotPath);
+
+        journal.Append(after);
+        original.ProcessBatch(after, [](const Trade&) { });
+    }
+
+    {
+        // A crash in the middle of writing one more record
+        std::ofstream torn{ journalPath, std::ios::binary | std::ios::in | std::ios::out };
+        torn.seekp(static_cast<std::streamoff>(JournalRecord::HeaderSize + (before.size() + after.size()) * JournalRecord::Size));
+        torn.write("\x09\0\0\0\0\0\0\0\x01", 9);
+    }
+
+    Book recovered;
+    const JournalPosition position = RecoverOrderbook(recovered, snapshotPath, journalPath);
+
+    // Assert
+    ASSERT_EQ(SnapshotImage::Load(snapshotPath).Sequence(), before.size());
+    ASSERT_EQ(position.nextSequence_, before.size() + after.size() + 1);
+    ASSERT_EQ(position.offset_, JournalRecord::HeaderSize + (before.size() + after.size()) * JournalRecord::Size);
+
+    std::vector<std::tuple<OrderId, Quantity, Quantity>> expected, actual;
+    original.ForEachOrder([&expected](const Order& order)
+        { expected.emplace_back(order.GetOrderId(), order.GetInitialQuantity(), order.GetRemainingQuantity()); });
+    recovered.ForEachOrder([&actual](const Order& order)
+        { actual.emplace_back(order.GetOrderId(), order.GetInitialQuantity(), order.GetRemainingQuantity()); });
+    ASSERT_EQ(actual, expected);
+    ASSERT_EQ(expected.size(), 2u);
+
+    const auto infos = recovered.GetOrderInfos();
+    ASSERT_EQ(infos.GetBids().size(), 1u);
+    ASSERT_EQ(infos.GetBids()[0].quantity_, 2u);
+    ASSERT_EQ(infos.GetAsks().size(), 1u);
+    ASSERT_EQ(infos.GetAsks()[0].quantity_, 6u);
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * @brief Account limits and self-trade prevention modes are journaled and
+ *        snapshotted: recovery and adopted images check orders against the
+ *        same limits, and keep the positions, that the original book had.
+ */
+TEST(JournalTests, ReplaysAccountLimits)
+{
+    // Arrange
+    const auto directory = std::filesystem::temp_directory_path() / ("orderbook_limits_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    const std::string journalPath = (directory / "book.journal").string();
+    const std::string snapshotPath = (directory / "book.snapshot").string();
+    const std::string imagePath = (directory / "book.obimage").string();
+    constexpr auto Unlimited = std::numeric_limits<std::int64_t>::max();
+
+    const std::vector<Command> before{
+        Command::SetAccountLimits(7, AccountLimits{ 5, Unlimited, SelfTradePrevention::CancelAggressor }),
+        Command::SetAccountLimits(8, AccountLimits{ 4, Unlimited, SelfTradePrevention::DecrementBoth }),
+        Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 3, Constants::NoExpiry, 7 }),
+        Command::Add(Order{ OrderType::GoodTillCancel, 10, Side::Sell, 98, 2 }),
+        Command::Add(Order{ OrderType::GoodTillCancel, 11, Side::Buy, 98, 2, Constants::NoExpiry, 8 }), // Position +2
+    };
+    const std::vector<Command> after{
+        Command::SetAccountLimits(8, AccountLimits{ 3, Unlimited, SelfTradePrevention::DecrementBoth }),
+        Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 2, Constants::NoExpiry, 7 }),  // Self-trade: cancelled
+        Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 101, 3, Constants::NoExpiry, 7 }), // Past 5: rejected
+        Command::Add(Order{ OrderType::GoodTillCancel, 4, Side::Buy, 97, 2, Constants::NoExpiry, 8 }),   // Past 3: rejected
+    };
+
+    // Act
+    PooledOrderbook original;
+    {
+        JournalWriter journal{ journalPath };
+        journal.Append(before);
+        original.ProcessBatch(before, [](const Trade&) { });
+        journal.SubmitSnapshot(SnapshotImage::Capture(original, journal.LastSequence()), snapshotPath);
+
+        journal.Append(after);
+        original.ProcessBatch(after, [](const Trade&) { });
+    }
+    original.WriteImage(imagePath);
+
+    PooledOrderbook recovered, adopted;
+    RecoverOrderbook(recovered, snapshotPath, journalPath);
+    adopted.AdoptImage(imagePath);
+
+    const Command tooLarge = Command::Add(Order{ OrderType::GoodTillCancel, 5, Side::Sell, 105, 3, Constants::NoExpiry, 7 });
+    recovered.ProcessBatch(std::span<const Command>{ &tooLarge, 1 }, [](const Trade&) { });
+    adopted.ProcessBatch(std::span<const Command>{ &tooLarge, 1 }, [](const Trade&) { });
+
+    // Assert
+    std::vector<OrderId> expected, recoveredIds, adoptedIds;
+    original.ForEachOrder([&expected](const Order& order) { expected.push_back(order.GetOrderId()); });
+    recovered.ForEachOrder([&recoveredIds](const Order& order) { recoveredIds.push_back(order.GetOrderId()); });
+    adopted.ForEachOrder([&adoptedIds](const Order& order) { adoptedIds.push_back(order.GetOrderId()); });
+    ASSERT_EQ(expected, std::vector<OrderId>{ 1 });
+    ASSERT_EQ(recoveredIds, expected);
+    ASSERT_EQ(adoptedIds, expected);
+
+    ASSERT_EQ(original.GetAccountExposure(8).position_, 2);
+    for (const AccountId account : { AccountId{ 7 }, AccountId{ 8 } })
+    {
+        ASSERT_EQ(recovered.GetAccountExposure(account), original.GetAccountExposure(account));
+        ASSERT_EQ(adopted.GetAccountExposure(account), original.GetAccountExposure(account));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * @brief Resuming after a torn record cuts the journal there, so records of
+ *        the old tail never come back after a second crash, even when one
+ *        happens to continue the new sequence.
+ */
+TEST(JournalTests, ResumingDiscardsTheOldTail)
+{
+    // Arrange
+    const auto directory = std::filesystem::temp_directory_path() / ("orderbook_resume_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    const std::string journalPath = (directory / "book.journal").string();
+    const std::string noSnapshot = (directory / "none.snapshot").string();
+    constexpr std::size_t Records = 8;
+    constexpr std::size_t Torn = 3;
+
+    std::vector<Command> commands;
+    for (OrderId orderId = 1; orderId <= Records; ++orderId)
+        commands.push_back(Command::Add(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, 100, 1 }));
+
+    // Act
+    {
+        JournalWriter journal{ journalPath };
+        journal.Append(commands);
+    }
+    {
+        // Corrupt record Torn (0-based) so its checksum fails
+        std::fstream torn{ journalPath, std::ios::binary | std::ios::in | std::ios::out };
+        torn.seekp(static_cast<std::streamoff>(JournalRecord::HeaderSize + Torn * JournalRecord::Size + 20));
+        torn.put('\x7f');
+    }
+
+    Orderbook first;
+    const JournalPosition resumeAt = RecoverOrderbook(first, noSnapshot, journalPath);
+    {
+        // Two new records (sequences Torn + 1, Torn + 2), then a crash; old record Torn + 2 holds sequence Torn + 3
+        JournalWriter journal{ journalPath, resumeAt };
+        journal.Append(Command::Cancel(1));
+        journal.Append(Command::Cancel(2));
+    }
+
+    Orderbook second;
+    const JournalPosition position = RecoverOrderbook(second, noSnapshot, journalPath);
+
+    // Assert
+    ASSERT_EQ(resumeAt.nextSequence_, Torn + 1);
+    ASSERT_EQ(position.nextSequence_, Torn + 3);
+    ASSERT_EQ(position.offset_, JournalRecord::HeaderSize + (Torn + 2) * JournalRecord::Size);
+    ASSERT_EQ(second.Size(), Torn - 2);
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * @brief A book adopted from an image (into other level traits) holds the same
+ *        orders in the same priority and keeps matching like the original.
+ */
+TEST(BookImageTests, AdoptedBookMatchesLikeTheOriginal)
+{
+    // Arrange
+    const std::string path = (std::filesystem::temp_directory_path() / ("orderbook_image_" + std::to_string(::getpid()))).string();
+
+    PooledOrderbook original;
+    for (OrderId orderId = 1; orderId <= 40; ++orderId)
+    {
+        const Side side = orderId % 2 == 0 ? Side::Buy : Side::Sell;
+        const Price price = side == Side::Buy ? 100 - static_cast<Price>(orderId % 4) : 101 + static_cast<Price>(orderId % 3);
+        original.AddOrder(Order{ OrderType::GoodTillCancel, orderId, side, price, 10 });
+    }
+    for (OrderId orderId = 5; orderId <= 40; orderId += 7)
+        original.CancelOrder(orderId); // Leaves free slots behind
+    original.AddOrder(Order{ OrderType::FillAndKill, 100, Side::Sell, 100, 15 }); // Partially fills a bid
+
+    // Act
+    original.WriteImage(path, 42);
+    LadderOrderbook adopted;
+    const std::uint64_t sequence = adopted.AdoptImage(path);
+
+    // Assert
+    ASSERT_EQ(sequence, 42u);
+    ASSERT_EQ(adopted.Size(), original.Size());
+
+    std::vector<std::tuple<OrderId, Quantity, Quantity>> expected, actual;
+    original.ForEachOrder([&expected](const Order& order)
+        { expected.emplace_back(order.GetOrderId(), order.GetInitialQuantity(), order.GetRemainingQuantity()); });
+    adopted.ForEachOrder([&actual](const Order& order)
+        { actual.emplace_back(order.GetOrderId(), order.GetInitialQuantity(), order.GetRemainingQuantity()); });
+    ASSERT_EQ(actual, expected);
+
+    const auto depth = adopted.GetDepth();
+    ASSERT_EQ(depth.bidCount_, original.GetDepth().bidCount_);
+    ASSERT_EQ(depth.bids_[0].quantity_, original.GetDepth().bids_[0].quantity_);
+
+    const std::vector<Command> more{
+        Command::Add(Order{ OrderType::GoodTillCancel, 200, Side::Buy, 103, 25 }),
+        Command::Cancel(2),
+        Command::Add(Order{ OrderType::GoodTillCancel, 201, Side::Buy, 99, 5 }),
+        Command::Add(Order{ OrderType::Market, 202, Side::Sell, 0, 30 }),
+    };
+    Trades expectedTrades, actualTrades;
+    original.ProcessBatch(more, expectedTrades);
+    adopted.ProcessBatch(more, actualTrades);
+
+    ASSERT_EQ(actualTrades.size(), expectedTrades.size());
+    for (std::size_t index = 0; index < expectedTrades.size(); ++index)
+    {
+        ASSERT_EQ(actualTrades[index].GetBidTrade().orderId_, expectedTrades[index].GetBidTrade().orderId_);
+        ASSERT_EQ(actualTrades[index].GetAskTrade().orderId_, expectedTrades[index].GetAskTrade().orderId_);
+        ASSERT_EQ(actualTrades[index].GetAskTrade().quantity_, expectedTrades[index].GetAskTrade().quantity_);
+    }
+    ASSERT_EQ(adopted.Size(), original.Size());
+
+    ASSERT_THROW(adopted.AdoptImage(path), std::logic_error);
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief A corrupt image is rejected before the book changes: a flipped byte
+ *        fails the checksum, a link out of the slab fails validation even
+ *        with a matching checksum, and the book can still adopt a valid image.
+ */
+TEST(BookImageTests, CorruptImageLeavesTheBookEmpty)
+{
+    // Arrange
+    const std::string path = (std::filesystem::temp_directory_path() / ("orderbook_corrupt_" + std::to_string(::getpid()))).string();
+    PooledOrderbook original;
+    for (OrderId orderId = 1; orderId <= 6; ++orderId)
+        original.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, 100 - static_cast<Price>(orderId % 2), 10 });
+    original.WriteImage(path);
+
+    std::vector<unsigned char> valid(std::filesystem::file_size(path));
+    std::ifstream{ path, std::ios::binary }.read(reinterpret_cast<char*>(valid.data()), static_cast<std::streamsize>(valid.size()));
+    auto WriteCorrupt = [&path](std::vector<unsigned char> bytes)
+        {
+            std::ofstream{ path, std::ios::binary | std::ios::trunc }.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        };
+
+    // A flipped quantity byte in the first slot
+    auto flipped = valid;
+    flipped[BookImage::SlotsOffset + offsetof(OrderPool::Slot, order_) + 16] ^= 0x01;
+
+    // The first slot's next link out of the slab, checksummed again
+    auto unlinked = valid;
+    const OrderSlot outside = 1000;
+    std::memcpy(unlinked.data() + BookImage::SlotsOffset + offsetof(OrderPool::Slot, next_), &outside, sizeof(outside));
+    std::memset(unlinked.data() + offsetof(BookImageHeader, crc_), 0, sizeof(std::uint32_t));
+    const std::span<const unsigned char> parts[] = { unlinked };
+    const std::uint32_t crc = BookImage::Checksum(parts);
+    std::memcpy(unlinked.data() + offsetof(BookImageHeader, crc_), &crc, sizeof(crc));
+
+    // Act
+    PooledOrderbook adopted;
+    WriteCorrupt(flipped);
+    ASSERT_THROW(adopted.AdoptImage(path), std::runtime_error);
+    const std::size_t sizeAfterFlip = adopted.Size();
+    WriteCorrupt(unlinked);
+    ASSERT_THROW(adopted.AdoptImage(path), std::runtime_error);
+    const std::size_t sizeAfterUnlink = adopted.Size();
+    const auto bidsAfterUnlink = adopted.GetOrderInfos().GetBids();
+    WriteCorrupt(valid);
+    adopted.AdoptImage(path);
+
+    // Assert
+    ASSERT_EQ(sizeAfterFlip, 0u);
+    ASSERT_EQ(sizeAfterUnlink, 0u);
+    ASSERT_TRUE(bidsAfterUnlink.empty());
+    ASSERT_EQ(adopted.Size(), 6u);
+    ASSERT_EQ(adopted.GetOrderInfos().GetBids().size(), 2u);
+
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Images whose levels and FIFOs disagree are rejected even with a
+ *        matching checksum: a level ending at another level's tail, an order
+ *        at the wrong price inside a FIFO, orders linked in a cycle outside
+ *        every level, and a level quantity its orders do not add up to.
+ */
+TEST(BookImageTests, InconsistentLevelsAreRejected)
+{
+    // Arrange: 100 holds orders 2, 4 and 6, 99 holds 1, 3 and 5
+    const std::string path = (std::filesystem::temp_directory_path() / ("orderbook_levels_" + std::to_string(::getpid()))).string();
+    PooledOrderbook original;
+    for (OrderId orderId = 1; orderId <= 6; ++orderId)
+        original.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, 100 - static_cast<Price>(orderId % 2), 10 });
+    original.WriteImage(path);
+
+    std::vector<unsigned char> valid(std::filesystem::file_size(path));
+    std::ifstream{ path, std::ios::binary }.read(reinterpret_cast<char*>(valid.data()), static_cast<std::streamsize>(valid.size()));
+    BookImageHeader header;
+    std::memcpy(&header, valid.data(), sizeof(header));
+
+    // Applies edit to copies of the image's slots and levels and checksums the result again
+    using Edit = std::function<void(std::vector<OrderPool::Slot>&, std::vector<BookImageLevel>&)>;
+    auto Corrupt = [&](const Edit& edit)
+        {
+            auto bytes = valid;
+            unsigned char* slotBytes = bytes.data() + BookImage::SlotsOffset;
+            unsigned char* levelBytes = bytes.data() + BookImage::LevelsOffset(header.slotCount_);
+            const auto* firstSlot = reinterpret_cast<const OrderPool::Slot*>(slotBytes);
+            const auto* firstLevel = reinterpret_cast<const BookImageLevel*>(levelBytes);
+            std::vector<OrderPool::Slot> slots(firstSlot, firstSlot + header.slotCount_);
+            std::vector<BookImageLevel> levels(firstLevel, firstLevel + header.bidLevelCount_ + header.askLevelCount_);
+
+            edit(slots, levels);
+
+            std::memcpy(slotBytes, slots.data(), slots.size() * sizeof(OrderPool::Slot));
+            std::memcpy(levelBytes, levels.data(), levels.size() * sizeof(BookImageLevel));
+            std::memset(bytes.data() + offsetof(BookImageHeader, crc_), 0, sizeof(std::uint32_t));
+            const std::span<const unsigned char> parts[] = { bytes };
+            const std::uint32_t crc = BookImage::Checksum(parts);
+            std::memcpy(bytes.data() + offsetof(BookImageHeader, crc_), &crc, sizeof(crc));
+            std::ofstream{ path, std::ios::binary | std::ios::trunc }.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        };
+
+    const Edit edits[] = {
+        [](auto&, auto& levels) { std::swap(levels[0].tail_, levels[1].tail_); },
+        [](auto& slots, auto& levels)
+        {
+            auto& second = slots[slots[levels[0].head_].next_].order_;
+            second = Order{ OrderType::GoodTillCancel, second.GetOrderId(), Side::Buy, 99, 10 };
+        },
+        [](auto& slots, auto& levels)
+        {
+            // 99 keeps its head alone; its other two orders point only at each other
+            const OrderSlot head = levels[1].head_;
+            const OrderSlot second = slots[head].next_;
+            const OrderSlot third = slots[second].next_;
+            slots[head].next_ = OrderPool::InvalidSlot;
+            slots[second].prev_ = slots[second].next_ = third;
+            slots[third].prev_ = slots[third].next_ = second;
+            levels[1] = BookImageLevel{ 99, head, head, 10, 1, 0 };
+        },
+        [](auto&, auto& levels) { ++levels[0].quantity_; } };
+
+    // Act & Assert
+    PooledOrderbook adopted;
+    for (const auto& edit : edits)
+    {
+        Corrupt(edit);
+        ASSERT_THROW(adopted.AdoptImage(path), std::runtime_error);
+        ASSERT_EQ(adopted.Size(), 0u);
+    }
+
+    Corrupt([](auto&, auto&) { });
+    adopted.AdoptImage(path);
+    ASSERT_EQ(adopted.Size(), 6u);
+
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Commands from several producers are matched by the engine thread and
+ *        trades come back on the ring of the producer that owns the orders.
+ */
+TEST(MatchingEngineTests, MatchesCommandsFromProducerRings)
+{
+    // Arrange
+    MatchingEngine<> engine{ 2, -1, 1024 };
+    engine.Start();
+
+    // Act
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 })));
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 100, 4 })));
+    ASSERT_TRUE(engine.Submit(1, Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 105, 5 })));
+    ASSERT_TRUE(engine.Submit(1, Command::Add(Order{ OrderType::GoodForDay, 4, Side::Sell, 110, 5 })));
+    ASSERT_TRUE(engine.Submit(1, Command::PruneGoodForDay()));
+    engine.Stop();
+
+    // Assert
+    Trade trade;
+    ASSERT_TRUE(engine.PollTrade(0, trade));
+    ASSERT_EQ(trade.GetBidTrade().orderId_, 1u);
+    ASSERT_EQ(trade.GetAskTrade().orderId_, 2u);
+    ASSERT_EQ(trade.GetAskTrade().quantity_, 4u);
+    ASSERT_FALSE(engine.PollTrade(0, trade));
+    ASSERT_FALSE(engine.PollTrade(1, trade));
+    ASSERT_EQ(engine.GetBook().Size(), 2u);
+}
+
+/**
+ * @brief A passive fill reaches the producer of the resting order as well as
+ *        the aggressor's, and a full trade ring drops and counts trades
+ *        instead of stalling the matcher.
+ */
+TEST(MatchingEngineTests, RoutesTradesToBothOwners)
+{
+    // Arrange
+    MatchingEngine<> engine{ 3, -1, 4 };
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 2 })));
+    ASSERT_TRUE(engine.Submit(1, Command::Add(Order::Iceberg(2, Side::Sell, 101, 6, 1))));
+    ASSERT_TRUE(engine.Submit(2, Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 101, 8 })));
+
+    // Act
+    engine.Start();
+    engine.Stop();
+
+    // Assert
+    auto Poll = [&engine](std::size_t producer)
+        {
+            std::vector<OrderId> asks;
+            Trade trade;
+            while (engine.PollTrade(producer, trade))
+                asks.push_back(trade.GetAskTrade().orderId_);
+            return asks;
+        };
+    ASSERT_EQ(Poll(0), (std::vector<OrderId>{ 1 }));
+    ASSERT_EQ(Poll(1), (std::vector<OrderId>{ 2, 2, 2, 2 }));
+    ASSERT_EQ(Poll(2), (std::vector<OrderId>{ 1, 2, 2, 2 }));
+    ASSERT_EQ(engine.DroppedTrades(0), 0u);
+    ASSERT_EQ(engine.DroppedTrades(1), 2u);
+    ASSERT_EQ(engine.DroppedTrades(2), 3u);
+    ASSERT_EQ(engine.GetBook().Size(), 0u);
+}
+
+/**
+ * @brief A pinned matcher has its book and rings resident before Start returns,
+ *        and an unpinned one leaves memory alone.
+ */
+TEST(MatchingEngineTests, PinnedMatcherPlacesItsMemory)
+{
+    // Arrange
+    MatchingEngine<> pinned{ 1, 0, 1024, 1024 };
+    MatchingEngine<> unpinned{ 1, -1, 1024, 1024 };
+
+    // Act
+    pinned.Start();
+    unpinned.Start();
+    ASSERT_TRUE(pinned.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 })));
+    pinned.Stop();
+    unpinned.Stop();
+
+    // Assert
+    const auto& placement = pinned.GetMemoryPlacement();
+    ASSERT_GE(placement.bytes_, 2 * 1024 * sizeof(Command));
+    ASSERT_EQ(placement.residentBytes_, placement.bytes_);
+    ASSERT_EQ(unpinned.GetMemoryPlacement().bytes_, 0u);
+    ASSERT_EQ(pinned.GetBook().Size(), 1u);
+}
+
+/**
+ * @brief An engine restarted from its snapshot and journal ends with the same
+ *        book, wherever the matcher happened to take the snapshot.
+ */
+TEST(MatchingEngineTests, RecoversFromJournal)
+{
+    // Arrange
+    const auto directory = std::filesystem::temp_directory_path() / ("orderbook_engine_journal_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    const std::string journalPath = (directory / "engine.journal").string();
+    const std::string snapshotPath = (directory / "engine.snapshot").string();
+    std::filesystem::remove(snapshotPath);
+
+    OrderbookLevelInfos expected{ { }, { } };
+
+    // Act
+    {
+        JournalWriter journal{ journalPath };
+        MatchingEngine<> engine{ 1, -1, 1024 };
+        engine.AttachJournal(journal, snapshotPath);
+        engine.Start();
+
+        for (OrderId orderId = 1; orderId <= 200; ++orderId)
+        {
+            const Side side = orderId % 2 == 0 ? Side::Buy : Side::Sell;
+            const Price price = side == Side::Buy ? 100 - static_cast<Price>(orderId % 7) : 99 + static_cast<Price>(orderId % 5);
+            while (!engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, orderId, side, price, 10 })))
+                CpuRelax();
+            if (orderId == 100)
+                engine.RequestSnapshot();
+        }
+        engine.Stop();
+        expected = engine.GetBook().GetOrderInfos();
+    }
+
+    MatchingEngine<> restarted{ 1, -1, 1024 };
+    const JournalPosition position = restarted.Recover(snapshotPath, journalPath);
+
+    // Assert
+    ASSERT_EQ(position.nextSequence_, 201u);
+    const auto infos = restarted.GetBook().GetOrderInfos();
+    ASSERT_EQ(infos.GetBids().size(), expected.GetBids().size());
+    ASSERT_EQ(infos.GetAsks().size(), expected.GetAsks().size());
+    for (std::size_t level = 0; level < infos.GetBids().size(); ++level)
+    {
+        ASSERT_EQ(infos.GetBids()[level].price_, expected.GetBids()[level].price_);
+        ASSERT_EQ(infos.GetBids()[level].quantity_, expected.GetBids()[level].quantity_);
+    }
+    for (std::size_t level = 0; level < infos.GetAsks().size(); ++level)
+    {
+        ASSERT_EQ(infos.GetAsks()[level].price_, expected.GetAsks()[level].price_);
+        ASSERT_EQ(infos.GetAsks()[level].quantity_, expected.GetAsks()[level].quantity_);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * @brief Commands are routed to the book of their instrument across shards.
+ */
+TEST(OrderbookEngineTests, RoutesCommandsByInstrument)
+{
+    // Arrange
+    OrderbookEngine<> engine{ 1, { -1, -1 }, 1024, 1024 };
+    ASSERT_EQ(engine.AddInstrument(10), 0u);
+    ASSERT_EQ(engine.AddInstrument(20), 1u);
+    ASSERT_EQ(engine.AddInstrument(30), 0u);
+    engine.Start();
+
+    // Act
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 }, 10)));
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 10 }, 20)));
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 3 }, 20)));
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodForDay, 1, Side::Sell, 105, 5 }, 30)));
+    ASSERT_TRUE(engine.Submit(0, Command::PruneGoodForDay(30)));
+    ASSERT_FALSE(engine.Submit(0, Command::Cancel(1, 99)));
+    engine.Stop();
+
+    // Assert
+    InstrumentTrade trade;
+    ASSERT_TRUE(engine.PollTrade(0, trade));
+    ASSERT_EQ(trade.instrumentId_, 20u);
+    ASSERT_EQ(trade.trade_.GetBidTrade().quantity_, 3u);
+    ASSERT_FALSE(engine.PollTrade(0, trade));
+    ASSERT_EQ(engine.GetBook(10).Size(), 1u);
+    ASSERT_EQ(engine.GetBook(20).Size(), 1u);
+    ASSERT_EQ(engine.GetBook(30).Size(), 0u);
+}
+
+/**
+ * @brief Consecutive commands for one book are applied as one batch, which
+ *        publishes its top of book once, and due Good‑Till‑Date orders are
+ *        expired in whichever books of the shard hold them.
+ */
+TEST(OrderbookEngineTests, BatchesCommandsPerBookAndExpiresDueOrders)
+{
+    // Arrange
+    OrderbookEngine<> engine{ 1, { -1 }, 1024, 1024 };
+    for (InstrumentId instrumentId = 1; instrumentId <= 8; ++instrumentId)
+        engine.AddInstrument(instrumentId);
+
+    for (OrderId orderId = 1; orderId <= 4; ++orderId)
+        ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, orderId, Side::Buy, static_cast<Price>(100 + orderId), 1 }, 3)));
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillDate, 1, Side::Sell, 110, 1, 1000 }, 5)));
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 111, 1 }, 5)));
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 5, Side::Buy, 99, 1 }, 3)));
+
+    // Act
+    engine.Start();
+    engine.Stop();
+
+    // Assert
+    ASSERT_EQ(engine.GetBook(3).Size(), 5u);
+    ASSERT_EQ(engine.GetBook(3).GetPublishedTopOfBook().sequence_, 1u);
+    ASSERT_EQ(engine.GetBook(3).GetPublishedTopOfBook().top_.bidPrice_, 104);
+    ASSERT_EQ(engine.GetBook(5).Size(), 1u);
+    ASSERT_EQ(engine.GetBook(5).GetPublishedTopOfBook().top_.askPrice_, 111);
+}
+
+/**
+ * @brief A trade reaches the producers of both of its orders, each once.
+ */
+TEST(OrderbookEngineTests, RoutesTradesToBothOwners)
+{
+    // Arrange
+    OrderbookEngine<> engine{ 3, { -1 }, 1024, 1024 };
+    engine.AddInstrument(7);
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 100, 4 }, 7)));
+    ASSERT_TRUE(engine.Submit(1, Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 101, 4 }, 7)));
+    ASSERT_TRUE(engine.Submit(1, Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 101, 6 }, 7)));
+
+    // Act
+    engine.Start();
+    engine.Stop();
+
+    // Assert
+    auto Poll = [&engine](std::size_t producer)
+        {
+            std::vector<OrderId> asks;
+            InstrumentTrade trade;
+            while (engine.PollTrade(producer, trade))
+            {
+                EXPECT_EQ(trade.instrumentId_, 7u);
+                asks.push_back(trade.trade_.GetAskTrade().orderId_);
+            }
+            return asks;
+        };
+    ASSERT_EQ(Poll(0), (std::vector<OrderId>{ 1 }));
+    ASSERT_EQ(Poll(1), (std::vector<OrderId>{ 1, 2 }));
+    ASSERT_TRUE(Poll(2).empty());
+    ASSERT_EQ(engine.DroppedTrades(0), 0u);
+    ASSERT_EQ(engine.DroppedTrades(1), 0u);
+    ASSERT_EQ(engine.GetBook(7).Size(), 1u);
+}
+
+/**
+ * @brief A full trade ring costs its producer the trades that do not fit,
+ *        counted as dropped, and never holds up the shard's other books.
+ */
+TEST(OrderbookEngineTests, FullTradeRingDoesNotStallTheShard)
+{
+    // Arrange
+    OrderbookEngine<> engine{ 2, { -1 }, 4, 1024 };
+    engine.AddInstrument(7);
+    engine.AddInstrument(8);
+    ASSERT_TRUE(engine.Submit(0, Command::Add(Order::Iceberg(1, Side::Sell, 100, 6, 1), 7)));
+    ASSERT_TRUE(engine.Submit(1, Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Buy, 100, 6 }, 7)));
+    ASSERT_TRUE(engine.Submit(1, Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Buy, 90, 1 }, 8)));
+
+    // Act: nobody polls trades until the engine has stopped
+    engine.Start();
+    engine.Stop();
+
+    // Assert
+    std::size_t delivered[2]{ };
+    InstrumentTrade trade;
+    for (std::size_t producer = 0; producer < 2; ++producer)
+        while (engine.PollTrade(producer, trade))
+            ++delivered[producer];
+
+    ASSERT_EQ(delivered[0], 4u);
+    ASSERT_EQ(delivered[1], 4u);
+    ASSERT_EQ(engine.DroppedTrades(0), 2u);
+    ASSERT_EQ(engine.DroppedTrades(1), 2u);
+    ASSERT_EQ(engine.GetBook(7).Size(), 0u);
+    ASSERT_EQ(engine.GetBook(8).Size(), 1u);
+}
+
+/**
+ * @brief A cross is signalled only once it beats both venues' fees, and only on top-of-book changes.
+ */
+TEST(CrossVenueTests, SignalsCrossesNetOfFees)
+{
+    // Arrange
+    CrossVenueMonitor<> monitor{ 1, 1024 };
+    const auto venueA = monitor.AddVenue(7, 1);
+    const auto pair = monitor.AddPair(42);
+    const auto venueB = monitor.AddVenue(9, 2);
+    std::vector<CrossVenueSignal> signals;
+    auto sink = [&signals](const CrossVenueSignal& signal) { signals.push_back(signal); };
+
+    const Command bidOnA[] = { Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Buy, 100, 10 }) };
+    const Command askOnB[] = { Command::Add(Order{ OrderType::GoodTillCancel, 1, Side::Sell, 98, 4 }) };
+    const Command deeperAskOnB[] = { Command::Add(Order{ OrderType::GoodTillCancel, 2, Side::Sell, 99, 50 }) };
+    const Command betterAskOnB[] = { Command::Add(Order{ OrderType::GoodTillCancel, 3, Side::Sell, 96, 6 }) };
+
+    // Act & Assert
+    monitor.Apply(pair, venueA, bidOnA, 1000, sink);
+    monitor.Apply(pair, venueB, askOnB, 2000, sink);
+    ASSERT_TRUE(signals.empty()); // 100 - 1 - (98 + 2) < 1
+
+    monitor.Apply(pair, venueB, deeperAskOnB, 3000, sink);
+    ASSERT_TRUE(signals.empty());
+
+    monitor.Apply(pair, venueB, betterAskOnB, 4000, sink);
+    ASSERT_EQ(signals.size(), 1u);
+    ASSERT_EQ(signals[0].instrumentId_, 42u);
+    ASSERT_EQ(signals[0].buyVenue_, 9u);
+    ASSERT_EQ(signals[0].sellVenue_, 7u);
+    ASSERT_EQ(signals[0].buyPrice_, 96);
+    ASSERT_EQ(signals[0].sellPrice_, 100);
+    ASSERT_EQ(signals[0].quantity_, 6u);
+    ASSERT_EQ(signals[0].edge_, 1);
+    ASSERT_EQ(signals[0].timestamp_, 4000u);
+
+    const auto top = monitor.GetBook(pair, venueB).GetTopOfBook();
+    ASSERT_FALSE(top.HasBid());
+    ASSERT_EQ(top.askPrice_, 96);
+    ASSERT_EQ(top.askQuantity_, 6u);
+    ASSERT_EQ(top.askCount_, 1u);
+}
+
+/**
+ * @brief Triangles are built as pairs arrive, an update re-evaluates only its
+ *        pair's cycles, and the signalled size respects every leg's top quantity.
+ */
+TEST(TriangularArbitrageTests, SignalsProfitableCyclesOfTheChangedPair)
+{
+    // Arrange
+    constexpr CurrencyId EUR = 0, USD = 1, JPY = 2, GBP = 3;
+    TriangularDetector detector{ 0.0001 };
+    const auto eurusd = detector.AddPair(1, EUR, USD, 10'000);
+    const auto usdjpy = detector.AddPair(2, USD, JPY, 100);
+    ASSERT_EQ(detector.CycleCount(), 0u);
+    const auto eurjpy = detector.AddPair(3, EUR, JPY, 100);
+    ASSERT_EQ(detector.CycleCount(), 2u);
+    detector.AddPair(4, GBP, USD, 10'000);
+    detector.AddPair(5, EUR, GBP, 10'000);
+    detector.AddPair(6, GBP, JPY, 100);
+    ASSERT_EQ(detector.CycleCount(), 8u);
+    ASSERT_EQ(detector.CyclesOf(eurusd).size(), 4u);
+
+    std::vector<TriangularSignal> signals;
+    auto sink = [&signals](const TriangularSignal& signal) { signals.push_back(signal); };
+
+    // Act & Assert
+    detector.OnTopOfBook(eurusd, TopOfBook{ 11'000, 1000, 1, 11'001, 1000, 1 }, 1, sink);
+    detector.OnTopOfBook(usdjpy, TopOfBook{ 15'000, 500, 1, 15'001, 500, 1 }, 2, sink);
+    detector.OnTopOfBook(eurjpy, TopOfBook{ 16'500, 300, 1, 16'520, 300, 1 }, 3, sink);
+    ASSERT_TRUE(signals.empty());
+
+    // EURJPY offered at 164.50 against 1.1000 x 150.00 = 165.00
+    detector.OnTopOfBook(eurjpy, TopOfBook{ 16'400, 300, 1, 16'450, 300, 1 }, 4, sink);
+    ASSERT_EQ(signals.size(), 1u);
+    const auto& currencies = detector.GetCycle(signals[0].cycle_);
+    ASSERT_EQ(currencies, (std::array<CurrencyId, 3>{ EUR, USD, JPY }));
+    ASSERT_EQ(signals[0].currencies_, currencies);
+    ASSERT_NEAR(signals[0].return_, 1.1 * 150.0 / 164.5 - 1.0, 1e-9);
+    ASSERT_EQ(signals[0].quantity_, 299u); // 300 EUR offered = 49 350 JPY = 299.09 EUR at the start
+    ASSERT_EQ(signals[0].timestamp_, 4u);
+
+    // Each update of one of its legs re-reports the cross with the new top
+    detector.OnTopOfBook(usdjpy, TopOfBook{ 15'000, 100, 1, 15'001, 500, 1 }, 5, sink);
+    ASSERT_EQ(signals.size(), 2u);
+    ASSERT_EQ(signals[1].quantity_, 90u); // 100 USD bid = 90.9 EUR
+    ASSERT_EQ(signals[1].timestamp_, 5u);
+}
+
+namespace
+{
+    /**
+     * @brief Encodes commands as one WirePacket starting at sequence.
+     */
+    std::vector<unsigned char> EncodePacket(std::uint64_t sequence, const std::vector<Command>& commands)
+    {
+        std::vector<unsigned char> packet(WirePacket::HeaderSize + commands.size() * WireCommand::Size);
+        WirePacket::EncodeHeader(sequence, static_cast<std::uint32_t>(commands.size()), packet.data());
+        for (std::size_t index = 0; index < commands.size(); ++index)
+            WireCommand::Encode(commands[index], packet.data() + WirePacket::HeaderSize + index * WireCommand::Size);
+        return packet;
+    }
+}
+
+/**
+ * @brief Each message is applied once whichever line delivers it first, runs
+ *        are split per instrument, and holes neither line fills are gaps.
+ */
+TEST(FeedHandlerTests, ArbitratesLinesAndReportsGaps)
+{
+    // Arrange
+    MemoryPacketSource lineA, lineB;
+    FeedHandler<MemoryPacketSource> feed{ lineA, &lineB };
+    std::unordered_map<InstrumentId, Orderbook> books;
+    std::vector<FeedGap> gaps;
+    auto applyBatch = [&books](const FeedBatch& batch) { books[batch.instrumentId_].ProcessBatch(batch.commands_, [](const Trade&) { }); };
+    auto recordGap = [&gaps](const FeedGap& gap) { gaps.push_back(gap); };
+
+    const auto add = [](OrderId orderId, InstrumentId instrumentId, Side side, Price price)
+    {
+        return Command::Add(Order{ OrderType::GoodTillCancel, orderId, side, price, 10 }, instrumentId);
+    };
+
+    // Act: A loses 3-4, B loses 1-2 and delivers 3-5 late; both lose 8-9
+    lineA.Push(EncodePacket(1, { add(1, 1, Side::Buy, 100), add(2, 2, Side::Buy, 50) }));
+    lineA.Push(EncodePacket(5, { add(5, 1, Side::Buy, 98) }));
+    lineB.Push(EncodePacket(3, { add(3, 2, Side::Sell, 55), add(4, 2, Side::Sell, 56) }));
+    feed.Poll(applyBatch, recordGap);
+
+    lineB.Push(EncodePacket(5, { add(5, 1, Side::Buy, 98) }));
+    lineB.Push(EncodePacket(6, { add(6, 1, Side::Sell, 101), add(7, 1, Side::Sell, 102) }));
+    lineA.Push(EncodePacket(10, { Command::Cancel(6, 1) }));
+    lineA.Push({ 1, 2, 3 });
+    feed.Poll(applyBatch, recordGap);
+
+    // 10 waits for 8-9 until the hole's window runs out
+    const std::size_t heldWhileOpen = feed.HeldPackets();
+    const std::size_t gapsWhileOpen = gaps.size();
+    for (std::size_t poll = 0; poll < FeedHandler<MemoryPacketSource>::DefaultHoldPolls; ++poll)
+        feed.Poll(applyBatch, recordGap);
+
+    // Assert
+    ASSERT_EQ(heldWhileOpen, 1u);
+    ASSERT_EQ(gapsWhileOpen, 0u);
+    ASSERT_EQ(feed.HeldPackets(), 0u);
+    ASSERT_EQ(books[1].Size(), 3u);
+    ASSERT_EQ(books[2].Size(), 3u);
+    ASSERT_EQ(gaps.size(), 1u);
+    ASSERT_EQ(gaps[0].from_, 8u);
+    ASSERT_EQ(gaps[0].to_, 10u);
+    ASSERT_EQ(feed.NextSequence(), 11u);
+
+    const auto& stats = feed.GetStats();
+    ASSERT_EQ(stats.packets_, 6u);
+    ASSERT_EQ(stats.duplicates_, 1u);
+    ASSERT_EQ(stats.messages_, 8u);
+    ASSERT_EQ(stats.missedMessages_, 2u);
+    ASSERT_EQ(stats.malformed_, 1u);
+    ASSERT_EQ(stats.held_, 1u);
+}
+
+/**
+ * @brief A hole stays open across Polls, so the other line's copy arriving
+ *        later still fills it; a full reorder buffer gives up on the hole.
+ */
+TEST(FeedHandlerTests, FillsHolesFromTheLaggingLine)
+{
+    // Arrange
+    MemoryPacketSource lineA, lineB, single;
+    FeedHandler<MemoryPacketSource> feed{ lineA, &lineB };
+    FeedHandler<MemoryPacketSource> small{ single, nullptr, 64, 1 };
+    std::vector<OrderId> orderIds, smallOrderIds;
+    std::vector<FeedGap> gaps, smallGaps;
+    const auto record = [](std::vector<OrderId>& orderIds)
+        { return [&orderIds](const FeedBatch& batch) { for (const auto& command : batch.commands_) orderIds.push_back(command.orderId_); }; };
+    const auto recordGap = [](std::vector<FeedGap>& gaps) { return [&gaps](const FeedGap& gap) { gaps.push_back(gap); }; };
+
+    // Act: A loses 2; B lags A by two Polls
+    lineA.Push(EncodePacket(1, { Command::Cancel(1) }));
+    lineA.Push(EncodePacket(3, { Command::Cancel(3) }));
+    feed.Poll(record(orderIds), recordGap(gaps));
+    lineA.Push(EncodePacket(4, { Command::Cancel(4) }));
+    feed.Poll(record(orderIds), recordGap(gaps));
+    const auto appliedBeforeB = orderIds;
+
+    lineB.Push(EncodePacket(1, { Command::Cancel(1) }));
+    lineB.Push(EncodePacket(2, { Command::Cancel(2) }));
+    feed.Poll(record(orderIds), recordGap(gaps));
+
+    for (std::uint64_t sequence : { 1, 3, 4 })
+        single.Push(EncodePacket(sequence, { Command::Cancel(sequence) }));
+    small.Poll(record(smallOrderIds), recordGap(smallGaps));
+
+    // Assert
+    ASSERT_EQ(appliedBeforeB, (std::vector<OrderId>{ 1 }));
+    ASSERT_EQ(orderIds, (std::vector<OrderId>{ 1, 2, 3, 4 }));
+    ASSERT_TRUE(gaps.empty());
+    ASSERT_EQ(feed.NextSequence(), 5u);
+    ASSERT_EQ(feed.GetStats().held_, 2u);
+    ASSERT_EQ(feed.GetStats().duplicates_, 1u);
+
+    // 4 finds the one slot taken by 3, so the hole at 2 is skipped at once
+    ASSERT_EQ(smallOrderIds, (std::vector<OrderId>{ 1, 3, 4 }));
+    ASSERT_EQ(smallGaps.size(), 1u);
+    ASSERT_EQ(smallGaps[0].from_, 2u);
+    ASSERT_EQ(smallGaps[0].to_, 3u);
+}
+
+/**
+ * @brief Both lines' copies of a packet past a hole share one reorder slot,
+ *        so the second copy neither grows the buffer nor forces the hole shut.
+ */
+TEST(FeedHandlerTests, HoldsOneCopyOfEachPacketPastAHole)
+{
+    // Arrange
+    MemoryPacketSource lineA, lineB;
+    FeedHandler<MemoryPacketSource> feed{ lineA, &lineB, 64, 2 };
+    std::vector<OrderId> orderIds;
+    std::vector<FeedGap> gaps;
+    const auto record = [&orderIds](const FeedBatch& batch) { for (const auto& command : batch.commands_) orderIds.push_back(command.orderId_); };
+    const auto recordGap = [&gaps](const FeedGap& gap) { gaps.push_back(gap); };
+
+    // Act: both lines lose 2 at first and deliver 3-4; B then fills the hole
+    for (std::uint64_t sequence : { 1, 3, 4 })
+        lineA.Push(EncodePacket(sequence, { Command::Cancel(sequence) }));
+    feed.Poll(record, recordGap);
+
+    for (std::uint64_t sequence : { 3, 4 })
+        lineB.Push(EncodePacket(sequence, { Command::Cancel(sequence) }));
+    feed.Poll(record, recordGap);
+    const std::size_t heldAfterCopies = feed.HeldPackets();
+
+    lineB.Push(EncodePacket(2, { Command::Cancel(2) }));
+    feed.Poll(record, recordGap);
+
+    // Assert
+    ASSERT_EQ(heldAfterCopies, 2u);
+    ASSERT_EQ(orderIds, (std::vector<OrderId>{ 1, 2, 3, 4 }));
+    ASSERT_TRUE(gaps.empty());
+    ASSERT_EQ(feed.NextSequence(), 5u);
+    ASSERT_EQ(feed.GetStats().held_, 2u);
+    ASSERT_EQ(feed.GetStats().duplicates_, 2u);
+}
+
+/**
+ * @brief Datagrams sent to the receiver's port arrive in one recvmmsg batch and decode in order.
+ */
+TEST(FeedHandlerTests, ReceivesDatagramsOverUdp)
+{
+    // Arrange
+    MulticastReceiver receiver{ "127.0.0.1", 0 };
+    FeedHandler<MulticastReceiver> feed{ receiver };
+    std::vector<OrderId> orderIds;
+
+    const int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sender, 0);
+    sockaddr_in address{ };
+    address.sin_family = AF_INET;
+    address.sin_port = htons(receiver.Port());
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+    // Act
+    for (std::uint64_t sequence = 1; sequence <= 3; ++sequence)
+    {
+        const auto packet = EncodePacket(sequence, { Command::Cancel(sequence * 10) });
+        ASSERT_EQ(sendto(sender, packet.data(), packet.size(), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)),
+            static_cast<ssize_t>(packet.size()));
+    }
+    close(sender);
+
+    for (int attempt = 0; attempt < 1000 && orderIds.size() < 3; ++attempt)
+        feed.Poll([&orderIds](const FeedBatch& batch) { for (const auto& command : batch.commands_) orderIds.push_back(command.orderId_); },
+            [](const FeedGap&) { FAIL(); });
+
+    // Assert
+    ASSERT_EQ(orderIds, (std::vector<OrderId>{ 10, 20, 30 }));
+    ASSERT_EQ(feed.GetStats().gaps_, 0u);
+}
+
+namespace
+{
+    constexpr std::uint64_t StressSeed = 20'240'611;
+
+    /**
+     * @brief What one stress producer sent and the trades its calls returned.
+     */
+    struct StressLog
+    {
+        Trades trades_;
+        std::unordered_map<OrderId, Quantity> submitted_; // Quantity asked for under each id, adds plus modifies
+        std::unordered_set<OrderId> modified_;
+
+        void Record(const Command& command)
+        {
+            if (command.type_ == CommandType::Add || command.type_ == CommandType::Modify)
+                submitted_[command.orderId_] += command.quantity_;
+            if (command.type_ == CommandType::Modify)
+                modified_.insert(command.orderId_);
+        }
+    };
+
+    /**
+     * @return True if a view of the book shows its best bid at or above its best ask.
+     */
+    bool IsCrossed(const LevelInfos& bids, const LevelInfos& asks)
+    {
+        return !bids.empty() && !asks.empty() && bids.front().price_ >= asks.front().price_;
+    }
+
+    template <std::size_t DepthLevels>
+    bool IsCrossed(const DepthSnapshot<DepthLevels>& depth)
+    {
+        return depth.bidCount_ != 0 && depth.askCount_ != 0 && depth.bids_[0].price_ >= depth.asks_[0].price_;
+    }
+
+    bool IsCrossed(const TopOfBook& top)
+    {
+        return top.HasBid() && top.HasAsk() && top.bidPrice_ >= top.askPrice_;
+    }
+
+    /**
+     * @brief Checks a quiescent book against what the producers sent and got back:
+     *        level aggregates match the resting orders, the book is not crossed,
+     *        and every order's fills add up to the trades that name it.
+     */
+    template <typename Book>
+    void ExpectConsistentBook(const Book& book, const std::vector<StressLog>& logs)
+    {
+        std::vector<Order> resting;
+        book.ForEachOrder([&resting](const Order& order) { resting.push_back(order); });
+        ASSERT_EQ(book.Size(), resting.size());
+
+        // Level aggregates against the orders in the level FIFOs
+        std::map<Price, std::pair<Quantity, Quantity>, std::greater<>> bids;
+        std::map<Price, std::pair<Quantity, Quantity>> asks;
+        for (const auto& order : resting)
+        {
+            auto& level = order.GetSide() == Side::Buy ? bids[order.GetPrice()] : asks[order.GetPrice()];
+            level.first += order.GetRemainingQuantity();
+            ++level.second;
+        }
+
+        const auto infos = book.GetOrderInfos();
+        ASSERT_EQ(infos.GetBids().size(), bids.size());
+        ASSERT_EQ(infos.GetAsks().size(), asks.size());
+        auto bid = bids.begin();
+        for (const auto& info : infos.GetBids())
+        {
+            ASSERT_EQ(info.price_, bid->first);
+            ASSERT_EQ(info.quantity_, bid->second.first);
+            ++bid;
+        }
+        auto ask = asks.begin();
+        for (const auto& info : infos.GetAsks())
+        {
+            ASSERT_EQ(info.price_, ask->first);
+            ASSERT_EQ(info.quantity_, ask->second.first);
+            ++ask;
+        }
+
+        const auto top = book.GetTopOfBook();
+        ASSERT_EQ(top.bidCount_, bids.empty() ? 0u : bids.begin()->second.second);
+        ASSERT_EQ(top.askCount_, asks.empty() ? 0u : asks.begin()->second.second);
+        ASSERT_EQ(book.GetPublishedTopOfBook().top_, top);
+        ASSERT_FALSE(IsCrossed(infos.GetBids(), infos.GetAsks()));
+        ASSERT_FALSE(IsCrossed(book.GetDepth()));
+
+        // Trades conserve quantity: both sides agree, and no order trades more than it asked for
+        std::unordered_map<OrderId, std::uint64_t> traded;
+        std::unordered_map<OrderId, std::uint64_t> submitted;
+        for (const auto& log : logs)
+        {
+            for (const auto& trade : log.trades_)
+            {
+                ASSERT_EQ(trade.GetBidTrade().quantity_, trade.GetAskTrade().quantity_);
+                ASSERT_GE(trade.GetBidTrade().price_, trade.GetAskTrade().price_);
+                traded[trade.GetBidTrade().orderId_] += trade.GetBidTrade().quantity_;
+                traded[trade.GetAskTrade().orderId_] += trade.GetAskTrade().quantity_;
+            }
+            for (const auto& [orderId, quantity] : log.submitted_)
+                submitted[orderId] += quantity;
+        }
+        for (const auto& [orderId, quantity] : traded)
+            ASSERT_LE(quantity, submitted[orderId]) << "order " << orderId;
+
+        // A resting order that was never modified has filled exactly what its trades say
+        for (const auto& order : resting)
+        {
+            if (std::any_of(logs.begin(), logs.end(), [&order](const StressLog& log) { return log.modified_.contains(order.GetOrderId()); }))
+                continue;
+
+            ASSERT_EQ(order.GetInitialQuantity(), submitted[order.GetOrderId()]) << "order " << order.GetOrderId();
+            ASSERT_EQ(order.GetFilledQuantity(), traded[order.GetOrderId()]) << "order " << order.GetOrderId();
+        }
+    }
+
+    /**
+     * @brief Drives one locked book from producers threads calling AddOrder,
+     *        CancelOrder and ModifyOrder, while a reader polls every view.
+     */
+    template <typename Book>
+    void StressBook(std::size_t producers, std::size_t commandsPerProducer)
+    {
+        Book book;
+        std::vector<StressLog> logs(producers);
+        std::atomic<bool> done{ false };
+        std::atomic<int> crossedViews{ 0 };
+
+        std::thread reader{ [&]
+            {
+                while (!done.load(std::memory_order_acquire))
+                {
+                    const auto infos = book.GetOrderInfos();
+                    if (IsCrossed(infos.GetBids(), infos.GetAsks()) || IsCrossed(book.GetDepth())
+                        || IsCrossed(book.GetPublishedTopOfBook().top_) || IsCrossed(book.GetTopOfBook()))
+                        crossedViews.fetch_add(1, std::memory_order_relaxed);
+                }
+            } };
+
+        std::vector<std::thread> threads;
+        for (std::size_t producer = 0; producer < producers; ++producer)
+            threads.emplace_back([&, producer]
+                {
+                    RandomOrderFlow flow{ StressSeed + producer, (OrderId{ producer } + 1) << 40 };
+                    auto& log = logs[producer];
+                    for (std::size_t index = 0; index < commandsPerProducer; ++index)
+                    {
+                        const Command command = flow.Next();
+                        log.Record(command);
+                        if (command.type_ == CommandType::Add)
+                            book.AddOrder(command.ToOrder(), log.trades_);
+                        else if (command.type_ == CommandType::Cancel)
+                            book.CancelOrder(command.orderId_);
+                        else
+                            book.ModifyOrder(command.ToOrderModify(), log.trades_);
+                    }
+                });
+
+        for (auto& thread : threads)
+            thread.join();
+        done.store(true, std::memory_order_release);
+        reader.join();
+
+        ASSERT_EQ(crossedViews.load(), 0);
+        ExpectConsistentBook(book, logs);
+    }
+}
+
+/**
+ * @brief Producers racing on one locked book leave it consistent, whatever
+ *        the interleaving: aggregates, priority and trades all add up.
+ */
+TEST(OrderbookStressTests, ConcurrentProducersKeepTheBookConsistent)
+{
+    SCOPED_TRACE("seed " + std::to_string(StressSeed));
+
+    StressBook<Orderbook>(4, 20'000);
+    StressBook<PooledOrderbook>(4, 20'000);
+    StressBook<LadderOrderbook>(4, 20'000);
+}
+
+/**
+ * @brief The same flow through the single-writer engine's producer rings
+ *        leaves its book just as consistent, with every trade routed back
+ *        to the owners of both its orders.
+ */
+TEST(OrderbookStressTests, EngineProducersKeepTheBookConsistent)
+{
+    SCOPED_TRACE("seed " + std::to_string(StressSeed));
+    constexpr std::size_t Producers = 4;
+    constexpr std::size_t CommandsPerProducer = 20'000;
+
+    // Arrange
+    MatchingEngine<> engine{ Producers, -1 };
+    std::vector<StressLog> logs(Producers);
+    std::atomic<std::size_t> finished{ 0 };
+    std::atomic<bool> stopped{ false };
+    std::atomic<int> crossedViews{ 0 };
+    engine.Start();
+
+    // Act
+    std::vector<std::thread> threads;
+    for (std::size_t producer = 0; producer < Producers; ++producer)
+        threads.emplace_back([&, producer]
+            {
+                RandomOrderFlow flow{ StressSeed + producer, (OrderId{ producer } + 1) << 40 };
+                auto& log = logs[producer];
+                Trade trade;
+                auto drain = [&] { while (engine.PollTrade(producer, trade)) log.trades_.push_back(trade); };
+
+                for (std::size_t index = 0; index < CommandsPerProducer; ++index)
+                {
+                    const Command command = flow.Next();
+                    log.Record(command);
+                    while (!engine.Submit(producer, command))
+                        drain();
+                    drain();
+                }
+
+                // Passive fills keep arriving until the matcher stops
+                finished.fetch_add(1);
+                while (!stopped.load(std::memory_order_acquire))
+                    drain();
+            });
+
+    while (finished.load() < Producers)
+    {
+        // Only the lock-free views may be read while the matcher owns the book
+        if (IsCrossed(engine.GetBook().GetDepth()) || IsCrossed(engine.GetBook().GetPublishedTopOfBook().top_))
+            crossedViews.fetch_add(1, std::memory_order_relaxed);
+    }
+    engine.Stop();
+    stopped.store(true, std::memory_order_release);
+    for (auto& thread : threads)
+        thread.join();
+
+    Trade trade;
+    for (std::size_t producer = 0; producer < Producers; ++producer)
+        while (engine.PollTrade(producer, trade))
+            logs[producer].trades_.push_back(trade);
+
+    // Each producer gets the trades of its own orders; keep every trade once, from its bid's owner
+    const auto OwnerOf = [](OrderId orderId) { return static_cast<std::size_t>(orderId >> 40) - 1; };
+    std::vector<StressLog> owned(logs);
+    for (std::size_t producer = 0; producer < Producers; ++producer)
+    {
+        ASSERT_EQ(engine.DroppedTrades(producer), 0u);
+        for (const auto& trade : logs[producer].trades_)
+            ASSERT_TRUE(OwnerOf(trade.GetBidTrade().orderId_) == producer || OwnerOf(trade.GetAskTrade().orderId_) == producer);
+        std::erase_if(owned[producer].trades_, [&](const Trade& trade) { return OwnerOf(trade.GetBidTrade().orderId_) != producer; });
+    }
+
+    // Assert
+    ASSERT_EQ(crossedViews.load(), 0);
+    ExpectConsistentBook(engine.GetBook(), owned);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <mutex>
+#include <cstddef>
+
+#include "Instrumentation.h"
+#include "OrderStorage.h"
+#include "PriceLevels.h"
+
+/**
+ * @brief Compile-time configurations for BasicOrderbook.
+ *
+ * A traits type selects the policies a book is built from:
+ * - Storage: how resting orders and price-level FIFOs are held (see OrderStorage.h).
+ * - Levels: the price -> level container used for each side (see PriceLevels.h).
+ * - Mutex: the lock taken by every public method.
+ * - PruneThread: whether the book runs its own Good‑For‑Day / Good‑Till‑Date expiry thread.
+ * - ExpirySlice: orders an expiry cancels per lock acquisition (see CancelGoodForDayOrders).
+ * - DepthLevels: levels per side of the published depth snapshot (0 disables it).
+ * - LevelUpdateCapacity: size of the level-update ring (power of two, 0 disables it).
+ * - Instrumentation: timing/counter hooks (see Instrumentation.h); NullInstrumentation compiles away.
+ *
+ * Configurations derive from DefaultOrderbookTraits and override what differs.
+ */
+
+/**
+ * @brief Lock that does nothing, for books owned by a single thread.
+ */
+struct NullMutex
+{
+    void lock() { }
+    void unlock() { }
+    bool try_lock() { return true; }
+};
+
+/**
+ * @brief Original configuration: shared_ptr orders in std::list levels, std::map sides,
+ *        a std::mutex around every call and a background prune thread.
+ */
+struct DefaultOrderbookTraits
+{
+    using Storage = SharedOrderStorage;
+
+    template <typename Level, Side S>
+    using Levels = MapPriceLevels<Level, S>;
+
+    using Mutex = std::mutex;
+
+    static constexpr bool PruneThread = true;
+
+    static constexpr Quantity ExpirySlice = 256;
+
+    static constexpr std::size_t DepthLevels = 10;
+
+    static constexpr std::size_t LevelUpdateCapacity = 1 << 12;
+
+    using Instrumentation = NullInstrumentation;
+};
+
+using SharedOrderbookTraits = DefaultOrderbookTraits;
+
+/**
+ * @brief Pool-backed configuration: slab-allocated orders in intrusive levels, std::map sides.
+ */
+struct PooledOrderbookTraits : DefaultOrderbookTraits
+{
+    using Storage = PooledOrderStorage;
+};
+
+/**
+ * @brief Pool-backed configuration with tick-indexed ladder sides.
+ */
+struct LadderOrderbookTraits : PooledOrderbookTraits
+{
+    template <typename Level, Side S>
+    using Levels = LadderPriceLevels<Level, S>;
+};
+
+/**
+ * @brief Adapts a configuration for a book owned exclusively by one thread:
+ *        no locking and no prune thread (the owner schedules expiry itself).
+ */
+template <typename Traits>
+struct SingleWriterTraits : Traits
+{
+    using Mutex = NullMutex;
+
+    static constexpr bool PruneThread = false;
+};
+
+/**
+ * @brief Adds per-thread latency histograms and counters to a configuration.
+ */
+template <typename Traits>
+struct InstrumentedTraits : Traits
+{
+    using Instrumentation = OrderbookInstrumentation;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Two-level occupancy bitmap over a fixed number of slots.
+ *
+ * One bit per slot plus a summary bit per 64-slot word, so finding the next
+ * occupied slot above or below a position inspects at most two words for
+ * windows of up to 4096 slots (and one more summary word per further 4096).
+ */
+class PriceBitmap {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /**
+         * @param size Number of slots; must be a multiple of 64.
+         */
+        explicit PriceBitmap (std::size_t size)
+            : words_ (size / 64)
+            , summary_ ((size / 64 + 63) / 64)
+        { }
+
+        bool Test (std::size_t index) const { return (words_[index / 64] >> (index % 64)) & 1; }
+
+        void Set (std::size_t index) {
+            words_[index / 64] |= Bit(index % 64);
+            summary_[index / 4096] |= Bit(index / 64 % 64);
+        }
+
+        void Clear (std::size_t index) {
+            auto& word = words_[index / 64];
+            word &= ~Bit(index % 64);
+            if (word == 0)
+                summary_[index / 4096] &= ~Bit(index / 64 % 64);
+        }
+
+        /** @brief Clears every slot. */
+        void Reset () {
+            std::fill(words_.begin(), words_.end(), 0);
+            std::fill(summary_.begin(), summary_.end(), 0);
+        }
+
+        /** @return Lowest occupied slot at or above index, or npos. */
+        std::size_t FindNext (std::size_t index) const {
+            std::size_t word = index / 64;
+            if (word >= words_.size())
+                return npos;
+
+            const std::uint64_t bits = words_[word] & (~std::uint64_t{ 0 } << (index % 64));
+            if (bits != 0)
+                return word * 64 + std::countr_zero(bits);
+
+            // Continue in the summary from the following word
+            for (std::size_t next = word + 1; next < words_.size(); )
+            {
+                const std::uint64_t summary = summary_[next / 64] & (~std::uint64_t{ 0 } << (next % 64));
+                if (summary != 0)
+                {
+                    const std::size_t found = next / 64 * 64 + std::countr_zero(summary);
+                    return found * 64 + std::countr_zero(words_[found]);
+                }
+                next = (next / 64 + 1) * 64;
+            }
+
+            return npos;
+        }
+
+        /** @return Highest occupied slot at or below index, or npos. */
+        std::size_t FindPrev (std::size_t index) const {
+            std::size_t word = index / 64;
+            if (word >= words_.size())
+            {
+                word = words_.size() - 1;
+                index = words_.size() * 64 - 1;
+            }
+
+            const std::uint64_t bits = words_[word] & (~std::uint64_t{ 0 } >> (63 - index % 64));
+            if (bits != 0)
+                return word * 64 + 63 - std::countl_zero(bits);
+
+            // Continue in the summary from the preceding word
+            for (std::size_t prev = word; prev-- > 0; )
+            {
+                const std::uint64_t summary = summary_[prev / 64] & (~std::uint64_t{ 0 } >> (63 - prev % 64));
+                if (summary != 0)
+                {
+                    const std::size_t found = prev / 64 * 64 + 63 - std::countl_zero(summary);
+                    return found * 64 + 63 - std::countl_zero(words_[found]);
+                }
+                prev = prev / 64 * 64;
+            }
+
+            return npos;
+        }
+
+        /** @brief Invokes function(data, size) for each bit array (see MemoryPlacement.h). */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&& function) const {
+            function(static_cast<const void*>(words_.data()), words_.size() * sizeof(std::uint64_t));
+            function(static_cast<const void*>(summary_.data()), summary_.size() * sizeof(std::uint64_t));
+        }
+
+    private:
+        static std::uint64_t Bit (std::size_t position) { return std::uint64_t{ 1 } << position; }
+
+        std::vector<std::uint64_t> words_;
+        std::vector<std::uint64_t> summary_;
+};
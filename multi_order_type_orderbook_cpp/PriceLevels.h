@@ -0,0 +1,304 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+#include "Usings.h"
+#include "Side.h"
+#include "PriceBitmap.h"
+
+/**
+ * @brief Price-level containers used for the bid and ask sides of BasicOrderbook.
+ *
+ * Both containers map a price to a Level (the per-price order FIFO) and keep
+ * levels in priority order for side S: highest price first for bids, lowest
+ * first for asks. They share one interface so the book is written once:
+ * - Empty / BestPrice / Best / WorstPrice
+ * - FindOrInsert / Find / Erase / EraseBest
+ * - ForEachLevel(function): visits (price, level) best first, stops when function returns false.
+ * - ForEachMemoryRegion(function): visits the preallocated arrays (see MemoryPlacement.h).
+ *
+ * The book erases a level as soon as its FIFO becomes empty.
+ */
+
+/**
+ * @brief Red-black tree levels (the original std::map layout).
+ */
+template <typename Level, Side S>
+class MapPriceLevels {
+    public:
+        using Compare = std::conditional_t<S == Side::Buy, std::greater<Price>, std::less<Price>>;
+
+        bool Empty () const { return levels_.empty(); }
+
+        /** @return Best price on this side (side must not be empty). */
+        Price BestPrice () const { return levels_.begin()->first; }
+
+        /** @return Level at the best price (side must not be empty). */
+        Level& Best () { return levels_.begin()->second; }
+        const Level& Best () const { return levels_.begin()->second; }
+
+        /** @return Worst price on this side (side must not be empty). */
+        Price WorstPrice () const { return levels_.rbegin()->first; }
+
+        /** @return Level at price, creating an empty one if absent. */
+        Level& FindOrInsert (Price price) { return levels_[price]; }
+
+        /** @return Level at price, or nullptr if none. */
+        Level* Find (Price price) {
+            auto found = levels_.find(price);
+            return found == levels_.end() ? nullptr : &found->second;
+        }
+
+        void Erase (Price price) { levels_.erase(price); }
+
+        void EraseBest () { levels_.erase(levels_.begin()); }
+
+        template <typename Function>
+        void ForEachLevel (Function&& function) const {
+            for (const auto& [price, level] : levels_)
+                if (!function(price, level))
+                    return;
+        }
+
+        /** @brief Tree nodes are allocated per level, so there is no region to visit. */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&&) const { }
+
+    private:
+        std::map<Price, Level, Compare> levels_;
+};
+
+/**
+ * @brief Tick-indexed price ladder: a contiguous window of levels around the touch.
+ *
+ * Prices inside [base_, base_ + WindowTicks) live in a flat array indexed by
+ * price - base_, with a PriceBitmap of occupied ticks so the next non-empty
+ * level is found in O(1). The best price is cached in best_. Prices that fall
+ * outside the window on the passive side go to an overflow std::map.
+ *
+ * Invariant: whenever the side is not empty, the best level is in the window
+ * and every overflow level is worse than every tick in the window. When a new
+ * price improves on the best from outside the window, or the window empties
+ * while overflow levels remain, the window is recentered on the new best
+ * (an O(WindowTicks) move, rare once prices settle around mid).
+ */
+template <typename Level, Side S, std::size_t WindowTicks = 4096>
+class LadderPriceLevels {
+    static_assert(WindowTicks % 64 == 0, "WindowTicks must be a multiple of 64");
+
+    public:
+        LadderPriceLevels ()
+            : levels_ (WindowTicks)
+            , occupied_ { WindowTicks }
+            , scratch_ { WindowTicks }
+        { }
+
+        bool Empty () const { return windowLevels_ == 0 && overflow_.empty(); }
+
+        /** @return Best price on this side (side must not be empty). */
+        Price BestPrice () const { return best_; }
+
+        /** @return Level at the best price (side must not be empty). */
+        Level& Best () { return levels_[Index(best_)]; }
+        const Level& Best () const { return levels_[Index(best_)]; }
+
+        /** @return Worst price on this side (side must not be empty). */
+        Price WorstPrice () const {
+            if (!overflow_.empty())
+                return IsBid ? overflow_.begin()->first : overflow_.rbegin()->first;
+
+            return PriceAt(IsBid ? occupied_.FindNext(0) : occupied_.FindPrev(WindowTicks - 1));
+        }
+
+        /** @return Level at price, creating an empty one if absent. */
+        Level& FindOrInsert (Price price) {
+            if (Empty())
+                Recenter(price);
+            else if (!InWindow(price))
+            {
+                if (!IsBetter(price, best_))
+                    return overflow_[price];
+
+                Recenter(price);
+            }
+
+            const std::size_t index = Index(price);
+            if (!occupied_.Test(index))
+            {
+                occupied_.Set(index);
+                if (windowLevels_++ == 0 || IsBetter(price, best_))
+                    best_ = price;
+            }
+
+            return levels_[index];
+        }
+
+        /** @return Level at price, or nullptr if none. */
+        Level* Find (Price price) {
+            if (!InWindow(price))
+            {
+                auto found = overflow_.find(price);
+                return found == overflow_.end() ? nullptr : &found->second;
+            }
+
+            const std::size_t index = Index(price);
+            return occupied_.Test(index) ? &levels_[index] : nullptr;
+        }
+
+        void Erase (Price price) {
+            if (!InWindow(price))
+            {
+                overflow_.erase(price);
+                return;
+            }
+
+            const std::size_t index = Index(price);
+            levels_[index] = Level{ };
+            occupied_.Clear(index);
+            --windowLevels_;
+
+            if (price != best_)
+                return;
+
+            if (windowLevels_ > 0)
+                best_ = PriceAt(NextWorse(index));
+            else if (!overflow_.empty())
+                Recenter(IsBid ? overflow_.rbegin()->first : overflow_.begin()->first);
+        }
+
+        void EraseBest () { Erase(best_); }
+
+        template <typename Function>
+        void ForEachLevel (Function&& function) const {
+            if (windowLevels_ > 0)
+            {
+                for (std::size_t index = Index(best_); index != PriceBitmap::npos; index = NextWorse(index))
+                    if (!function(PriceAt(index), levels_[index]))
+                        return;
+            }
+
+            if constexpr (IsBid)
+            {
+                for (auto level = overflow_.rbegin(); level != overflow_.rend(); ++level)
+                    if (!function(level->first, level->second))
+                        return;
+            }
+            else
+            {
+                for (const auto& [price, level] : overflow_)
+                    if (!function(price, level))
+                        return;
+            }
+        }
+
+        /** @brief Visits the window's level array and bitmaps; overflow levels are tree nodes. */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&& function) const {
+            function(static_cast<const void*>(levels_.data()), levels_.size() * sizeof(Level));
+            occupied_.ForEachMemoryRegion(function);
+            scratch_.ForEachMemoryRegion(function);
+        }
+
+    private:
+        static constexpr bool IsBid = S == Side::Buy;
+
+        static bool IsBetter (Price price, Price than) { return IsBid ? price > than : price < than; }
+
+        bool InWindow (Price price) const {
+            const std::int64_t offset = std::int64_t{ price } - base_;
+            return offset >= 0 && offset < static_cast<std::int64_t>(WindowTicks);
+        }
+
+        std::size_t Index (Price price) const { return static_cast<std::size_t>(std::int64_t{ price } - base_); }
+
+        Price PriceAt (std::size_t index) const { return static_cast<Price>(base_ + static_cast<std::int64_t>(index)); }
+
+        /** @return Next occupied window index worse than index, or npos. */
+        std::size_t NextWorse (std::size_t index) const {
+            if constexpr (IsBid)
+                return index == 0 ? PriceBitmap::npos : occupied_.FindPrev(index - 1);
+            else
+                return index + 1 >= WindowTicks ? PriceBitmap::npos : occupied_.FindNext(index + 1);
+        }
+
+        /**
+         * @brief Moves the window so that center sits in its middle.
+         *
+         * Levels leaving the window go to overflow, overflow levels entering it are
+         * pulled in, and best_ is recomputed from the bitmap.
+         */
+        void Recenter (Price center) {
+            const std::int64_t newBase = std::int64_t{ center } - static_cast<std::int64_t>(WindowTicks / 2);
+            const std::int64_t shift = newBase - base_;
+            const auto inNewWindow = [newBase](std::int64_t price)
+            {
+                return price >= newBase && price < newBase + static_cast<std::int64_t>(WindowTicks);
+            };
+
+            scratch_.Reset();
+
+            // Levels move to lower indices when the window moves up, so walk in the
+            // direction that never overwrites a level that has not been moved yet.
+            const auto relocate = [&](std::size_t index)
+            {
+                const std::int64_t price = base_ + static_cast<std::int64_t>(index);
+                if (!inNewWindow(price))
+                {
+                    overflow_.emplace(static_cast<Price>(price), std::move(levels_[index]));
+                    --windowLevels_;
+                }
+                else
+                {
+                    const std::size_t target = static_cast<std::size_t>(price - newBase);
+                    if (target != index)
+                        levels_[target] = std::move(levels_[index]);
+                    scratch_.Set(target);
+                    if (target == index)
+                        return;
+                }
+                levels_[index] = Level{ };
+            };
+
+            if (windowLevels_ > 0)
+            {
+                if (shift > 0)
+                    for (std::size_t index = occupied_.FindNext(0); index != PriceBitmap::npos;
+                        index = index + 1 < WindowTicks ? occupied_.FindNext(index + 1) : PriceBitmap::npos)
+                        relocate(index);
+                else
+                    for (std::size_t index = occupied_.FindPrev(WindowTicks - 1); index != PriceBitmap::npos;
+                        index = index > 0 ? occupied_.FindPrev(index - 1) : PriceBitmap::npos)
+                        relocate(index);
+            }
+
+            std::swap(occupied_, scratch_);
+            base_ = newBase;
+
+            for (auto level = overflow_.lower_bound(static_cast<Price>(std::max<std::int64_t>(newBase, std::numeric_limits<Price>::min())));
+                level != overflow_.end() && inNewWindow(level->first); )
+            {
+                const std::size_t index = Index(level->first);
+                levels_[index] = std::move(level->second);
+                occupied_.Set(index);
+                ++windowLevels_;
+                level = overflow_.erase(level);
+            }
+
+            if (windowLevels_ > 0)
+                best_ = PriceAt(IsBid ? occupied_.FindPrev(WindowTicks - 1) : occupied_.FindNext(0));
+        }
+
+        std::vector<Level> levels_;
+        PriceBitmap occupied_;
+        PriceBitmap scratch_;
+        std::map<Price, Level> overflow_;
+        std::int64_t base_{ };
+        std::size_t windowLevels_{ };
+        Price best_{ };
+};
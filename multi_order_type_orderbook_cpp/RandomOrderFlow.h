@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Command.h"
+
+/**
+ * @brief Seeded random order flow of one producer, as Commands.
+ *
+ * Mixes passive and crossing limit orders, Fill‑And‑Kill orders, cancels and
+ * modifies around a mid price; half the modifies keep the order's side and
+ * price, so they cut its quantity in place when it still has enough left.
+ * Cancels and modifies only target ids this flow added, so several flows with
+ * disjoint id ranges can drive one book from different threads; an id that
+ * has since filled is simply not found by the book. The same seed always
+ * yields the same commands, so a failing stress run can be repeated.
+ */
+class RandomOrderFlow {
+    public:
+        /**
+         * @param seed Seed of the flow's generator.
+         * @param firstOrderId First id to assign; ids then count up from it.
+         * @param midPrice Price the flow's orders are spread around.
+         * @param spread Orders are priced within midPrice +/- spread.
+         */
+        RandomOrderFlow (std::uint64_t seed, OrderId firstOrderId, Price midPrice = 10'000, Price spread = 20)
+            : random_ { seed }
+            , nextOrderId_ { firstOrderId }
+            , midPrice_ { midPrice }
+            , spread_ { spread }
+        {
+            live_.reserve(LiveCapacity);
+        }
+
+        /** @return The next command of the flow. */
+        Command Next () {
+            const auto roll = Uniform(100);
+            if (live_.empty() || roll < 55)
+                return Add(OrderType::GoodTillCancel);
+            if (roll < 65)
+                return Add(OrderType::FillAndKill);
+            if (roll < 85)
+                return Cancel();
+            return Modify();
+        }
+
+    private:
+        static constexpr std::size_t LiveCapacity = 1024;
+
+        struct LiveOrder {
+            OrderId orderId_;
+            Side side_;
+            Price price_;
+        };
+
+        std::uint64_t Uniform (std::uint64_t bound) { return random_() % bound; }
+
+        Price RandomPrice () { return midPrice_ - spread_ + static_cast<Price>(Uniform(2 * static_cast<std::uint64_t>(spread_) + 1)); }
+
+        Quantity RandomQuantity () { return static_cast<Quantity>(1 + Uniform(20)); }
+
+        Command Add (OrderType orderType) {
+            const LiveOrder order{ nextOrderId_++, Uniform(2) == 0 ? Side::Buy : Side::Sell, RandomPrice() };
+
+            if (orderType == OrderType::GoodTillCancel)
+            {
+                // Once enough are tracked, forget a random one; most of them have traded by then
+                if (live_.size() == LiveCapacity)
+                    live_[Uniform(LiveCapacity)] = order;
+                else
+                    live_.push_back(order);
+            }
+
+            return Command::Add(Order{ orderType, order.orderId_, order.side_, order.price_, RandomQuantity() });
+        }
+
+        Command Cancel () {
+            const std::size_t index = Uniform(live_.size());
+            const OrderId orderId = live_[index].orderId_;
+            live_[index] = live_.back();
+            live_.pop_back();
+            return Command::Cancel(orderId);
+        }
+
+        Command Modify () {
+            auto& order = live_[Uniform(live_.size())];
+            if (Uniform(2) == 0)
+            {
+                order.side_ = Uniform(2) == 0 ? Side::Buy : Side::Sell;
+                order.price_ = RandomPrice();
+            }
+            return Command::Modify(OrderModify{ order.orderId_, order.side_, order.price_, RandomQuantity() });
+        }
+
+        std::mt19937_64 random_;
+        OrderId nextOrderId_;
+        Price midPrice_;
+        Price spread_;
+        std::vector<LiveOrder> live_;
+};
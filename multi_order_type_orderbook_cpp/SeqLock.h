@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "Constants.h"
+#include "ThreadAffinity.h"
+
+/**
+ * @brief Single-writer sequence lock publishing a trivially copyable value.
+ *
+ * The writer never waits: it bumps the sequence to odd, stores the value and
+ * bumps it back to even. Readers copy the value and retry if the sequence was
+ * odd or changed meanwhile, so they never block the writer. The value is kept
+ * as relaxed atomic words, which makes the racing reads well defined.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+        "SeqLock values are copied word by word.");
+
+    static constexpr std::size_t WordCount = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    using Words = std::array<std::uint64_t, WordCount>;
+
+    public:
+        SeqLock () { Store(T{ }); }
+
+        SeqLock(const SeqLock&) = delete;
+        void operator=(const SeqLock&) = delete;
+
+        /**
+         * @brief Writer side: publishes a new value. Only one thread may store.
+         */
+        void Store (const T& value) {
+            Words words{ };
+            std::memcpy(words.data(), &value, sizeof(T));
+
+            const std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (std::size_t word = 0; word < WordCount; ++word)
+                words_[word].store(words[word], std::memory_order_relaxed);
+
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief Reader side: copies out a consistent value, retrying while a store is in progress.
+         */
+        T Load () const {
+            Words words;
+
+            while (true)
+            {
+                const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+                if ((before & 1) != 0)
+                {
+                    CpuRelax();
+                    continue;
+                }
+
+                for (std::size_t word = 0; word < WordCount; ++word)
+                    words[word] = words_[word].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == before)
+                    break;
+            }
+
+            T value;
+            std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+            return value;
+        }
+
+        /** @return Number of completed stores (including the initial one). */
+        std::uint64_t Version () const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+    private:
+        alignas(Constants::CacheLineSize) std::atomic<std::uint64_t> sequence_ { 0 };
+        std::array<std::atomic<std::uint64_t>, WordCount> words_ { };
+};
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <cstdint>
+
 /**
  * @brief Represents whether an order is to buy or sell.
  */
-enum class Side
+enum class Side : std::uint8_t
 {
     Buy,
     Sell
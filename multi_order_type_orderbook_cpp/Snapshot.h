@@ -0,0 +1,238 @@
+#pragma once
+
+/**
+ * @file Snapshot.h
+ * @brief Compact point-in-time image of a book's resting orders.
+ *
+ * Orders are stored in price-time priority (bids best first, then asks best
+ * first, oldest first within a level), so restoring them in file order
+ * rebuilds the same levels with the same queue positions. Expiry order is
+ * kept apart from it, so a snapshot taken between the slices of a
+ * Good‑For‑Day expiry continues that expiry, in the same order, once
+ * restored. Together with the journal sequence it was taken at, an image
+ * lets recovery skip everything the book had applied and replay only the
+ * journal tail (see Journal.h).
+ *
+ * Layout (little-endian)
+ *   0  8 bytes  magic "OBSNAPS2"
+ *   8  u64      journal sequence of the last command the image includes
+ *  16  u64      order count N
+ *  24  u8       1 if the book has traded, else 0
+ *  25  3 bytes  reserved, zero
+ *  28  i32      last trade price, which pending stops trigger against
+ *  32  u64      account count M
+ *  40  u64      expiring order count E
+ *  48  u64      sealed count S (<= E)
+ *  56  N order records of 32 bytes:
+ *        0  u64  order id
+ *        8  i32  price
+ *       12  u32  initial quantity
+ *       16  u32  remaining quantity
+ *       20  u8   OrderType
+ *       21  u8   Side
+ *       22  u16  account
+ *       24  u64  expiry
+ *  56 + 32N  M account records of 32 bytes, one per id the limits table covers:
+ *        0  u16  account
+ *        2  u8   SelfTradePrevention
+ *        3  5 bytes  reserved, zero
+ *        8  i64  maximum position
+ *       16  i64  maximum notional
+ *       24  i64  position
+ *  56 + 32(N + M)  E u64 ids of the Good‑For‑Day and Good‑Till‑Date orders
+ *        in the order expiry takes them; the first S are those of a
+ *        Good‑For‑Day expiry in progress (see ExpiryIndex)
+ *  56 + 32(N + M) + 8E  u32  CRC-32 of every preceding byte
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AccountRisk.h"
+#include "Crc32.h"
+#include "DurableFile.h"
+#include "MappedFile.h"
+#include "Order.h"
+#include "WireFormat.h"
+
+/**
+ * @brief A snapshot held in memory: captured from a book, or loaded from a file.
+ */
+class SnapshotImage {
+    public:
+        static constexpr std::string_view Magic{ "OBSNAPS2" };
+        static constexpr std::size_t HeaderSize = 56;
+        static constexpr std::size_t OrderSize = 32;
+        static constexpr std::size_t AccountSize = 32;
+        static constexpr std::size_t ExpiringSize = 8;
+        static constexpr std::size_t TrailerSize = 4;
+
+        /**
+         * @brief Copies every resting order of book, its expiry order, its
+         *        account limits and positions, and its last trade price into a new image.
+         *
+         * Must run on the thread that owns the book so no command slips in
+         * between the orders and the sequence recorded with them.
+         * @param sequence Journal sequence of the last command the book applied (0 if none).
+         */
+        template <typename Book>
+        static SnapshotImage Capture (const Book& book, std::uint64_t sequence) {
+            SnapshotImage image;
+            auto& bytes = image.bytes_;
+            bytes.reserve(HeaderSize + book.Size() * OrderSize + TrailerSize);
+            bytes.resize(HeaderSize);
+
+            std::uint64_t count = 0;
+            book.ForEachOrder([&bytes, &count](const Order& order)
+            {
+                bytes.resize(bytes.size() + OrderSize);
+                unsigned char* record = bytes.data() + bytes.size() - OrderSize;
+
+                LittleEndian::Store(record, order.GetOrderId());
+                LittleEndian::Store(record + 8, order.GetPrice());
+                LittleEndian::Store(record + 12, order.GetInitialQuantity());
+                LittleEndian::Store(record + 16, order.GetRemainingQuantity());
+                record[20] = static_cast<unsigned char>(order.GetOrderType());
+                record[21] = static_cast<unsigned char>(order.GetSide());
+                LittleEndian::Store(record + 22, order.GetAccount());
+                LittleEndian::Store(record + 24, order.GetExpiry());
+                ++count;
+            });
+
+            std::uint64_t accountCount = 0;
+            book.ForEachAccount([&bytes, &accountCount](AccountId account, const AccountLimits& limits, const AccountExposure& exposure)
+            {
+                bytes.resize(bytes.size() + AccountSize);
+                unsigned char* record = bytes.data() + bytes.size() - AccountSize;
+
+                LittleEndian::Store(record, account);
+                record[2] = static_cast<unsigned char>(limits.selfTradePrevention_);
+                LittleEndian::Store(record + 8, limits.maxPosition_);
+                LittleEndian::Store(record + 16, limits.maxNotional_);
+                LittleEndian::Store(record + 24, exposure.position_);
+                ++accountCount;
+            });
+
+            std::uint64_t expiringCount = 0, sealedCount = 0;
+            book.ForEachExpiringOrder([&bytes, &expiringCount, &sealedCount](OrderId orderId, bool sealed)
+            {
+                bytes.resize(bytes.size() + ExpiringSize);
+                LittleEndian::Store(bytes.data() + bytes.size() - ExpiringSize, orderId);
+                ++expiringCount;
+                sealedCount += sealed;
+            });
+
+            Magic.copy(reinterpret_cast<char*>(bytes.data()), Magic.size());
+            LittleEndian::Store(bytes.data() + 8, sequence);
+            LittleEndian::Store(bytes.data() + 16, count);
+
+            const std::optional<Price> lastTradePrice = book.GetLastTradePrice();
+            bytes[24] = lastTradePrice.has_value();
+            LittleEndian::Store(bytes.data() + 28, lastTradePrice.value_or(0));
+            LittleEndian::Store(bytes.data() + 32, accountCount);
+            LittleEndian::Store(bytes.data() + 40, expiringCount);
+            LittleEndian::Store(bytes.data() + 48, sealedCount);
+
+            bytes.resize(bytes.size() + TrailerSize);
+            LittleEndian::Store(bytes.data() + bytes.size() - TrailerSize, Crc32::Compute(bytes.data(), bytes.size() - TrailerSize));
+            return image;
+        }
+
+        /**
+         * @brief Reads and verifies an image written by Write.
+         * @throws std::runtime_error if the file is missing, truncated or corrupt.
+         */
+        static SnapshotImage Load (const std::string& path) {
+            MappedFile file{ path };
+            const auto* data = reinterpret_cast<const unsigned char*>(file.Data());
+
+            if (file.Size() < HeaderSize + TrailerSize || file.View().substr(0, Magic.size()) != Magic)
+                throw std::runtime_error("Not a snapshot: " + path);
+
+            const auto count = LittleEndian::Load<std::uint64_t>(data + 16);
+            const auto accountCount = LittleEndian::Load<std::uint64_t>(data + 32);
+            const auto expiringCount = LittleEndian::Load<std::uint64_t>(data + 40);
+            if (count > file.Size() / OrderSize || accountCount > file.Size() / AccountSize || expiringCount > file.Size() / ExpiringSize
+                || file.Size() != HeaderSize + count * OrderSize + accountCount * AccountSize + expiringCount * ExpiringSize + TrailerSize)
+                throw std::runtime_error("Truncated snapshot: " + path);
+
+            const std::size_t size = file.Size();
+            if (Crc32::Compute(data, size - TrailerSize) != LittleEndian::Load<std::uint32_t>(data + size - TrailerSize))
+                throw std::runtime_error("Corrupt snapshot: " + path);
+
+            SnapshotImage image;
+            image.bytes_.assign(data, data + size);
+            return image;
+        }
+
+        /**
+         * @brief Rests the image's orders in an empty book, in their original
+         *        priority and expiry order, and restores its accounts and last trade price.
+         * @throws std::logic_error if an order conflicts with the book (see RestoreOrder).
+         */
+        template <typename Book>
+        void Restore (Book& book) const {
+            // Accounts first, so each order counts towards its account as it rests
+            for (std::uint64_t index = 0; index < AccountCount(); ++index)
+            {
+                const unsigned char* record = bytes_.data() + HeaderSize + OrderCount() * OrderSize + index * AccountSize;
+
+                const AccountLimits limits{ LittleEndian::Load<std::int64_t>(record + 8), LittleEndian::Load<std::int64_t>(record + 16),
+                    static_cast<SelfTradePrevention>(record[2]) };
+                const auto account = LittleEndian::Load<AccountId>(record);
+                if (account != Constants::NoAccount)
+                    book.RestoreAccount(account, limits, LittleEndian::Load<std::int64_t>(record + 24));
+            }
+
+            for (std::uint64_t index = 0; index < OrderCount(); ++index)
+            {
+                const unsigned char* record = bytes_.data() + HeaderSize + index * OrderSize;
+
+                const auto initialQuantity = LittleEndian::Load<Quantity>(record + 12);
+                const auto remainingQuantity = LittleEndian::Load<Quantity>(record + 16);
+
+                Order order{ static_cast<OrderType>(record[20]), LittleEndian::Load<OrderId>(record),
+                    static_cast<Side>(record[21]), LittleEndian::Load<Price>(record + 8), initialQuantity,
+                    LittleEndian::Load<Expiry>(record + 24), LittleEndian::Load<AccountId>(record + 22) };
+                order.Fill(initialQuantity - remainingQuantity);
+                book.RestoreOrder(order);
+            }
+
+            const unsigned char* expiring = bytes_.data() + HeaderSize + OrderCount() * OrderSize + AccountCount() * AccountSize;
+            for (std::uint64_t index = 0; index < ExpiringCount(); ++index)
+                book.RestoreExpiryPosition(LittleEndian::Load<OrderId>(expiring + index * ExpiringSize), index < SealedCount());
+
+            if (bytes_[24] != 0)
+                book.RestoreLastTradePrice(LittleEndian::Load<Price>(bytes_.data() + 28));
+        }
+
+        /**
+         * @brief Durably replaces the file at path with this image (see WriteFileDurably).
+         * @throws std::runtime_error on any I/O failure.
+         */
+        void Write (const std::string& path) const { WriteFileDurably(path, { bytes_ }); }
+
+        /** @return Journal sequence of the last command the image includes. */
+        std::uint64_t Sequence () const { return LittleEndian::Load<std::uint64_t>(bytes_.data() + 8); }
+
+        std::uint64_t OrderCount () const { return LittleEndian::Load<std::uint64_t>(bytes_.data() + 16); }
+
+        std::uint64_t AccountCount () const { return LittleEndian::Load<std::uint64_t>(bytes_.data() + 32); }
+
+        std::uint64_t ExpiringCount () const { return LittleEndian::Load<std::uint64_t>(bytes_.data() + 40); }
+
+        std::uint64_t SealedCount () const { return LittleEndian::Load<std::uint64_t>(bytes_.data() + 48); }
+
+        std::span<const unsigned char> Bytes () const { return bytes_; }
+
+    private:
+        SnapshotImage () = default;
+
+        std::vector<unsigned char> bytes_;
+};
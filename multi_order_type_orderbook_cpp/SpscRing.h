@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+#include "Constants.h"
+
+/**
+ * @brief Bounded lock-free single-producer / single-consumer ring buffer.
+ *
+ * Exactly one thread may call TryPush and exactly one (other) thread may call
+ * TryPop. Head and tail live on separate cache lines and each side caches the
+ * other's index, so an uncontended push or pop touches no shared line.
+ */
+template <typename T>
+class SpscRing {
+    public:
+        /**
+         * @param capacity Number of elements; must be a power of two.
+         * @throws std::invalid_argument if capacity is not a power of two.
+         */
+        explicit SpscRing (std::size_t capacity)
+            : buffer_ (capacity)
+            , mask_ { capacity - 1 }
+        {
+            if (capacity == 0 || (capacity & mask_) != 0)
+                throw std::invalid_argument("SpscRing capacity must be a power of two.");
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        void operator=(const SpscRing&) = delete;
+
+        /**
+         * @brief Producer side: appends a copy of value.
+         * @return False if the ring is full.
+         */
+        bool TryPush (const T& value) {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - headCache_ == buffer_.size()) {
+                headCache_ = head_.load(std::memory_order_acquire);
+                if (tail - headCache_ == buffer_.size())
+                    return false;
+            }
+
+            buffer_[tail & mask_] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Consumer side: removes the oldest element into value.
+         * @return False if the ring is empty.
+         */
+        bool TryPop (T& value) {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tailCache_) {
+                tailCache_ = tail_.load(std::memory_order_acquire);
+                if (head == tailCache_)
+                    return false;
+            }
+
+            value = buffer_[head & mask_];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** @return True if nothing is queued (exact only when both sides are quiescent). */
+        bool Empty () const {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+        std::size_t Capacity () const { return buffer_.size(); }
+
+        /** @brief Invokes function(data, size) for the element buffer (see MemoryPlacement.h). */
+        template <typename Function>
+        void ForEachMemoryRegion (Function&& function) const {
+            function(static_cast<const void*>(buffer_.data()), buffer_.size() * sizeof(T));
+        }
+
+    private:
+        // Consumer-owned line
+        alignas(Constants::CacheLineSize) std::atomic<std::size_t> head_ { 0 };
+        std::size_t tailCache_ { 0 };
+
+        // Producer-owned line
+        alignas(Constants::CacheLineSize) std::atomic<std::size_t> tail_ { 0 };
+        std::size_t headCache_ { 0 };
+
+        alignas(Constants::CacheLineSize) std::vector<T> buffer_;
+        std::size_t mask_;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+#include <optional>
+
+#include "Order.h"
+#include "OrderIndex.h"
+#include "OrderType.h"
+#include "Side.h"
+#include "Usings.h"
+
+/**
+ * @brief Pending Stop and StopLimit orders of one book, each side in trigger order.
+ *
+ * A buy stop triggers once a trade prints at or above its stop price, a sell
+ * stop once one prints at or below it, so buys are kept lowest stop first and
+ * sells highest first, in arrival order within a stop price. The front stop
+ * price of each side is cached as that side's next trigger: after a trade the
+ * book asks IsDue, two compares however many stops wait, and only pops when
+ * the last trade price has crossed one of them. Nothing is ever rescanned,
+ * and a book without pending stops never calls in at all.
+ *
+ * Pending stops are not resting orders: they hold no level quantity and no
+ * account exposure until they trigger and enter the book.
+ *
+ * Not thread-safe; the owning book calls it under its lock.
+ */
+class StopIndex {
+    public:
+        /** @return True if orders of orderType wait here instead of entering the book. */
+        static constexpr bool Holds (OrderType orderType) {
+            return orderType == OrderType::Stop || orderType == OrderType::StopLimit;
+        }
+
+        bool Empty () const { return ids_.Empty(); }
+        std::size_t Size () const { return ids_.Size(); }
+
+        bool Contains (OrderId orderId) const { return ids_.Contains(orderId); }
+
+        /** @brief Queues a stop order whose id is not in use (the caller checks). */
+        void Add (const Order& order) {
+            const Price stopPrice = order.GetStopPrice();
+            ids_.Insert(order.GetOrderId(), Key{ order.GetSide(), stopPrice });
+
+            if (order.GetSide() == Side::Buy)
+                buys_.emplace(stopPrice, order);
+            else
+                sells_.emplace(stopPrice, order);
+
+            Refresh();
+        }
+
+        /** @return False if no stop with this id is pending. */
+        bool Cancel (OrderId orderId) {
+            Key key;
+            if (!ids_.Extract(orderId, key))
+                return false;
+
+            if (key.side_ == Side::Buy)
+                Erase(buys_, key.stopPrice_, orderId);
+            else
+                Erase(sells_, key.stopPrice_, orderId);
+
+            Refresh();
+            return true;
+        }
+
+        /** @return True if a trade at lastTradePrice triggers at least one pending stop. */
+        bool IsDue (Price lastTradePrice) const {
+            return lastTradePrice >= nextBuyTrigger_ || lastTradePrice <= nextSellTrigger_;
+        }
+
+        /**
+         * @brief Removes and returns the first stop a trade at lastTradePrice
+         *        triggers: buys before sells, earliest trigger first.
+         */
+        std::optional<Order> PopDue (Price lastTradePrice) {
+            // The sentinels of an empty side are prices a trade can still print at
+            if (lastTradePrice >= nextBuyTrigger_ && !buys_.empty())
+                return Pop(buys_);
+            if (lastTradePrice <= nextSellTrigger_ && !sells_.empty())
+                return Pop(sells_);
+            return std::nullopt;
+        }
+
+        /** @brief Invokes function with each pending stop: buys, then sells, in trigger order. */
+        template <typename Function>
+        void ForEach (Function&& function) const {
+            for (const auto& [stopPrice, order] : buys_)
+                function(order);
+            for (const auto& [stopPrice, order] : sells_)
+                function(order);
+        }
+
+    private:
+        struct Key {
+            Side side_{ Side::Buy };
+            Price stopPrice_{ };
+        };
+
+        template <typename Stops>
+        static void Erase (Stops& stops, Price stopPrice, OrderId orderId) {
+            auto stop = stops.lower_bound(stopPrice);
+            while (stop->second.GetOrderId() != orderId)
+                ++stop;
+            stops.erase(stop);
+        }
+
+        template <typename Stops>
+        std::optional<Order> Pop (Stops& stops) {
+            const auto front = stops.begin();
+            Order order = front->second;
+            stops.erase(front);
+            ids_.Erase(order.GetOrderId());
+            Refresh();
+            return order;
+        }
+
+        void Refresh () {
+            nextBuyTrigger_ = buys_.empty() ? std::numeric_limits<Price>::max() : buys_.begin()->first;
+            nextSellTrigger_ = sells_.empty() ? std::numeric_limits<Price>::min() : sells_.begin()->first;
+        }
+
+        std::multimap<Price, Order, std::less<>> buys_;
+        std::multimap<Price, Order, std::greater<>> sells_;
+        FlatOrderIndex<Key> ids_;
+        Price nextBuyTrigger_{ std::numeric_limits<Price>::max() };
+        Price nextSellTrigger_{ std::numeric_limits<Price>::min() };
+};
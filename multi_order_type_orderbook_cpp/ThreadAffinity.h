@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * @file ThreadAffinity.h
+ * @brief Helpers for threads that own a core: pinning and busy-wait pausing.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Pins the calling thread to one CPU core.
+ * @param core Zero-based core index; negative leaves the thread unpinned.
+ * @return True if the thread is now pinned to core.
+ */
+inline bool PinThisThread(int core)
+{
+    if (core < 0)
+        return false;
+
+#ifdef _WIN32
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << core) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+/**
+ * @brief Tells the CPU the caller is spinning, easing pressure on the sibling hyperthread.
+ */
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Usings.h"
+
+/**
+ * @brief Best bid and best ask of a book with their level aggregates.
+ *
+ * A side with no resting order has a zero quantity and count; its price is
+ * then meaningless. Trivially copyable and comparable, so a consumer can keep
+ * the last one it saw and act only when the top actually changed.
+ */
+struct TopOfBook
+{
+    Price bidPrice_{ };
+    Quantity bidQuantity_{ }; // Total remaining quantity at the best bid
+    Quantity bidCount_{ };    // Number of orders at the best bid
+    Price askPrice_{ };
+    Quantity askQuantity_{ };
+    Quantity askCount_{ };
+
+    bool HasBid () const { return bidCount_ != 0; }
+    bool HasAsk () const { return askCount_ != 0; }
+
+    friend bool operator== (const TopOfBook&, const TopOfBook&) = default;
+};
+
+/**
+ * @brief A TopOfBook as a book publishes it to lock-free readers.
+ *
+ * sequence_ counts changes of the top: it only moves when the published
+ * value differs from the previous one, so a poller comparing sequences knows
+ * the top changed without comparing the whole value.
+ */
+struct PublishedTopOfBook
+{
+    TopOfBook top_;
+    std::uint64_t sequence_{ }; // Number of changes published, 0 before the first order
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <concepts>
+#include <vector>
+
 #include "TradeInfo.h"
 
 /**
@@ -10,6 +13,11 @@
 class Trade {
     public:
 
+        /**
+         * @brief Constructs an empty trade (for preallocated trade buffers).
+         */
+        Trade () = default;
+
         /**
          * @brief Constructs a trade from the bid and ask trade information.
          * @param bidTrade Details of the bid side of the trade.
@@ -27,8 +35,27 @@ class Trade {
         const TradeInfo& GetAskTrade() const { return askTrade_; }
 
     private:
-        TradeInfo bidTrade_;
-        TradeInfo askTrade_;
+        TradeInfo bidTrade_ { };
+        TradeInfo askTrade_ { };
 };
 
-using Trades = std::vector<Trade>;
\ No newline at end of file
+using Trades = std::vector<Trade>;
+
+/**
+ * @brief Anything trades can be reported to as they happen: sink(const Trade&).
+ *
+ * The book calls sink directly from the matching loop, so a lambda or functor
+ * is inlined and reporting costs nothing beyond what the sink itself does.
+ */
+template <typename Sink>
+concept TradeSink = std::invocable<Sink&, const Trade&>;
+
+/**
+ * @brief Sink that appends trades to a caller-owned, reusable buffer.
+ */
+struct TradeAppender
+{
+    Trades& trades_;
+
+    void operator()(const Trade& trade) const { trades_.push_back(trade); }
+};
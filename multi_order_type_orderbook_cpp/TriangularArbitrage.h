@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "TopOfBook.h"
+#include "Usings.h"
+
+/**
+ * @brief A profitable currency cycle: converting through its three legs at
+ *        the current tops returns 1 + return_ units per unit of the start currency.
+ */
+struct TriangularSignal
+{
+    std::uint32_t cycle_{ };                 // Index of the cycle (see TriangularDetector::GetCycle)
+    std::array<CurrencyId, 3> currencies_{ }; // Start currency first, in conversion order
+    double return_{ };                       // Units returned per unit of the start currency, minus one
+    Quantity quantity_{ };                   // Executable amount of the start currency at the top levels
+    std::uint64_t timestamp_{ };             // Timestamp of the update that found the cycle profitable
+};
+
+/**
+ * @brief Callable invoked with each signal: void(const TriangularSignal&).
+ */
+template <typename Sink>
+concept TriangularSignalSink = std::invocable<Sink&, const TriangularSignal&>;
+
+/**
+ * @brief Detects triangular mispricings (e.g. EURUSD x USDJPY vs EURJPY) from
+ *        top-of-book changes of currency-pair books.
+ *
+ * A pair quotes its base currency in its quote currency; a price in ticks is
+ * a rate of price / ticksPerUnit and quantities are in base units. Every time
+ * a pair is registered, the triangles it closes with pairs already known are
+ * added as two cycles, one per direction, and each pair keeps the list of
+ * cycles it appears in. An update therefore re-evaluates only the cycles of
+ * the pair that changed, reading the stored tops of the other two legs, and
+ * allocates nothing.
+ *
+ * A leg that converts base into quote sells at the bid and can take at most
+ * the bid quantity; a leg that converts quote into base buys at the ask and
+ * can spend at most the ask quantity's worth of quote. The executable amount
+ * is the smallest of the three limits expressed in the start currency.
+ */
+class TriangularDetector {
+    public:
+        /**
+         * @param minimumReturn Smallest net return per unit worth a signal, e.g. the fees of three trades.
+         */
+        explicit TriangularDetector (double minimumReturn = 0.0)
+            : minimumReturn_ { minimumReturn }
+        { }
+
+        /**
+         * @brief Registers a pair and precomputes the cycles it closes.
+         * @param ticksPerUnit Price ticks per unit of rate, e.g. 10 000 for a pair quoted to 4 decimals.
+         * @return Dense index of the pair.
+         * @throws std::invalid_argument if both currencies are the same or ticksPerUnit is not positive.
+         */
+        std::size_t AddPair (InstrumentId instrumentId, CurrencyId base, CurrencyId quote, Price ticksPerUnit) {
+            if (base == quote || ticksPerUnit <= 0)
+                throw std::invalid_argument("A pair needs two currencies and a positive tick size.");
+
+            const auto pair = static_cast<std::uint32_t>(pairs_.size());
+            pairs_.push_back(Pair{ instrumentId, base, quote, 1.0 / ticksPerUnit, static_cast<double>(ticksPerUnit), { }, { } });
+
+            for (std::uint32_t first = 0; first < pair; ++first)
+            {
+                const CurrencyId third = OtherCurrency(pairs_[first], base);
+                if (third == NoCurrency || third == quote)
+                    continue;
+
+                for (std::uint32_t second = 0; second < pair; ++second)
+                    if (Connects(pairs_[second], quote, third))
+                    {
+                        // base -> quote -> third -> base and its reverse
+                        AddCycle({ base, quote, third }, { pair, second, first });
+                        AddCycle({ base, third, quote }, { first, second, pair });
+                    }
+            }
+
+            return pair;
+        }
+
+        /**
+         * @brief Records pair's new top of book and reports each of its cycles
+         *        that is profitable at the new tops.
+         *
+         * A cycle is reported on every update of one of its legs for as long as
+         * it stays profitable, each time with the current return and quantity,
+         * not only on the update that first made it so; a sink that wants edges
+         * only keeps the last signal per cycle.
+         * @param timestamp Copied into every signal, e.g. the receive time of the feed message.
+         */
+        template <TriangularSignalSink Sink>
+        void OnTopOfBook (std::size_t pair, const TopOfBook& top, std::uint64_t timestamp, Sink&& sink) {
+            pairs_[pair].top_ = top;
+
+            for (const std::uint32_t cycle : pairs_[pair].cycles_)
+                Evaluate(cycle, timestamp, sink);
+        }
+
+        /**
+         * @brief Reads book's top of book and passes it on if it changed since the last call for pair.
+         */
+        template <typename Book, TriangularSignalSink Sink>
+        void OnBookUpdate (std::size_t pair, const Book& book, std::uint64_t timestamp, Sink&& sink) {
+            const TopOfBook top = book.GetTopOfBook();
+            if (top != pairs_[pair].top_)
+                OnTopOfBook(pair, top, timestamp, sink);
+        }
+
+        /** @return Currencies of cycle, start currency first, in conversion order. */
+        const std::array<CurrencyId, 3>& GetCycle (std::size_t cycle) const { return cycles_[cycle].currencies_; }
+
+        /** @return Cycles re-evaluated when pair's top changes. */
+        std::span<const std::uint32_t> CyclesOf (std::size_t pair) const { return pairs_[pair].cycles_; }
+
+        std::size_t CycleCount () const { return cycles_.size(); }
+        std::size_t PairCount () const { return pairs_.size(); }
+
+    private:
+        static constexpr CurrencyId NoCurrency = std::numeric_limits<CurrencyId>::max();
+
+        struct Pair {
+            InstrumentId instrumentId_{ };
+            CurrencyId base_{ };
+            CurrencyId quote_{ };
+            double rateScale_{ };   // 1 / ticksPerUnit
+            double ticksPerUnit_{ };
+            TopOfBook top_;
+            std::vector<std::uint32_t> cycles_;
+        };
+
+        struct Leg {
+            std::uint32_t pair_{ };
+            bool sellsBase_{ };     // Converts base into quote at the bid
+        };
+
+        struct Cycle {
+            std::array<CurrencyId, 3> currencies_{ };
+            std::array<Leg, 3> legs_{ };
+        };
+
+        static CurrencyId OtherCurrency (const Pair& pair, CurrencyId currency) {
+            return pair.base_ == currency ? pair.quote_ : pair.quote_ == currency ? pair.base_ : NoCurrency;
+        }
+
+        static bool Connects (const Pair& pair, CurrencyId first, CurrencyId second) {
+            return (pair.base_ == first && pair.quote_ == second) || (pair.base_ == second && pair.quote_ == first);
+        }
+
+        /** @brief Adds the cycle through currencies, leg i converting currencies[i] into the next one over pairs[i]. */
+        void AddCycle (const std::array<CurrencyId, 3>& currencies, const std::array<std::uint32_t, 3>& pairs) {
+            Cycle cycle{ currencies, { } };
+            for (std::size_t leg = 0; leg < 3; ++leg)
+                cycle.legs_[leg] = Leg{ pairs[leg], pairs_[pairs[leg]].base_ == currencies[leg] };
+
+            const auto index = static_cast<std::uint32_t>(cycles_.size());
+            cycles_.push_back(cycle);
+            for (const std::uint32_t pair : pairs)
+                pairs_[pair].cycles_.push_back(index);
+        }
+
+        template <typename Sink>
+        void Evaluate (std::uint32_t index, std::uint64_t timestamp, Sink& sink) const {
+            const Cycle& cycle = cycles_[index];
+
+            double amount = 1.0; // Units of the leg's input currency per unit of the start currency
+            double limit = std::numeric_limits<double>::max();
+
+            for (const Leg& leg : cycle.legs_)
+            {
+                const Pair& pair = pairs_[leg.pair_];
+                const TopOfBook& top = pair.top_;
+                double rate, input;
+
+                if (leg.sellsBase_)
+                {
+                    if (!top.HasBid())
+                        return;
+                    rate = top.bidPrice_ * pair.rateScale_;
+                    input = top.bidQuantity_;
+                }
+                else
+                {
+                    if (!top.HasAsk())
+                        return;
+                    rate = pair.ticksPerUnit_ / top.askPrice_;
+                    input = top.askQuantity_ * (top.askPrice_ * pair.rateScale_);
+                }
+
+                limit = std::min(limit, input / amount);
+                amount *= rate;
+            }
+
+            const double net = amount - 1.0;
+            if (net <= minimumReturn_)
+                return;
+
+            const auto quantity = static_cast<Quantity>(std::floor(limit));
+            if (quantity != 0)
+                sink(TriangularSignal{ index, cycle.currencies_, net, quantity, timestamp });
+        }
+
+        double minimumReturn_;
+        std::vector<Pair> pairs_;
+        std::vector<Cycle> cycles_;
+};
@@ -11,4 +11,9 @@
 using Price    = std::int32_t;
 using Quantity = std::uint32_t;
 using OrderId  = std::uint64_t;
-using OrderIds = std::vector<OrderId>;
\ No newline at end of file
+using OrderIds = std::vector<OrderId>;
+using InstrumentId = std::uint32_t;
+using Expiry   = std::uint64_t; // Nanoseconds since the Unix epoch (system clock)
+using VenueId  = std::uint32_t;
+using CurrencyId = std::uint32_t;
+using AccountId  = std::uint16_t; // Dense: accounts index flat per-book tables (see AccountRisk.h)
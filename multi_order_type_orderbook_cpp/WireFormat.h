@@ -0,0 +1,268 @@
+#pragma once
+
+/**
+ * @file WireFormat.h
+ * @brief Packed, fixed-size, little-endian encodings of commands, trades and level updates.
+ *
+ * Every message has a fixed size, so a buffer of N messages is N * Size bytes
+ * and the k-th message starts at k * Size: decoding is straight-line loads
+ * from the caller's (network or shared-memory) buffer with no heap use and no
+ * intermediate copies. Encoders write into caller buffers the same way.
+ *
+ * WireCommand (32 bytes)            WireTrade (40 bytes)
+ *   0  u8   CommandType               0  u32  instrument
+ *   1  u8   OrderType                 4  u32  reserved (0)
+ *   2  u8   Side                      8  u64  bid order id
+ *   3  u8   reserved (0)             16  i32  bid price
+ *   4  u32  instrument               20  u32  bid quantity
+ *   8  u64  order id                 24  u64  ask order id
+ *  16  i32  price                    32  i32  ask price
+ *  20  u32  quantity                 36  u32  ask quantity
+ *  24  u64  expiry (stop price or iceberg quantities, see Order)
+ *
+ * WireLevelUpdate (32 bytes)
+ *   0  u64  sequence
+ *   8  u32  instrument
+ *  12  u8   Side, then 3 reserved bytes (0)
+ *  16  i32  price
+ *  20  u32  quantity
+ *  24  u32  order count
+ *  28  u32  reserved (0)
+ *
+ * A WireCommand carries no account: the gateway that decodes it sets
+ * Command::account_ from the session the message arrived on.
+ *
+ * WirePacket (16-byte header, then count WireCommands; see MarketDataFeed.h)
+ *   0  u64  sequence of the first message
+ *   8  u32  message count
+ *  12  u32  reserved (0)
+ */
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "Command.h"
+#include "LevelUpdate.h"
+#include "Trade.h"
+
+/**
+ * @brief Unaligned little-endian loads and stores of integers.
+ *
+ * On little-endian hosts these compile to single unaligned moves.
+ */
+struct LittleEndian
+{
+    template <typename Integer>
+    static Integer Load(const unsigned char* bytes)
+    {
+        static_assert(std::is_integral_v<Integer>);
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            Integer value;
+            std::memcpy(&value, bytes, sizeof(Integer));
+            return value;
+        }
+        else
+        {
+            std::make_unsigned_t<Integer> value{ };
+            for (std::size_t index = 0; index < sizeof(Integer); ++index)
+                value |= static_cast<std::make_unsigned_t<Integer>>(bytes[index]) << (8 * index);
+            return static_cast<Integer>(value);
+        }
+    }
+
+    template <typename Integer>
+    static void Store(unsigned char* bytes, Integer value)
+    {
+        static_assert(std::is_integral_v<Integer>);
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            std::memcpy(bytes, &value, sizeof(Integer));
+        }
+        else
+        {
+            const auto bits = static_cast<std::make_unsigned_t<Integer>>(value);
+            for (std::size_t index = 0; index < sizeof(Integer); ++index)
+                bytes[index] = static_cast<unsigned char>(bits >> (8 * index));
+        }
+    }
+};
+
+/**
+ * @brief Wire encoding of a Command (Add, Cancel, Modify, PruneGoodForDay, ExpireGoodTillDate, SetAccountLimits).
+ */
+struct WireCommand
+{
+    static constexpr std::size_t Size = 32;
+
+    static void Encode(const Command& command, unsigned char* bytes)
+    {
+        bytes[0] = static_cast<unsigned char>(command.type_);
+        bytes[1] = static_cast<unsigned char>(command.orderType_);
+        bytes[2] = static_cast<unsigned char>(command.side_);
+        bytes[3] = 0;
+        LittleEndian::Store(bytes + 4, command.instrumentId_);
+        LittleEndian::Store(bytes + 8, command.orderId_);
+        LittleEndian::Store(bytes + 16, command.price_);
+        LittleEndian::Store(bytes + 20, command.quantity_);
+        LittleEndian::Store(bytes + 24, command.expiry_);
+    }
+
+    /**
+     * @brief Decodes without validation; use TryDecode for untrusted input.
+     */
+    static Command Decode(const unsigned char* bytes)
+    {
+        Command command;
+        command.type_ = static_cast<CommandType>(bytes[0]);
+        command.orderType_ = static_cast<OrderType>(bytes[1]);
+        command.side_ = static_cast<Side>(bytes[2]);
+        command.instrumentId_ = LittleEndian::Load<InstrumentId>(bytes + 4);
+        command.orderId_ = LittleEndian::Load<OrderId>(bytes + 8);
+        command.price_ = LittleEndian::Load<Price>(bytes + 16);
+        command.quantity_ = LittleEndian::Load<Quantity>(bytes + 20);
+        command.expiry_ = LittleEndian::Load<Expiry>(bytes + 24);
+        return command;
+    }
+
+    /**
+     * @brief Decodes one command after checking its enum fields.
+     * @return False (command untouched) if the bytes are too short or hold an unknown enum value.
+     */
+    static bool TryDecode(std::span<const unsigned char> bytes, Command& command)
+    {
+        if (bytes.size() < Size)
+            return false;
+
+        // One combined test instead of a branch per field
+        const bool valid = (bytes[0] <= static_cast<unsigned char>(CommandType::SetAccountLimits))
+            & (bytes[1] <= static_cast<unsigned char>(OrderType::Iceberg))
+            & (bytes[2] <= static_cast<unsigned char>(Side::Sell));
+        if (!valid)
+            return false;
+
+        command = Decode(bytes.data());
+        return true;
+    }
+
+    /**
+     * @brief Decodes consecutive commands from a buffer, stopping at the first invalid one.
+     * @return Number of commands written to commands.
+     */
+    static std::size_t DecodeBatch(std::span<const unsigned char> bytes, std::span<Command> commands)
+    {
+        std::size_t count = 0;
+        while (count < commands.size() && TryDecode(bytes.subspan(std::min(bytes.size(), count * Size)), commands[count]))
+            ++count;
+        return count;
+    }
+};
+
+/**
+ * @brief Wire encoding of a Trade, tagged with the instrument that produced it.
+ */
+struct WireTrade
+{
+    static constexpr std::size_t Size = 40;
+
+    static void Encode(const Trade& trade, InstrumentId instrumentId, unsigned char* bytes)
+    {
+        LittleEndian::Store(bytes, instrumentId);
+        LittleEndian::Store(bytes + 4, std::uint32_t{ 0 });
+        EncodeInfo(trade.GetBidTrade(), bytes + 8);
+        EncodeInfo(trade.GetAskTrade(), bytes + 24);
+    }
+
+    static Trade Decode(const unsigned char* bytes, InstrumentId& instrumentId)
+    {
+        instrumentId = LittleEndian::Load<InstrumentId>(bytes);
+        return Trade{ DecodeInfo(bytes + 8), DecodeInfo(bytes + 24) };
+    }
+
+    /** @brief TradeInfo as 16 bytes: order id, price, quantity. */
+    static void EncodeInfo(const TradeInfo& info, unsigned char* bytes)
+    {
+        LittleEndian::Store(bytes, info.orderId_);
+        LittleEndian::Store(bytes + 8, info.price_);
+        LittleEndian::Store(bytes + 12, info.quantity_);
+    }
+
+    static TradeInfo DecodeInfo(const unsigned char* bytes)
+    {
+        return TradeInfo{ LittleEndian::Load<OrderId>(bytes), LittleEndian::Load<Price>(bytes + 8), LittleEndian::Load<Quantity>(bytes + 12) };
+    }
+};
+
+/**
+ * @brief Wire encoding of a LevelUpdate, tagged with its instrument.
+ */
+struct WireLevelUpdate
+{
+    static constexpr std::size_t Size = 32;
+
+    static void Encode(const LevelUpdate& update, InstrumentId instrumentId, unsigned char* bytes)
+    {
+        LittleEndian::Store(bytes, update.sequence_);
+        LittleEndian::Store(bytes + 8, instrumentId);
+        LittleEndian::Store(bytes + 12, static_cast<std::uint32_t>(update.side_));
+        LittleEndian::Store(bytes + 16, update.price_);
+        LittleEndian::Store(bytes + 20, update.quantity_);
+        LittleEndian::Store(bytes + 24, update.orderCount_);
+        LittleEndian::Store(bytes + 28, std::uint32_t{ 0 });
+    }
+
+    static LevelUpdate Decode(const unsigned char* bytes, InstrumentId& instrumentId)
+    {
+        instrumentId = LittleEndian::Load<InstrumentId>(bytes + 8);
+
+        LevelUpdate update;
+        update.sequence_ = LittleEndian::Load<std::uint64_t>(bytes);
+        update.side_ = static_cast<Side>(bytes[12]);
+        update.price_ = LittleEndian::Load<Price>(bytes + 16);
+        update.quantity_ = LittleEndian::Load<Quantity>(bytes + 20);
+        update.orderCount_ = LittleEndian::Load<Quantity>(bytes + 24);
+        return update;
+    }
+};
+
+/**
+ * @brief Header of a sequenced market-data packet carrying WireCommands.
+ *
+ * Sequences number messages, not packets: a packet of count messages
+ * starting at sequence s is followed by one starting at s + count.
+ */
+struct WirePacket
+{
+    static constexpr std::size_t HeaderSize = 16;
+
+    static void EncodeHeader(std::uint64_t sequence, std::uint32_t count, unsigned char* bytes)
+    {
+        LittleEndian::Store(bytes, sequence);
+        LittleEndian::Store(bytes + 8, count);
+        LittleEndian::Store(bytes + 12, std::uint32_t{ 0 });
+    }
+
+    /**
+     * @brief Reads the header after checking the packet holds every message it announces.
+     * @return False (outputs untouched) if the packet is shorter than its header says.
+     */
+    static bool TryDecodeHeader(std::span<const unsigned char> bytes, std::uint64_t& sequence, std::uint32_t& count)
+    {
+        if (bytes.size() < HeaderSize)
+            return false;
+
+        const auto messages = LittleEndian::Load<std::uint32_t>(bytes.data() + 8);
+        if ((bytes.size() - HeaderSize) / WireCommand::Size < messages)
+            return false;
+
+        sequence = LittleEndian::Load<std::uint64_t>(bytes.data());
+        count = messages;
+        return true;
+    }
+};